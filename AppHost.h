@@ -0,0 +1,100 @@
+/* AppHost.h - several apps in one sketch, one running at a time
+
+   Each app is a name and three functions: setup() when it starts,
+   loop(key) over and over while it runs (key = the keypad key of this
+   pass, 0 if none), teardown() when it stops (detach servos, stop tones).
+
+     const App APPS[] PROGMEM = {
+       { "Lock",   lockSetup,   lockLoop,   lockTeardown },
+       { "Target", targetSetup, targetLoop, nullptr },
+     };
+     AppHost<160> host(APPS, 2);    // 160-byte shared arena
+
+     host.start(0);                 // stops the running app first
+     host.loop(keypad.getKey());    // every loop()
+     host.stop();                   // back to no app (menu)
+
+   RAM an app needs only while it runs comes from the arena, in setup():
+
+     LockState *lock = (LockState *)host.alloc(sizeof(LockState));  // zeroed
+
+   The arena is emptied when the app stops, so the apps share the same
+   bytes (RAM = the largest app, not the sum) and nothing one app took can
+   leak into the next. alloc() returns nullptr when the arena is too small.
+   The arena is a global: an app that goes on calling alloc() in loop()
+   leaks without moving the heap or the stack. used() above setupUsed()
+   is that leak. tests/AppHostTest.cpp switches apps on a PC.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+struct App {
+  char name[10];
+  void (*setup)();
+  void (*loop)(char key);
+  void (*teardown)();        // nullptr: nothing to undo
+};
+
+template<uint16_t ARENA>
+class AppHost {
+ public:
+  static const uint8_t NONE = 0xFF;
+
+  AppHost(const App *apps, uint8_t count)
+    : apps_(apps), count_(count), active_(NONE), used_(0), setupUsed_(0), peak_(0) {}
+
+  uint8_t count() const { return count_; }
+  uint8_t active() const { return active_; }
+
+  // Name of app i from PROGMEM, out must hold 10 chars
+  void name(uint8_t i, char *out) const { strcpy_P(out, apps_[i].name); }
+
+  void start(uint8_t i) {
+    stop();
+    if (i >= count_) return;
+    active_ = i;
+    void (*fn)() = (void (*)())pgm_read_ptr(&apps_[i].setup);
+    fn();
+    setupUsed_ = used_;
+  }
+
+  void stop() {
+    if (active_ == NONE) return;
+    void (*fn)() = (void (*)())pgm_read_ptr(&apps_[active_].teardown);
+    if (fn) fn();
+    active_ = NONE;
+    used_ = setupUsed_ = 0;    // everything the app took goes back at once
+  }
+
+  void loop(char key) {
+    if (active_ == NONE) return;
+    void (*fn)(char) = (void (*)(char))pgm_read_ptr(&apps_[active_].loop);
+    fn(key);
+  }
+
+  // Zeroed block from the arena, valid until the app stops
+  void *alloc(uint16_t n) {
+    if (n > ARENA - used_) return nullptr;
+    uint8_t *p = arena_ + used_;
+    used_ += n;
+    if (used_ > peak_) peak_ = used_;
+    memset(p, 0, n);
+    return p;
+  }
+
+  uint16_t used() const { return used_; }
+  uint16_t setupUsed() const { return setupUsed_; }   // taken by the running app's setup()
+  uint16_t peak() const { return peak_; }   // most any app has taken
+  uint16_t size() const { return ARENA; }
+
+ private:
+  const App *apps_;
+  uint8_t count_;
+  uint8_t active_;
+  uint16_t used_, setupUsed_, peak_;
+  uint8_t arena_[ARENA];
+};
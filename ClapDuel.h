@@ -0,0 +1,96 @@
+/* ClapDuel.h - who clapped first: edge timestamps and the round's verdict
+
+   DuelRound::edge() is the whole INT0/INT1 handler of the Clap Duel game.
+   It keeps the first edge of each player after arm(), stamped with the
+   time read first thing in the ISR, and drops the ringing edges after
+   it. When the other player's interrupt flag is already up, that edge
+   came within this ISR's latency (a few us): the two cannot be ordered,
+   and the round is a tie. loop() checks falseStart() while it waits for
+   the cue, then takes the cue time and asks judge():
+
+     DuelRound duel;
+     void onP1() { duel.edge(0, ticksNow(), EIFR & _BV(INTF1)); }
+     void onP2() { duel.edge(1, ticksNow(), EIFR & _BV(INTF0)); }
+
+   duelTicks() makes the 32-bit time from Timer1 and its overflow count,
+   also when the timer wrapped and the overflow ISR has not run yet.
+   tests/ClapDuelTest.cpp injects edge timings on a PC: order, ties,
+   false starts, ringing and timer wrap.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+enum Outcome { P1_WINS, P2_WINS, TIE, NOBODY };
+
+// tcnt and overflows read with interrupts off, tov = the overflow flag
+inline uint32_t duelTicks(uint16_t tcnt, uint16_t overflows, bool tov) {
+  if (tov && tcnt < 0x8000) overflows++;   // wrapped, overflow ISR not run yet
+  return ((uint32_t)overflows << 16) | tcnt;
+}
+
+struct DuelVerdict {
+  Outcome outcome;
+  int8_t falseStart;          // -1 none, 0 P1, 1 P2, 2 both
+  uint32_t ticks[2];          // reaction per player from the cue, 0 = no clap
+};
+
+struct DuelRound {
+  volatile bool armed[2];     // waiting for this player's first edge
+  volatile uint32_t edgeTicks[2];
+  volatile bool edgeSeen[2];
+  volatile bool sameInstant;  // both flags were up when one ISR ran
+
+  // Call with interrupts off
+  void arm() {
+    for (uint8_t p = 0; p < 2; p++) { armed[p] = true; edgeSeen[p] = false; }
+    sameInstant = false;
+  }
+
+  void stop() { armed[0] = armed[1] = false; }
+
+  // First edge of player p at time t; otherPending = the other INTx flag
+  void edge(uint8_t p, uint32_t t, bool otherPending) {
+    if (!armed[p]) return;            // later edges of the same clap ring
+    armed[p] = false;
+    edgeTicks[p] = t;
+    edgeSeen[p] = true;
+    if (otherPending && armed[1 - p]) sameInstant = true;
+  }
+
+  // While waiting for the cue: -1 nobody clapped yet, 0 P1, 1 P2, 2 both
+  // (call with interrupts off)
+  int8_t falseStart() const {
+    if (!edgeSeen[0] && !edgeSeen[1]) return -1;
+    if (sameInstant || (edgeSeen[0] && edgeSeen[1])) return 2;
+    return edgeSeen[0] ? 0 : 1;
+  }
+
+  // After the round (stop() first). An edge stamped before the cue, after
+  // loop() last looked, is still a false start; so is the other player's
+  // when the two came at the same instant.
+  DuelVerdict judge(uint32_t cue) const {
+    DuelVerdict v = { NOBODY, -1, { 0, 0 } };
+    bool seen0 = edgeSeen[0], seen1 = edgeSeen[1];
+    uint32_t t0 = edgeTicks[0], t1 = edgeTicks[1];
+    bool early0 = seen0 && (int32_t)(t0 - cue) < 0;
+    bool early1 = seen1 && (int32_t)(t1 - cue) < 0;
+    if (sameInstant && (early0 || early1)) early0 = early1 = true;   // the late stamp only waited for the ISR
+    if (early0 || early1) {
+      v.falseStart = early0 && early1 ? 2 : (early0 ? 0 : 1);
+      v.outcome = v.falseStart == 2 ? NOBODY : (v.falseStart == 0 ? P2_WINS : P1_WINS);
+      return v;
+    }
+    if (seen0) v.ticks[0] = t0 - cue;
+    if (seen1) v.ticks[1] = t1 - cue;
+    if (!seen0 && !seen1) v.outcome = NOBODY;
+    else if (!seen1) v.outcome = P1_WINS;
+    else if (!seen0) v.outcome = P2_WINS;
+    else if (sameInstant || t0 == t1) v.outcome = TIE;
+    else v.outcome = (int32_t)(t0 - t1) < 0 ? P1_WINS : P2_WINS;
+    return v;
+  }
+};
@@ -0,0 +1,424 @@
+/* InputTrace.h - record a run's inputs, replay them exactly
+
+   Bugs that depend on timing ("* pressed during the beep", "clap while the
+   result is shown") are hard to repeat by hand. InputTrace sits between
+   the sketch and its inputs and clock:
+
+     char k = trace.key(keypad.getKey());             // keypad
+     int s = trace.level(0, digitalRead(SOUND_PIN));  // polled pin
+     int v = trace.analog(0, analogRead(A0), 8);      // ADC, changes of 8+
+     trace.edge(0, trace.micros());                   // edge an interrupt handler kept
+     trace.millis(); trace.micros(); trace.delay(ms); // instead of the real ones
+     trace.sync();                                    // after slow drawing, see below
+
+   Live (the default) everything passes straight through. Serial commands,
+   handed over with trace.command(c):
+
+     R  reset and record: every input event from boot on is stored in
+        EEPROM and printed as  #E <us> <K|L|A|E|M> <id> <value>
+     P  reset and replay the stored trace instead of the real inputs
+     D  print the stored trace
+
+   While recording or replaying, trace.state(F("name")) prints
+   "#S <us> name". Compare the #S lines of a replay with those of the
+   recording (or of an older replay, after a code change) to see where the
+   run went differently.
+
+   Replay uses a virtual clock: it moves 1 ms per loop() pass (poll()) and
+   jumps over trace.delay() at once, so it runs much faster than real time
+   and the same trace always gives the same run. Events are handed over at
+   their recorded time; interrupt edges also arrive during delay(), like
+   the real interrupt would, with micros() equal to their timestamp. A key,
+   level or ADC change waits until the sketch has read the one before, so
+   replay sees every value the recorded run saw, however short.
+   Drawing a screen takes real time that the virtual clock does not see:
+   when a pass has run TRACE_MARK_US or more by the time it calls delay(),
+   the recording stores a mark with the delay's number and start, and
+   replay starts that delay there too. A round timed from after the delay
+   starts at the recorded time, not a draw earlier. Where slow work is not
+   followed by a delay() (the splash screen before the first round), call
+   trace.sync() after it: a delay(0) that only does that.
+   random() is seeded from the trace too (begin()). poll() returns true
+   once when the trace is over (plus TRACE_TAIL_MS for timeouts to run
+   out): print a fingerprint of the screen there, e.g. traceCrc().
+
+   Each event takes 8 bytes of EEPROM (about 120 in the Uno's 1 KB) and,
+   while recording, up to ~30 ms of EEPROM writing in poll() or delay().
+   Times are 32-bit microseconds: traces up to 70 minutes. Settings the
+   sketch keeps in EEPROM are not in the trace: while recording or
+   replaying (!live()) it should leave them alone, or the replay starts
+   from what the recorded run saved.
+
+   The R and P resets use the watchdog, which stays on after the reset
+   with its shortest timeout; the .init3 hook below turns it off before
+   setup() runs, however long the sketch takes to get to begin().
+   tests/InputTraceTest.cpp records and replays thousands of made-up
+   runs of the Target Game and the lock on a PC.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <avr/wdt.h>
+#include <util/crc16.h>
+
+const unsigned long TRACE_TAIL_MS = 10000;   // replay goes on this long after the last event
+const unsigned long TRACE_MARK_US = 1000;    // a pass this long before delay() marks the delay
+const uint8_t TRACE_MAGIC = 0x7E;
+const uint8_t TRACE_IDS = 2;                 // ids 0 and 1 per kind
+const uint8_t TRACE_RING = 4;                // events waiting for poll() while recording
+
+#ifdef __AVR__
+// Before main(): no watchdog reset loop after command()'s reset
+static void traceWatchdogOff() __attribute__((naked, used, section(".init3")));
+static void traceWatchdogOff() {
+  MCUSR = 0;
+  wdt_disable();
+}
+#endif
+
+enum TraceKind : uint8_t { TRACE_KEY = 'K', TRACE_LEVEL = 'L', TRACE_ANALOG = 'A', TRACE_EDGE = 'E', TRACE_MARK = 'M' };
+
+struct TraceEvent {
+  uint32_t us;       // since begin()
+  uint8_t kind;
+  uint8_t id;
+  uint16_t value;
+};
+
+// CRC-16 (CCITT) of a buffer, e.g. the framebuffer at the end of a replay
+inline uint16_t traceCrc(const uint8_t *p, uint16_t n, uint16_t crc = 0xFFFF) {
+  while (n--) crc = _crc_ccitt_update(crc, *p++);
+  return crc;
+}
+
+class InputTrace {
+ public:
+  enum Mode : uint8_t { LIVE, RECORD, REPLAY };
+
+  // The trace is kept in EEPROM from addr to the end
+  InputTrace(int addr)
+    : addr_(addr), mode_(LIVE), count_(0), next_(0), startUs_(0), now_(0),
+      lastUs_(0), passUs_(0), syncs_(0), key_(0), unread_(0), head_(0), tail_(0), lost_(0), done_(false) {
+    for (uint8_t i = 0; i < TRACE_IDS; i++) {
+      level_[i] = LOW;
+      analog_[i] = 0;
+      edgeFn_[i] = nullptr;
+    }
+  }
+
+  // Early in setup(), after Serial.begin(). Returns the seed for randomSeed():
+  // liveSeed when live or recording, the recorded one when replaying.
+  uint32_t begin(uint32_t liveSeed) {
+    Header h;
+    EEPROM.get(addr_, h);
+    if (h.magic != TRACE_MAGIC) h = Header{ TRACE_MAGIC, LIVE, 0, 0 };
+    mode_ = (Mode)h.arm;
+    if (mode_ == RECORD) {
+      h.count = 0;
+      h.seed = liveSeed;
+    }
+    count_ = h.count;
+    h.arm = LIVE;                    // one run only, the next reset is live again
+    EEPROM.put(addr_, h);
+    startUs_ = passUs_ = ::micros();
+    if (mode_ == LIVE) return liveSeed;
+
+    Serial.print(mode_ == RECORD ? F("#TRACE record seed=") : F("#TRACE replay seed="));
+    Serial.print(h.seed);
+    Serial.print(F(" events="));
+    Serial.println(count_);
+    if (mode_ == REPLAY) load();
+    return h.seed;
+  }
+
+  // Start of every loop(): recorded events go to EEPROM and Serial, the
+  // replay clock moves 1 ms. true once, when a replay is over.
+  bool poll() {
+    if (mode_ == RECORD) {
+      flush();
+      passUs_ = ::micros();
+    }
+    if (mode_ != REPLAY || done_) return false;
+    advance(now_ + 1000UL);
+    if (next_ < count_ || now_ - lastUs_ < TRACE_TAIL_MS * 1000UL) return false;
+    done_ = true;
+    Serial.print(F("#END "));
+    Serial.println(now_);
+    return true;
+  }
+
+  bool replaying() const { return mode_ == REPLAY; }
+  bool live() const { return mode_ == LIVE; }
+
+  unsigned long micros() {
+    if (mode_ == REPLAY) return now_;
+    if (mode_ == RECORD) return ::micros() - startUs_;
+    return ::micros();
+  }
+
+  unsigned long millis() {
+    return mode_ == LIVE ? ::millis() : micros() / 1000UL;
+  }
+
+  void delay(unsigned long ms) {
+    if (mode_ == REPLAY) {
+      toMark();
+      advance(now_ + ms * 1000UL);
+    } else if (mode_ == RECORD) {    // interrupts go on pushing: keep the ring empty
+      mark();
+      unsigned long start = ::millis();
+      do {
+        flush();
+        ::delay(1);
+      } while (::millis() - start < ms);
+      passUs_ = ::micros();
+    } else {
+      ::delay(ms);
+    }
+    syncs_++;
+  }
+
+  // After slow work that no delay() follows
+  void sync() {
+    if (mode_ == REPLAY) toMark();
+    else if (mode_ == RECORD) mark();
+    syncs_++;
+  }
+
+  // Keypad: pass getKey() through
+  char key(char live) {
+    if (mode_ == REPLAY) {
+      char k = key_;
+      key_ = 0;
+      return k;
+    }
+    if (mode_ == RECORD && live) push(TRACE_KEY, 0, (uint8_t)live, ::micros() - startUs_);
+    return live;
+  }
+
+  // Polled digital input: changes are recorded
+  uint8_t level(uint8_t id, uint8_t live) {
+    if (mode_ == REPLAY) {
+      unread_ &= ~(1 << id);
+      return level_[id];
+    }
+    if (mode_ == RECORD && live != level_[id]) {
+      level_[id] = live;
+      push(TRACE_LEVEL, id, live, ::micros() - startUs_);
+    }
+    return live;
+  }
+
+  // ADC reading: changes of at least deadband counts are recorded
+  uint16_t analog(uint8_t id, uint16_t live, uint16_t deadband) {
+    if (mode_ == REPLAY) {
+      unread_ &= ~(1 << (TRACE_IDS + id));
+      return analog_[id];
+    }
+    if (mode_ == RECORD) {
+      uint16_t d = live > analog_[id] ? live - analog_[id] : analog_[id] - live;
+      if (d >= deadband) {
+        analog_[id] = live;
+        push(TRACE_ANALOG, id, live, ::micros() - startUs_);
+      }
+      return analog_[id];            // replay sees the same steps
+    }
+    return live;
+  }
+
+  // Call in an interrupt handler for every edge it keeps (after its own
+  // debounce or refractory test), with the time it took from micros():
+  // replay calls fn with micros() at exactly that time
+  void edge(uint8_t id, uint32_t us) {
+    if (mode_ == RECORD) push(TRACE_EDGE, id, 0, us);
+  }
+  void onEdge(uint8_t id, void (*fn)()) { edgeFn_[id] = fn; }
+
+  // "#S <us> name [value]" while recording or replaying
+  void state(const __FlashStringHelper *name) {
+    if (mode_ == LIVE) return;
+    Serial.print(F("#S "));
+    Serial.print(micros());
+    Serial.print(' ');
+    Serial.println(name);
+  }
+  void state(const __FlashStringHelper *name, long value) {
+    if (mode_ == LIVE) return;
+    Serial.print(F("#S "));
+    Serial.print(micros());
+    Serial.print(' ');
+    Serial.print(name);
+    Serial.print(' ');
+    Serial.println(value);
+  }
+
+  // R / P (never return: reset) or D; false for other characters
+  bool command(char c) {
+    if (c == 'D') {
+      dump();
+      return true;
+    }
+    if (c != 'R' && c != 'P') return false;
+    Header h;
+    EEPROM.get(addr_, h);
+    if (h.magic != TRACE_MAGIC) h = Header{ TRACE_MAGIC, LIVE, 0, 0 };
+    h.arm = c == 'R' ? RECORD : REPLAY;
+    EEPROM.put(addr_, h);
+    Serial.println(c == 'R' ? F("#TRACE reset to record") : F("#TRACE reset to replay"));
+    Serial.flush();
+    wdt_enable(WDTO_15MS);
+    for (;;) {}
+  }
+
+  void dump() {
+    Header h;
+    EEPROM.get(addr_, h);
+    if (h.magic != TRACE_MAGIC) h.count = h.seed = 0;
+    Serial.print(F("#TRACE seed="));
+    Serial.print(h.seed);
+    Serial.print(F(" events="));
+    Serial.println(h.count);
+    for (uint16_t i = 0; i < h.count; i++) {
+      TraceEvent e;
+      EEPROM.get(eventAddr(i), e);
+      print(e);
+    }
+  }
+
+ private:
+  struct Header {
+    uint8_t magic;
+    uint8_t arm;       // mode for the next boot
+    uint16_t count;
+    uint32_t seed;
+  };
+
+  int eventAddr(uint16_t i) const { return addr_ + sizeof(Header) + i * sizeof(TraceEvent); }
+  uint16_t capacity() const { return (E2END + 1 - addr_ - sizeof(Header)) / sizeof(TraceEvent); }
+
+  // Recording; also called from interrupt handlers
+  void push(uint8_t kind, uint8_t id, uint16_t value, uint32_t us) {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t next = (head_ + 1) & (TRACE_RING - 1);
+    if (next == tail_) {
+      lost_++;
+    } else {
+      TraceEvent &e = ring_[head_];
+      e.us = us;
+      e.kind = kind;
+      e.id = id;
+      e.value = value;
+      head_ = next;
+    }
+    SREG = sreg;
+  }
+
+  void flush() {
+    while (tail_ != head_) {
+      TraceEvent e = ring_[tail_];
+      tail_ = (tail_ + 1) & (TRACE_RING - 1);
+      if (count_ < capacity()) {
+        EEPROM.put(eventAddr(count_), e);
+        count_++;
+        EEPROM.put(addr_ + offsetof(Header, count), count_);
+        print(e);
+      } else if (count_ == capacity()) {
+        count_++;                    // report once
+        Serial.println(F("#FULL"));
+      }
+    }
+    if (lost_) {
+      Serial.print(F("#LOST "));
+      Serial.println(lost_);
+      lost_ = 0;
+    }
+  }
+
+  void print(const TraceEvent &e) {
+    Serial.print(F("#E "));
+    Serial.print(e.us);
+    Serial.print(' ');
+    Serial.print((char)e.kind);
+    Serial.print(' ');
+    Serial.print(e.id);
+    Serial.print(' ');
+    Serial.println(e.value);
+  }
+
+  // Recording, delay() or sync(): the pass has taken long, store where it is
+  void mark() {
+    uint32_t now = ::micros();
+    if (now - passUs_ >= TRACE_MARK_US) push(TRACE_MARK, 0, syncs_, now - startUs_);
+    passUs_ = now;
+  }
+
+  void load() {
+    if (next_ < count_) EEPROM.get(eventAddr(next_), ev_);
+  }
+
+  // Replay: hand over the events up to target, then set the clock to it.
+  // A second key waits until key() has taken the first, a level or ADC
+  // change until the one before was read, a mark until its delay() or
+  // sync() (a mark whose call has passed is dropped: the replay went
+  // another way).
+  void advance(uint32_t target) {
+    while (next_ < count_ && (int32_t)(ev_.us - target) <= 0) {
+      if (ev_.kind == TRACE_MARK && (int16_t)(ev_.value - syncs_) >= 0) break;
+      uint8_t id = ev_.id < TRACE_IDS ? ev_.id : 0;
+      uint8_t bit = ev_.kind == TRACE_LEVEL ? 1 << id : ev_.kind == TRACE_ANALOG ? 1 << (TRACE_IDS + id) : 0;
+      if ((ev_.kind == TRACE_KEY && key_) || (unread_ & bit)) break;
+      if ((int32_t)(ev_.us - now_) > 0) now_ = ev_.us;
+      lastUs_ = ev_.us;
+      unread_ |= bit;
+      if (ev_.kind == TRACE_KEY) key_ = (char)ev_.value;
+      else if (ev_.kind == TRACE_LEVEL) level_[id] = ev_.value;
+      else if (ev_.kind == TRACE_ANALOG) analog_[id] = ev_.value;
+      else if (ev_.kind == TRACE_EDGE && edgeFn_[id]) edgeFn_[id]();
+      next_++;
+      load();
+    }
+    if ((int32_t)(target - now_) > 0) now_ = target;
+  }
+
+  // Replay, delay() or sync(): when the recorded call has a mark, hand
+  // over what came before it and go on from its time
+  void toMark() {
+    for (uint16_t i = next_; i < count_; i++) {
+      TraceEvent e;
+      EEPROM.get(eventAddr(i), e);
+      if (e.kind != TRACE_MARK) continue;
+      if (e.value != syncs_) return;
+      advance(e.us);                 // stops at the mark
+      if (next_ != i) return;        // a key or level not read yet
+      lastUs_ = e.us;
+      next_++;
+      load();
+      return;
+    }
+  }
+
+  int addr_;
+  Mode mode_;
+  uint16_t count_;             // events stored (recording) / in the trace (replay)
+  uint16_t next_;              // replay: next event, cached in ev_
+  TraceEvent ev_;
+  uint32_t startUs_;
+  uint32_t now_;               // replay clock
+  uint32_t lastUs_;            // replay: time of the last event handed over
+  uint32_t passUs_;            // recording: end of the last poll() or delay()
+  uint16_t syncs_;             // delay() and sync() calls since begin(), the number in a mark
+  char key_;
+  uint8_t unread_;             // replay: level (bit id) / ADC (bit 2 + id) changes not read yet
+  uint8_t level_[TRACE_IDS];
+  uint16_t analog_[TRACE_IDS];
+  void (*edgeFn_[TRACE_IDS])();
+  TraceEvent ring_[TRACE_RING];
+  volatile uint8_t head_, tail_;
+  volatile uint8_t lost_;      // ring full while recording
+  bool done_;
+};
@@ -23,6 +23,7 @@
 #include <Keypad.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include "OledWidgets.h"
 
 // ---------- OLED setup ----------
 #define SCREEN_WIDTH 128
@@ -51,6 +52,11 @@ const int BUZZER_PIN = 10;  // digital pin connected to buzzer
 // ---------- App state ----------
 char lastKey = 0; // stores last pressed key
 
+// Screen widgets: the label is drawn once, the key only when it changes
+const char KEY_TEXT[] PROGMEM = "Last Key:";
+LabelWidget keyLabel(0, 0, 1, KEY_TEXT, true);
+TextWidget keyValue(28, 18, 36, 6);   // one character at size 6 (36 x 48 px)
+
 void setup() {
   Serial.begin(9600);
 
@@ -68,11 +74,12 @@ void setup() {
   // Show startup message
   display.setTextSize(1);
   display.setCursor(0, 0);
-  display.println("4x4 Keypad + Beep");
+  display.println(F("4x4 Keypad + Beep"));
   display.setCursor(0, 18);
-  display.println("Press any key...");
+  display.println(F("Press any key..."));
   display.display();
   delay(800);
+  widgetClear(display);
 
   showLastKey();
 }
@@ -81,7 +88,7 @@ void loop() {
   char k = keypad.getKey();
   if (k) {
     lastKey = k;
-    Serial.print("Key pressed: ");
+    Serial.print(F("Key pressed: "));
     Serial.println(k);
 
     beep();          // make beep sound
@@ -89,23 +96,12 @@ void loop() {
   }
 }
 
-// Draw the last pressed key on OLED
+// Draw the last pressed key on OLED; the same key again sends nothing
 void showLastKey() {
-  display.clearDisplay();
-
-  display.setTextSize(1);
-  display.setCursor(0, 0);
-  display.println("Last Key:");
-
-  display.setTextSize(6);
-  display.setCursor(28, 18);
-  if (lastKey != 0) {
-    display.print(lastKey);
-  } else {
-    display.print("-");
-  }
-
-  display.display();
+  char text[2] = { lastKey != 0 ? lastKey : '-', '\0' };
+  bool changed = keyLabel.draw(display);
+  changed |= keyValue.set(display, text);
+  if (changed) display.display();
 }
 
 // Play a short beep on buzzer
@@ -0,0 +1,109 @@
+/* LessonStats.h - L10/L50/L90 of a whole lesson in constant memory
+
+   Once a second the sketch counts the sound level (centi-dB, 1/100 dB)
+   in a histogram of 0.5 dB bins, from 30 dB and below to 109.5 dB and
+   above. Lx = the level exceeded x% of the time, read from the histogram
+   when asked for:
+
+     LessonStats<SavedBins> stats;
+     stats.clear();
+     if (stats.add(7350)) stats.flush();     // 73.5 dB, once a second
+     int16_t l10 = stats.level(10);          // bin centre, centi-dB
+     uint32_t loud = stats.secondsFrom(7000); // seconds at 70 dB or more
+
+   The totals are 16-bit (18 hours in one bin) and live in Saved, which
+   the sketch keeps in EEPROM:
+
+     struct SavedBins {
+       uint16_t get(uint8_t bin) const;
+       void set(uint8_t bin, uint16_t count) const;
+     };
+
+   RAM only holds the seconds of each bin since the last flush(), 8-bit:
+   160 bytes for any lesson length. add() returns true when one of them
+   is full (255 s at one level); flush() before the next add(). Call it
+   every few minutes anyway, so a reset loses no more than that. A total
+   that would pass 65535 halves all of them (rounding up), after which
+   the newer seconds count double; the lesson length is counted apart in
+   `seconds` and never halved. Plain integer code: tests/LessonStatsTest.cpp
+   checks it against an exact sort of long recordings.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+const int16_t STATS_MIN_CDB = 3000;        // bin 0 = 30 dB and below
+const uint8_t STATS_BIN_CDB = 50;          // 0.5 dB
+const uint8_t STATS_BINS = 160;            // top bin = 109.5 dB and above
+
+template <class Saved>
+struct LessonStats {
+  Saved saved;
+  uint32_t seconds;                        // seconds counted (never halved)
+  uint8_t fresh[STATS_BINS];               // per bin, since the last flush()
+
+  void clear() {
+    seconds = 0;
+    memset(fresh, 0, sizeof(fresh));
+    for (uint8_t i = 0; i < STATS_BINS; i++) saved.set(i, 0);
+  }
+
+  static uint8_t binOf(int16_t cdb) {
+    int16_t b = (cdb - STATS_MIN_CDB) / STATS_BIN_CDB;
+    if (b < 0) b = 0;
+    if (b >= STATS_BINS) b = STATS_BINS - 1;
+    return b;
+  }
+
+  // true = a bin is full, flush() before the next add()
+  bool add(int16_t cdb) {
+    uint8_t b = binOf(cdb);
+    if (fresh[b] < 0xFF) fresh[b]++;
+    seconds++;
+    return fresh[b] == 0xFF;
+  }
+
+  void flush() {
+    bool halve = false;
+    for (uint8_t i = 0; i < STATS_BINS; i++) {
+      if (fresh[i] && (uint32_t)saved.get(i) + fresh[i] > 0xFFFF) halve = true;
+    }
+    for (uint8_t i = 0; i < STATS_BINS; i++) {
+      uint32_t n = saved.get(i);
+      if (halve) n = (n + 1) >> 1;
+      n += halve ? (fresh[i] + 1) >> 1 : fresh[i];
+      if (halve || fresh[i]) saved.set(i, n);
+      fresh[i] = 0;
+    }
+  }
+
+  uint32_t bin(uint8_t i) const { return (uint32_t)saved.get(i) + fresh[i]; }
+
+  uint32_t count(uint8_t fromBin) const {
+    uint32_t n = 0;
+    for (uint8_t i = fromBin; i < STATS_BINS; i++) n += bin(i);
+    return n;
+  }
+
+  // Level exceeded pct % of the time (bin centre, centi-dB); walks down
+  // from the loudest bin until pct % of all counts are at or above it
+  int16_t level(uint8_t pct) const {
+    uint32_t want = (count(0) * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (int16_t b = STATS_BINS - 1; b > 0; b--) {
+      seen += bin(b);
+      if (seen >= want) return STATS_MIN_CDB + b * STATS_BIN_CDB + STATS_BIN_CDB / 2;
+    }
+    return STATS_MIN_CDB + STATS_BIN_CDB / 2;
+  }
+
+  // Seconds in the bins from cdb up (their share of the real duration)
+  uint32_t secondsFrom(int16_t cdb) const {
+    uint32_t total = count(0);
+    if (total == 0) return 0;
+    return (uint64_t)count(binOf(cdb)) * seconds / total;
+  }
+};
@@ -0,0 +1,159 @@
+/* LevelMath.h - integer dB, bar and time-weighting tables for a sound meter
+
+   Everything the per-chunk and per-frame code of the Decibel Meter needs
+   without float math: the compiler builds the PROGMEM tables below from
+   constexpr helpers, none of the log/exp math runs on the board.
+
+     typedef MeterScale<6, 30, 120, 116, 70> Scale;   // log table + bar table
+     int16_t cdb = log10Cdb<Scale>(msQ8);              // 10*log10(msQ8), centi-dB
+
+     typedef DecayTable<5000, 125> Fast;                // tau 125 ms at 5 kHz
+     level = levelStep(level, msQ8, decayFactor(Fast::data, n));
+
+     uint16_t r = isqrt32(v);                          // floor(sqrt(v))
+
+   log10Cdb() takes whole 3.0103 dB steps from the position of the leading
+   one and the next LOG_BITS bits from a mantissa table (taken at the bin
+   centre, so LOG_BITS = 6 is within 0.05 dB). A DecayTable holds
+   exp(-2^k / (tau * rate)) in Q16 for k = 0..15; decayFactor() multiplies
+   the entries of the set bits of n, so a chunk of any length is stepped in
+   one go: y = x + (y - x) * exp(-n / (tau * rate)).
+
+   tests/LevelMathTest.cpp checks the tables against log10() and exp() on
+   a PC.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+constexpr double LN2 = 0.6931471805599453;
+constexpr double LN10 = 2.302585092994046;
+
+// ln(m): atanh series for 1 <= m < 2, halving m above that
+constexpr double lnSeries(double y, double y2, int k) {
+  return k > 10 ? 0.0 : y / (2 * k + 1) + lnSeries(y * y2, y2, k + 1);
+}
+constexpr double lnConst(double m) {
+  return m >= 2.0 ? LN2 + lnConst(m / 2.0)
+                  : 2.0 * lnSeries((m - 1.0) / (m + 1.0), ((m - 1.0) / (m + 1.0)) * ((m - 1.0) / (m + 1.0)), 0);
+}
+constexpr double log10Const(double m) { return lnConst(m) / LN10; }
+
+// exp(-x) for x >= 0: Taylor series below 1/4, squaring above that
+constexpr double expSeries(double x, double term, int k) {
+  return k > 16 ? 0.0 : term + expSeries(x, term * -x / (k + 1), k + 1);
+}
+constexpr double expNegConst(double x) {
+  return x > 0.25 ? expNegConst(x / 2) * expNegConst(x / 2) : expSeries(x, 1.0, 0);
+}
+
+// 10*log10(1.mantissa) in centi-dB, taken at the centre of each mantissa bin
+constexpr uint16_t mantissaCdb(uint16_t i, uint8_t bits) {
+  return (uint16_t)(1000.0 * log10Const(1.0 + (i + 0.5) / (double)(1UL << bits)) + 0.5);
+}
+
+template<uint8_t BITS, uint16_t N, uint16_t... V>
+struct MantissaTable : MantissaTable<BITS, N - 1, mantissaCdb(N - 1, BITS), V...> {};
+template<uint8_t BITS, uint16_t... V>
+struct MantissaTable<BITS, 0, V...> { static const uint16_t data[sizeof...(V)]; };
+template<uint8_t BITS, uint16_t... V>
+const uint16_t MantissaTable<BITS, 0, V...>::data[sizeof...(V)] PROGMEM = { V... };
+
+// Bar cell for a whole dB value: low 7 bits = fill width, bit 7 = loud face
+constexpr uint8_t barCell(int db, int minDb, int maxDb, uint8_t barW, int loudDb) {
+  return (uint8_t)(((db - minDb) * barW / (maxDb - minDb)) | (db >= loudDb ? 0x80 : 0));
+}
+
+template<int MIN_DB, int MAX_DB, uint8_t BAR_W, int LOUD_DB, uint16_t N, uint8_t... V>
+struct BarTable : BarTable<MIN_DB, MAX_DB, BAR_W, LOUD_DB, N - 1,
+                           barCell(MIN_DB + N - 1, MIN_DB, MAX_DB, BAR_W, LOUD_DB), V...> {};
+template<int MIN_DB, int MAX_DB, uint8_t BAR_W, int LOUD_DB, uint8_t... V>
+struct BarTable<MIN_DB, MAX_DB, BAR_W, LOUD_DB, 0, V...> { static const uint8_t data[sizeof...(V)]; };
+template<int MIN_DB, int MAX_DB, uint8_t BAR_W, int LOUD_DB, uint8_t... V>
+const uint8_t BarTable<MIN_DB, MAX_DB, BAR_W, LOUD_DB, 0, V...>::data[sizeof...(V)] PROGMEM = { V... };
+
+// Meter metadata - change the numbers in the typedef to retune the meter.
+//   LOG_BITS : mantissa bits of the mean-square -> dB table (2^LOG_BITS entries)
+//   MIN/MAX  : SPL range covered by the bar, BAR_W its width in pixels
+//   LOUD_DB  : SPL from which the face turns angry
+template<uint8_t LOG_BITS, int MIN_DB, int MAX_DB, uint8_t BAR_W, int LOUD_DB>
+struct MeterScale {
+  static_assert(LOG_BITS >= 2 && LOG_BITS <= 8, "LOG_BITS out of range");
+  static_assert(MAX_DB > MIN_DB && BAR_W < 128, "bad bar range");
+  static const uint8_t logBits = LOG_BITS;
+  static const int minDb = MIN_DB;
+  static const int maxDb = MAX_DB;
+  static const uint8_t barW = BAR_W;
+  static const int loudDb = LOUD_DB;
+  typedef MantissaTable<LOG_BITS, (1 << LOG_BITS)> Log;
+  typedef BarTable<MIN_DB, MAX_DB, BAR_W, LOUD_DB, MAX_DB - MIN_DB + 1> Bar;
+};
+
+// 10*log10(v) in centi-dB (v = 0 counts as 1)
+template<class S>
+int16_t log10Cdb(uint32_t v) {
+  if (v == 0) v = 1;
+  int8_t e = 31;
+  while (!(v & 0xFF000000UL)) { v <<= 8; e -= 8; }
+  while (!(v & 0x80000000UL)) { v <<= 1; e--; }
+  uint8_t m = (uint8_t)(v >> (31 - S::logBits)) & ((1 << S::logBits) - 1);
+  return (int16_t)((e * 30103L) / 100) + (int16_t)pgm_read_word(&S::Log::data[m]);
+}
+
+// exp(-2^k / (tau * rate)) in Q16 (65536 = 1.0), k = 0..15. The factors
+// are all below 1, so they fit 16 bits as long as tau * rate < 2^31.
+const uint8_t DECAY_STEPS = 16;
+
+constexpr uint16_t decayQ16(uint8_t k, uint32_t rate, uint16_t tauMs) {
+  return (uint16_t)(65536.0 * expNegConst((double)(1UL << k) * 1000.0 / ((double)tauMs * rate)) + 0.5);
+}
+
+template<uint32_t RATE, uint16_t TAU_MS, uint8_t N = DECAY_STEPS, uint16_t... V>
+struct DecayTable : DecayTable<RATE, TAU_MS, N - 1, decayQ16(N - 1, RATE, TAU_MS), V...> {};
+template<uint32_t RATE, uint16_t TAU_MS, uint16_t... V>
+struct DecayTable<RATE, TAU_MS, 0, V...> { static const uint16_t data[sizeof...(V)]; };
+template<uint32_t RATE, uint16_t TAU_MS, uint16_t... V>
+const uint16_t DecayTable<RATE, TAU_MS, 0, V...>::data[sizeof...(V)] PROGMEM = { V... };
+
+// y * q / 65536, rounded, with two 16x16 multiplies
+inline uint32_t mulQ16(uint32_t y, uint16_t q) {
+  return (uint32_t)(uint16_t)(y >> 16) * q + (((uint32_t)(uint16_t)y * q + 0x8000) >> 16);
+}
+
+// exp(-n / (tau * rate)) in Q16 from a PROGMEM DecayTable (n = 0 gives 65535)
+inline uint16_t decayFactor(const uint16_t *table, uint16_t n) {
+  uint8_t k = 0;
+  if (!n) return 0xFFFF;
+  while (!(n & 1)) { n >>= 1; k++; }
+  uint16_t d = pgm_read_word(&table[k]);
+  while (n >>= 1) {
+    k++;
+    if (n & 1) d = mulQ16(d, pgm_read_word(&table[k]));
+  }
+  return d;
+}
+
+// One exponential step towards x: y = x + (y - x) * d
+inline uint32_t levelStep(uint32_t y, uint32_t x, uint16_t d) {
+  return y >= x ? x + mulQ16(y - x, d) : x - mulQ16(x - y, d);
+}
+
+// floor(sqrt(v)), bit by bit
+inline uint16_t isqrt32(uint32_t v) {
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > v) bit >>= 2;
+  while (bit) {
+    if (v >= root + bit) {
+      v -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint16_t)root;
+}
@@ -0,0 +1,182 @@
+/* LoopProfiler.h - per-stage timing of loop(): min / p99 / max + histogram
+
+   PROF_BEGIN(stage) / PROF_END(stage) time one named stage of loop().
+   PROF_END only stores the raw duration in the stage's slot and sets a
+   bit; PROF_FOLD() (once per loop pass, outside the timed stages) puts the
+   fresh slots into min/max/count and a log2 histogram. So each stage may
+   end once per loop pass; a second PROF_END of the same stage before the
+   next PROF_FOLD() overwrites the first.
+
+     #define PROFILE_ENABLED 1
+     enum ProfStage { PROF_SAMPLE, PROF_DRAW, PROF_LOOP, PROF_COUNT };
+     const char PROF_NAMES[PROF_COUNT][7] PROGMEM = { "sample", "draw", "loop" };
+     #include "LoopProfiler.h"
+     #if PROFILE_ENABLED
+     LoopProfiler<PROF_COUNT> profiler;     // the macros use this name
+     #endif
+
+     void loop() {
+       PROF_PERIOD(LOOP);                   // time since the last pass
+       PROF_FOLD();
+       PROF_BEGIN(SAMPLE);
+       ...
+       PROF_END(SAMPLE);
+     }
+     profiler.dump(Serial, PROF_NAMES[0], sizeof(PROF_NAMES[0]));
+
+   Times are 16-bit ticks of 4 us (Timer0, the time base of micros()), so a
+   stage may take up to 262 ms. On the board PROF_END is about 20 cycles by
+   instruction count: profNow() reads Timer0 without cli() (interrupts have
+   to be on, so only use it in loop() code), then two stores and a bit set.
+
+   With PROFILE_ENABLED 0 the macros are empty: no code, no RAM, not even
+   the stage names are looked at. tests/LoopProfilerTest.cpp checks the
+   buckets and the report on a PC, tests/LoopProfilerOffTest.cpp that the
+   macros compile to nothing.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+const uint8_t PROF_TICK_US = 4;
+const uint8_t PROF_BUCKETS = 16;   // bucket b holds durations of 2^b .. 2^(b+1)-1 ticks
+
+// floor(log2(n)) of a nibble
+const uint8_t PROF_LOG2[16] PROGMEM = { 0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3 };
+
+#ifdef __AVR__
+extern volatile unsigned long timer0_overflow_count; // maintained by the core's Timer0 ISR
+
+// Same time base as micros() without its 32-bit math: Timer0 ticks every
+// 4 us at 16 MHz, so (overflows << 8 | TCNT0) is a 4 us counter. If the
+// overflow ISR ran between the two reads, TCNT0 is read again.
+static inline uint16_t profNow() {
+  uint8_t ovf = (uint8_t)timer0_overflow_count;
+  uint8_t t = TCNT0;
+  uint8_t again = (uint8_t)timer0_overflow_count;
+  if (again != ovf) {
+    ovf = again;
+    t = TCNT0;
+  }
+  return ((uint16_t)ovf << 8) | t;
+}
+#else
+static inline uint16_t profNow() { return (uint16_t)(micros() / PROF_TICK_US); }
+#endif
+
+struct ProfStats {
+  uint16_t n;                      // probes since last reset (saturates)
+  uint16_t minT, maxT;             // in ticks
+  uint8_t hist[PROF_BUCKETS];      // halved together when one bucket fills up
+};
+
+template<uint8_t STAGES>
+class LoopProfiler {
+ public:
+  static_assert(STAGES <= 8, "one bit per stage in fresh");
+
+  ProfStats stats[STAGES];
+
+  // PROF_END: the raw duration only, bucketed by fold()
+  inline void record(uint8_t stage, uint16_t ticks) {
+    raw_[stage] = ticks;
+    fresh_ |= 1 << stage;
+  }
+
+  // Stats and histogram of every stage recorded since the last fold()
+  void fold() {
+    for (uint8_t s = 0; s < STAGES; s++) {
+      if (fresh_ & (1 << s)) add(stats[s], raw_[s]);
+    }
+    fresh_ = 0;
+  }
+
+  void reset() {
+    memset(stats, 0, sizeof(stats));
+    fresh_ = 0;
+  }
+
+  // One line per stage (n, min, p99, max in us), then "<limit_us:count" for
+  // every non-empty bucket. p99 is the upper edge of the bucket holding the
+  // 99th percentile. names: PROGMEM char[STAGES][nameSize].
+  void dump(Print &out, const char *names, uint8_t nameSize) {
+    fold();
+    out.println(F("\nstage  n\tmin\tp99\tmax (us)"));
+    for (uint8_t s = 0; s < STAGES; s++) {
+      const ProfStats &st = stats[s];
+      uint16_t total = 0;
+      for (uint8_t i = 0; i < PROF_BUCKETS; i++) total += st.hist[i];
+      uint8_t p99 = 0;
+      uint16_t above = 0;
+      for (int8_t i = PROF_BUCKETS - 1; i >= 0; i--) {
+        above += st.hist[i];
+        if (above * 100UL > total) { p99 = i; break; }
+      }
+
+      char name[12];
+      strncpy_P(name, names + s * nameSize, sizeof(name) - 1);
+      name[sizeof(name) - 1] = '\0';
+      out.print(name);
+      for (uint8_t pad = strlen(name); pad < 7; pad++) out.print(' ');
+      out.print(st.n);
+      out.print('\t');
+      out.print((unsigned long)st.minT * PROF_TICK_US);
+      out.print('\t');
+      out.print(((2UL << p99) - 1) * PROF_TICK_US);
+      out.print('\t');
+      out.println((unsigned long)st.maxT * PROF_TICK_US);
+
+      out.print(F("   "));
+      for (uint8_t i = 0; i < PROF_BUCKETS; i++) {
+        if (st.hist[i] == 0) continue;
+        out.print(F(" <"));
+        out.print((2UL << i) * PROF_TICK_US);
+        out.print(':');
+        out.print(st.hist[i]);
+      }
+      out.println();
+    }
+  }
+
+ private:
+  uint16_t raw_[STAGES];
+  uint8_t fresh_ = 0;
+
+  // bucket = floor(log2(ticks)) from a byte pick, a nibble pick and a
+  // 16-entry table: the same few cycles for every duration
+  static void add(ProfStats &st, uint16_t ticks) {
+    if (st.n == 0 || ticks < st.minT) st.minT = ticks;
+    if (ticks > st.maxT) st.maxT = ticks;
+    if (st.n < 0xFFFF) st.n++;
+
+    uint8_t hi = ticks >> 8;
+    uint8_t v = hi ? hi : (uint8_t)ticks;
+    uint8_t b = hi ? 8 : 0;
+    if (v >> 4) {
+      v >>= 4;
+      b += 4;
+    }
+    b += pgm_read_byte(&PROF_LOG2[v]);
+    if (st.hist[b] == 0xFF) {
+      for (uint8_t i = 0; i < PROF_BUCKETS; i++) st.hist[i] >>= 1;
+    }
+    st.hist[b]++;
+  }
+};
+
+#if PROFILE_ENABLED
+  #define PROF_BEGIN(s) uint16_t _prof_##s = profNow()
+  #define PROF_END(s)   profiler.record(PROF_##s, profNow() - _prof_##s)
+  // time since the previous PROF_PERIOD(s), e.g. the whole loop() period
+  #define PROF_PERIOD(s) do { static uint16_t _last = profNow(); uint16_t _now = profNow(); \
+                              profiler.record(PROF_##s, _now - _last); _last = _now; } while (0)
+  #define PROF_FOLD()   profiler.fold()
+#else
+  #define PROF_BEGIN(s)
+  #define PROF_END(s)
+  #define PROF_PERIOD(s)
+  #define PROF_FOLD()
+#endif
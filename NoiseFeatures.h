@@ -0,0 +1,99 @@
+/* NoiseFeatures.h - energy, peak and zero crossings of one sample window
+
+   One pass over a window of DC-free ADC samples (-512..511, as
+   Packed10::unpack() gives them). The mean of the window is taken off
+   first, then:
+
+     energy     mean of the squares (ADC counts squared)
+     peakSq     largest square
+     crossings  zero crossings, ignoring +-hyst counts around the mean
+
+     WindowFeatures w;
+     windowFeatures(s, 50, 2, w);
+     uint32_t crest = w.energy ? w.peakSq * 16 / w.energy : 0;
+
+   A full-scale sample is 1023 counts from the mean at most, so a square
+   is up to 1046529: squares and their sums are 32-bit. Integer code only,
+   no hardware: tests/NoiseFeaturesTest.cpp checks it on a PC with
+   full-scale input.
+
+   NoiseHistory turns the windows of the last second (one every 50 ms)
+   into the feature vector of the Noise Meter's classifier (NoiseTree.h):
+
+     history.update(w, QUIET_ENERGY, feat);   // feat[F_COUNT]
+
+   energy = mean square about the window mean (ADC counts^2)
+   zcr    = crossings of the mean per window
+   crest  = peak^2 / energy, x16
+   onsets = windows in the last second whose energy jumped 4x
+   loud   = windows in the last second above silence
+   burst  = 1 if the last window was an onset and this one is 4x quieter
+            again: a sound shorter than about 100 ms (a bang, not a syllable)
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+struct WindowFeatures {
+  uint32_t energy;
+  uint32_t peakSq;
+  uint8_t crossings;
+};
+
+enum Feature { F_ENERGY, F_ZCR, F_CREST, F_ONSETS, F_LOUD, F_BURST, F_COUNT };
+const uint8_t NOISE_HISTORY = 20;       // windows in the last second
+
+inline uint8_t countBits(uint32_t v) {
+  uint8_t c = 0;
+  while (v) { v &= v - 1; c++; }
+  return c;
+}
+
+inline void windowFeatures(const int16_t *s, uint8_t n, int8_t hyst, WindowFeatures &f) {
+  long sum = 0;
+  for (uint8_t i = 0; i < n; i++) sum += s[i];
+  int mean = sum / n;
+
+  uint32_t sumSq = 0;          // n * 1023^2 fits for n < 4100
+  f.peakSq = 0;
+  f.crossings = 0;
+  int8_t side = 0;             // -1 below, +1 above the mean (with hysteresis)
+  for (uint8_t i = 0; i < n; i++) {
+    int16_t d = s[i] - mean;
+    uint32_t sq = (uint32_t)((long)d * d);
+    sumSq += sq;
+    if (sq > f.peakSq) f.peakSq = sq;
+    int8_t now = d > hyst ? 1 : (d < -hyst ? -1 : side);
+    if (side != 0 && now != side) f.crossings++;
+    side = now;
+  }
+  f.energy = sumSq / n;
+}
+
+struct NoiseHistory {
+  uint32_t lastEnergy;
+  uint32_t onsetBits;          // bit i = window i ago was an onset
+  uint32_t loudBits;
+
+  void update(const WindowFeatures &w, uint32_t quietEnergy, uint16_t *feat) {
+    uint32_t energy = w.energy;
+    bool loud = energy >= quietEnergy;
+    bool onset = loud && energy > 4 * lastEnergy;
+    bool burst = (onsetBits & 1) && energy * 4 < lastEnergy;
+    lastEnergy = energy;
+    uint32_t mask = (1UL << NOISE_HISTORY) - 1;
+    onsetBits = ((onsetBits << 1) | onset) & mask;
+    loudBits = ((loudBits << 1) | loud) & mask;
+
+    feat[F_ENERGY] = energy > 0xFFFF ? 0xFFFF : energy;
+    feat[F_ZCR] = w.crossings;
+    uint32_t crest = energy ? w.peakSq * 16 / energy : 0;
+    feat[F_CREST] = crest > 0xFFFF ? 0xFFFF : crest;
+    feat[F_ONSETS] = countBits(onsetBits);
+    feat[F_LOUD] = countBits(loudBits);
+    feat[F_BURST] = burst;
+  }
+};
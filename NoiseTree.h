@@ -0,0 +1,54 @@
+/* NoiseTree.h - silence / speech / bang decision tree of the Noise Meter
+
+   A tiny decision tree with integer thresholds over the feature vector of
+   NoiseFeatures.h. A node sends the window to 'below' when
+   feat[feature] < threshold, else to 'above'; LEAF | class is a leaf:
+
+     uint8_t cls = noiseClassify(NOISE_TREE, feat);
+
+   NOISE_TREE below is the tree the sketch uses. A window is only a bang
+   when the window before it jumped up and this one fell back 4x (burst)
+   without the spiky tail of a voice (crest). The first window of a
+   sentence looks like a bang's first window, so the bang is called one
+   window (50 ms) later; the capture keeps 164 ms before its trigger.
+   High zero-crossing windows with onsets are speech: "s" and "f" sounds
+   called bangs were most of the remaining false captures.
+   tools/NoiseTreeTrainer.cpp grows a tree from labelled WAV recordings
+   and prints a table to paste over this one; tests/NoiseTreeTest.cpp
+   checks the table on a PC against synthetic speech, bangs and hum.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "NoiseFeatures.h"
+
+enum NoiseClass { C_SILENCE, C_SPEECH, C_IMPACT, C_COUNT };
+
+struct TreeNode {
+  uint8_t feature;
+  uint16_t threshold;
+  uint8_t below, above;
+};
+const uint8_t LEAF = 0x80;
+
+// Node 1 uses the Noise Meter's QUIET_THRESHOLD 25 (energy 625); change both
+const TreeNode NOISE_TREE[] PROGMEM = {
+  { F_BURST,  1,   1, 3 },                            // 0: loud for one window only?
+  { F_ENERGY, 625, LEAF | C_SILENCE, 2 },             // 1: too weak to matter
+  { F_ONSETS, 2,   LEAF | C_SILENCE, LEAF | C_SPEECH }, // 2: steady hum (fan, projector)
+  { F_CREST,  109, LEAF | C_IMPACT, 1 },              // 3: smooth decay after it = bang
+};
+
+// Walk the tree from node 0 to a leaf
+inline uint8_t noiseClassify(const TreeNode *tree, const uint16_t *feat) {
+  uint8_t n = 0;
+  while (!(n & LEAF)) {
+    uint8_t f = pgm_read_byte(&tree[n].feature);
+    uint16_t t = pgm_read_word(&tree[n].threshold);
+    n = feat[f] < t ? pgm_read_byte(&tree[n].below) : pgm_read_byte(&tree[n].above);
+  }
+  return n & ~LEAF;
+}
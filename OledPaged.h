@@ -0,0 +1,198 @@
+/* OledPaged.h - SSD1306 128x64 driver that draws in 128-byte page strips
+
+   Adafruit_SSD1306 keeps a 1 KB copy of the whole screen in RAM. PagedOled
+   keeps one page (8 pixel rows = 128 bytes) and runs the drawing code once
+   per page, sending every finished strip straight to the panel:
+
+     display.firstPage();
+     do {
+       display.setTextSize(1);
+       display.setCursor(0, 0);
+       display.print("Hello");
+     } while (display.nextPage());
+
+   The drawing code runs 8 times per screen, so it must draw the same thing
+   every pass (set the cursor inside the loop, do not count things in it).
+   Everything from Adafruit_GFX works: setCursor, print, fillRect,
+   drawRoundRect, getTextBounds, ... clearDisplay() and display() are not
+   needed. Saves 896 bytes of RAM. Rotation is not supported.
+   frameCrc() is a CRC-16 of the last complete screen sent, to compare
+   screens without a framebuffer (e.g. at the end of an InputTrace replay).
+
+   mirrorTo(0x3D) sends every strip to a second panel as well (0 = off).
+   sendColumn(x, bytes) writes one 1 x 64 px column (8 bytes, page 0
+   first) straight to the panel, outside any firstPage() loop: screens
+   that only ever change a column at a time need no buffer at all.
+   sendColumnTo(addr, x, bytes) does the same on any panel on the bus.
+
+   Scrolling without a framebuffer: the panel shows its RAM from the
+   display start line on, so startLine(n) moves the whole picture up by n
+   rows (mod 64) with one command. Outside a firstPage() loop, buffer() is
+   the 128-byte strip to fill and sendPageBuffer(page) sends it to a page
+   of RAM; Waterfall.h writes one new row at a time like this. Set the
+   start line back to 0 before drawing normal screens again.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>   // colour and command names only, no buffer
+#include <util/crc16.h>
+
+class PagedOled : public Adafruit_GFX {
+ public:
+  static const uint8_t PAGES = 8;
+
+  PagedOled(TwoWire *wire = &Wire)
+    : Adafruit_GFX(128, 64), wire_(wire), addr_(0x3C), mirror_(0), page_(0),
+      crc_(0xFFFF), frameCrc_(0xFFFF) {}
+
+  // Same init sequence as Adafruit_SSD1306 (128x64, internal charge pump).
+  // false if nothing answers at addr.
+  bool begin(uint8_t addr = 0x3C) {
+    static const uint8_t INIT[] PROGMEM = {
+      SSD1306_DISPLAYOFF, SSD1306_SETDISPLAYCLOCKDIV, 0x80,
+      SSD1306_SETMULTIPLEX, 0x3F, SSD1306_SETDISPLAYOFFSET, 0x00,
+      SSD1306_SETSTARTLINE | 0x00, SSD1306_CHARGEPUMP, 0x14,
+      SSD1306_MEMORYMODE, 0x00, SSD1306_SEGREMAP | 0x01, SSD1306_COMSCANDEC,
+      SSD1306_SETCOMPINS, 0x12, SSD1306_SETCONTRAST, 0xCF,
+      SSD1306_SETPRECHARGE, 0xF1, SSD1306_SETVCOMDETECT, 0x40,
+      SSD1306_DISPLAYALLON_RESUME, SSD1306_NORMALDISPLAY,
+      SSD1306_DEACTIVATE_SCROLL, SSD1306_DISPLAYON
+    };
+    addr_ = addr;
+    wire_->begin();
+    wire_->setClock(400000);
+    wire_->beginTransmission(addr_);
+    if (wire_->endTransmission() != 0) return false;
+    for (uint8_t i = 0; i < sizeof(INIT); i++) command(pgm_read_byte(&INIT[i]));
+    return true;
+  }
+
+  // Start a screen: page 0, empty strip
+  void firstPage() {
+    page_ = 0;
+    crc_ = 0xFFFF;
+    memset(buf_, 0, sizeof(buf_));
+  }
+
+  // Send the finished strip; true while there are pages left to draw
+  bool nextPage() {
+    sendPage(true);
+    if (++page_ == PAGES) {
+      page_ = 0;
+      frameCrc_ = crc_;
+      return false;
+    }
+    memset(buf_, 0, sizeof(buf_));
+    return true;
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    if (x < 0 || x >= WIDTH || (y >> 3) != page_ || y < 0) return;
+    uint8_t bit = 1 << (y & 7);
+    if (color == SSD1306_WHITE) buf_[x] |= bit;
+    else if (color == SSD1306_BLACK) buf_[x] &= ~bit;
+    else buf_[x] ^= bit;
+  }
+
+  // Clipped to the current strip first, so off-page shapes cost almost nothing
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    int16_t top = page_ * 8;
+    if (y < top) { h -= top - y; y = top; }
+    if (y + h > top + 8) h = top + 8 - y;
+    for (; h > 0; h--, y++) drawPixel(x, y, color);
+  }
+
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    if ((y >> 3) != page_ || y < 0) return;
+    for (; w > 0; w--, x++) drawPixel(x, y, color);
+  }
+
+  void fillScreen(uint16_t color) override {
+    memset(buf_, color == SSD1306_WHITE ? 0xFF : 0x00, sizeof(buf_));
+  }
+
+  uint16_t frameCrc() const { return frameCrc_; }
+
+  void mirrorTo(uint8_t addr) { mirror_ = addr; }
+
+  void sendColumn(uint8_t x, const uint8_t *col) {
+    sendColumnTo(addr_, x, col);
+    if (mirror_) sendColumnTo(mirror_, x, col);
+  }
+
+  uint8_t *buffer() { return buf_; }
+
+  void sendPageBuffer(uint8_t page) {
+    uint8_t keep = page_;
+    page_ = page;
+    sendPage(false);
+    page_ = keep;
+  }
+
+  // Panel RAM line shown on the top row (0..63), both panels
+  void startLine(uint8_t line) {
+    command(SSD1306_SETSTARTLINE | (line & 63));
+    if (mirror_) commandTo(mirror_, SSD1306_SETSTARTLINE | (line & 63));
+  }
+
+  void sendColumnTo(uint8_t addr, uint8_t x, const uint8_t *col) {
+    window(addr, x, x, 0, PAGES - 1);    // bytes go down the column, page by page
+    wire_->beginTransmission(addr);
+    wire_->write((uint8_t)0x40);
+    wire_->write(col, PAGES);
+    wire_->endTransmission();
+  }
+
+ private:
+  void command(uint8_t c) { commandTo(addr_, c); }
+
+  void commandTo(uint8_t addr, uint8_t c) {
+    wire_->beginTransmission(addr);
+    wire_->write((uint8_t)0x00);
+    wire_->write(c);
+    wire_->endTransmission();
+  }
+
+  // Columns x0..x1 of pages p0..p1 receive the next data bytes
+  void window(uint8_t addr, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) {
+    wire_->beginTransmission(addr);
+    wire_->write((uint8_t)0x00);
+    wire_->write((uint8_t)SSD1306_COLUMNADDR);
+    wire_->write(x0);
+    wire_->write(x1);
+    wire_->write((uint8_t)SSD1306_PAGEADDR);
+    wire_->write(p0);
+    wire_->write(p1);
+    wire_->endTransmission();
+  }
+
+  // Column window 0..127 on this page, then 128 data bytes, 16 per transaction
+  void sendPage(bool frame) {
+    if (frame) {
+      for (uint8_t x = 0; x < sizeof(buf_); x++) crc_ = _crc_ccitt_update(crc_, buf_[x]);
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+      uint8_t addr = i ? mirror_ : addr_;
+      if (!addr) continue;
+      window(addr, 0, WIDTH - 1, page_, page_);
+      for (uint8_t x = 0; x < sizeof(buf_); x += 16) {
+        wire_->beginTransmission(addr);
+        wire_->write((uint8_t)0x40);
+        wire_->write(buf_ + x, 16);
+        wire_->endTransmission();
+      }
+    }
+  }
+
+  TwoWire *wire_;
+  uint8_t addr_;
+  uint8_t mirror_;             // second panel, 0 = none
+  uint8_t page_;
+  uint16_t crc_, frameCrc_;
+  uint8_t buf_[128];
+};
@@ -0,0 +1,186 @@
+/* OledWidgets.h - small retained-mode widgets for the SSD1306 sketches
+
+   Each widget owns a rectangle on the screen and remembers what it drew
+   last. set()/draw() repaint only that rectangle, and only when the value
+   changed, and return true when they touched the buffer. A sketch can then
+   skip display.display() when nothing changed:
+
+     bool changed = title.draw(display) | count.set(display, clapCount);
+     if (changed) display.display();
+
+   (use '|' not '||' so every widget gets its turn)
+
+   Anything that draws outside the widgets (splash screens, full-screen
+   messages) must be followed by widgetClear(display): it clears the buffer
+   and makes every widget repaint in full on its next call.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Adafruit_GFX.h>
+
+// Bumped by widgetClear(); a widget drawn in an older epoch repaints fully
+static uint8_t widgetEpoch = 1;
+
+template<class Display>
+void widgetClear(Display &d) {
+  d.clearDisplay();
+  if (++widgetEpoch == 0) widgetEpoch = 1;
+}
+
+// 16-bit FNV-1a of a string: lets text widgets spot changes without a copy
+inline uint16_t widgetHash(const char *s) {
+  uint16_t h = 0x811C;
+  while (*s) { h ^= (uint8_t)*s++; h *= 0x0193; }
+  return h;
+}
+
+// Box shared by all widgets; text boxes are 8 px tall per text size step.
+// Colours: 1 = SSD1306_WHITE, 0 = SSD1306_BLACK
+struct WidgetBox {
+  int16_t x, y, w, h;
+  uint8_t epoch;      // widgetEpoch of the last full paint, 0 = never drawn
+
+  WidgetBox(int16_t x_, int16_t y_, int16_t w_, int16_t h_)
+    : x(x_), y(y_), w(w_), h(h_), epoch(0) {}
+  bool stale() const { return epoch != widgetEpoch; }
+  void erase(Adafruit_GFX &g) const { g.fillRect(x, y, w, h, 0); }
+};
+
+// Fixed text, painted once per screen. F()/PSTR() cannot be used at global
+// scope, so the text is a plain string or a PROGMEM array (pass inFlash).
+class LabelWidget {
+ public:
+  LabelWidget(int16_t x, int16_t y, uint8_t size, const char *text, bool inFlash = false)
+    : box(x, y, 0, 0), size_(size), flash_(inFlash), text_(text) {}
+
+  bool draw(Adafruit_GFX &g) {
+    if (!box.stale()) return false;
+    g.setTextSize(size_);
+    g.setTextColor(1);
+    g.setCursor(box.x, box.y);
+    if (flash_) g.print((const __FlashStringHelper *)text_);
+    else g.print(text_);
+    box.epoch = widgetEpoch;
+    return true;
+  }
+
+ private:
+  WidgetBox box;
+  uint8_t size_;
+  bool flash_;
+  const char *text_;
+};
+
+// Short RAM text that changes (masked PIN, status line, formatted value).
+// The box must be wide enough for the longest text it will show.
+class TextWidget {
+ public:
+  TextWidget(int16_t x, int16_t y, int16_t w, uint8_t size)
+    : box(x, y, w, 8 * size), size_(size), hash_(0) {}
+
+  bool set(Adafruit_GFX &g, const char *text) {
+    uint16_t h = widgetHash(text);
+    if (!box.stale() && h == hash_) return false;
+    box.erase(g);
+    g.setTextSize(size_);
+    g.setTextColor(1);
+    g.setCursor(box.x, box.y);
+    g.print(text);
+    hash_ = h;
+    box.epoch = widgetEpoch;
+    return true;
+  }
+
+ private:
+  WidgetBox box;
+  uint8_t size_;
+  uint16_t hash_;
+};
+
+// Integer value
+class NumberWidget {
+ public:
+  NumberWidget(int16_t x, int16_t y, int16_t w, uint8_t size)
+    : box(x, y, w, 8 * size), size_(size), last_(0) {}
+
+  bool set(Adafruit_GFX &g, long v) {
+    if (!box.stale() && v == last_) return false;
+    box.erase(g);
+    g.setTextSize(size_);
+    g.setTextColor(1);
+    g.setCursor(box.x, box.y);
+    g.print(v);
+    last_ = v;
+    box.epoch = widgetEpoch;
+    return true;
+  }
+
+ private:
+  WidgetBox box;
+  uint8_t size_;
+  long last_;
+};
+
+// Horizontal bar with a rounded frame; only the columns between the old and
+// the new fill are repainted
+class BarWidget {
+ public:
+  BarWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : box(x, y, w, h), fill_(0) {}
+
+  bool set(Adafruit_GFX &g, int16_t fill) {
+    if (fill < 0) fill = 0;
+    if (fill > box.w) fill = box.w;
+    if (box.stale()) {
+      g.fillRect(box.x - 1, box.y - 1, box.w + 2, box.h + 2, 0);
+      g.drawRoundRect(box.x - 1, box.y - 1, box.w + 2, box.h + 2, 3, 1);
+      if (fill > 0) g.fillRect(box.x, box.y, fill, box.h, 1);
+    } else if (fill > fill_) {
+      g.fillRect(box.x + fill_, box.y, fill - fill_, box.h, 1);
+    } else if (fill < fill_) {
+      g.fillRect(box.x + fill, box.y, fill_ - fill, box.h, 0);
+    } else {
+      return false;
+    }
+    fill_ = fill;
+    box.epoch = widgetEpoch;
+    return true;
+  }
+
+ private:
+  WidgetBox box;
+  int16_t fill_;
+};
+
+// Text face picked by state (e.g. 0 = ":)", 1 = ">:("), -1 = blank.
+// With inFlash the table and its strings are all PROGMEM.
+class FaceWidget {
+ public:
+  FaceWidget(int16_t x, int16_t y, int16_t w, uint8_t size, const char *const *faces, bool inFlash = false)
+    : box(x, y, w, 8 * size), size_(size), flash_(inFlash), faces_(faces), state_(-1) {}
+
+  bool set(Adafruit_GFX &g, int8_t state) {
+    if (!box.stale() && state == state_) return false;
+    box.erase(g);
+    if (state >= 0) {
+      g.setTextSize(size_);
+      g.setTextColor(1);
+      g.setCursor(box.x, box.y);
+      if (flash_) g.print((const __FlashStringHelper *)pgm_read_ptr(&faces_[state]));
+      else g.print(faces_[state]);
+    }
+    state_ = state;
+    box.epoch = widgetEpoch;
+    return true;
+  }
+
+ private:
+  WidgetBox box;
+  uint8_t size_;
+  bool flash_;
+  const char *const *faces_;
+  int8_t state_;
+};
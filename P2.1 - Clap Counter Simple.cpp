@@ -18,6 +18,7 @@
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include "OledWidgets.h"
 
 // OLED setup
 #define SCREEN_WIDTH 128
@@ -32,6 +33,11 @@ const int SOUND_PIN = 2;   // D0 from LM393 → D2
 unsigned long clapCount = 0;
 int lastState = LOW;
 
+// Screen widgets: the label is drawn once, the number only when it changes
+const char CLAPS_TEXT[] PROGMEM = "Claps:";
+LabelWidget clapsLabel(0, 0, 2, CLAPS_TEXT, true);
+NumberWidget clapsValue(0, 30, 128, 4);
+
 void setup() {
   pinMode(SOUND_PIN, INPUT);
   Serial.begin(9600);
@@ -46,9 +52,10 @@ void setup() {
   display.setTextSize(2);
   display.setTextColor(SSD1306_WHITE);
   display.setCursor(0,0);
-  display.println("Clap Counter");
+  display.println(F("Clap Counter"));
   display.display();
   delay(1000);
+  widgetClear(display);
   updateDisplay();
 }
 
@@ -58,7 +65,7 @@ void loop() {
   // Detect rising edge (LOW → HIGH = clap)
   if (state == HIGH && lastState == LOW) {
     clapCount++;
-    Serial.print("Clap #");
+    Serial.print(F("Clap #"));
     Serial.println(clapCount);
     updateDisplay();
     delay(200); // small delay to avoid double counting
@@ -68,12 +75,7 @@ void loop() {
 }
 
 void updateDisplay() {
-  display.clearDisplay();
-  display.setTextSize(2);
-  display.setCursor(0, 0);
-  display.println("Claps:");
-  display.setTextSize(4);
-  display.setCursor(0, 30);
-  display.println(clapCount);
-  display.display();
+  bool changed = clapsLabel.draw(display);
+  changed |= clapsValue.set(display, clapCount);
+  if (changed) display.display();
 }
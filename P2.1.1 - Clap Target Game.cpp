@@ -3,11 +3,16 @@
 Wiring:
   OLED (I2C): VCC->5V, GND->GND, SDA->A4, SCL->A5
   LM393: VCC->5V, GND->GND, D0->D2 (digital)
+
+Serial (9600): 'R' restarts and records the claps, 'P' restarts and replays
+them exactly (fast, ends with the CRC of the screen), 'D' prints the trace.
+See InputTrace.h.
 */
 
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include "InputTrace.h"
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
@@ -21,37 +26,45 @@ unsigned long startTime = 0;
 const unsigned long gameDuration = 5000; // 5 seconds to perform claps
 bool gameRunning = false;
 int target = 0;
+InputTrace trace(0);   // trace in EEPROM from address 0
 
 void setup() {
   pinMode(SOUND_PIN, INPUT);
   Serial.begin(9600);
+  randomSeed(trace.begin(analogRead(A3)));   // first: replay gets the same targets as the recording
   display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
   display.clearDisplay();    // clear screen
   display.setTextSize(2);    // text size 1–3
   display.setTextColor(SSD1306_WHITE); 
   display.setCursor(0,0);    
-  display.print("!!!START!!!");
+  display.print(F("!!!START!!!"));
   display.display();
-  randomSeed(analogRead(A3));
+  trace.sync();              // drawing took a while: replay starts the round as late
   newGame();
 }
 
 void loop() {
-  int s = digitalRead(SOUND_PIN);
+  if (trace.poll()) {   // replay finished: fingerprint of the screen
+    Serial.print(F("#FRAME "));
+    Serial.println(traceCrc(display.getBuffer(), SCREEN_WIDTH * SCREEN_HEIGHT / 8), HEX);
+  }
+  if (Serial.available()) trace.command(Serial.read());
+
+  int s = trace.level(0, digitalRead(SOUND_PIN));
   if (!gameRunning) return;
 
   // rising edge = clap
   if (s == HIGH && lastState == LOW) {
     clapCount++;
     updateDisplay();
-    delay(150);
+    trace.delay(150);
   }
   lastState = s;
 
-  if (millis() - startTime >= gameDuration) {
+  if (trace.millis() - startTime >= gameDuration) {
     gameRunning = false;
     showResult();
-    delay(2000);
+    trace.delay(2000);
     newGame(); // start new round
   }
 }
@@ -60,19 +73,20 @@ void newGame() {
   target = random(3, 9); // target between 3 and 8
   clapCount = 0;
   gameRunning = true;
-  startTime = millis();
+  startTime = trace.millis();
+  trace.state(F("target"), target);
   display.clearDisplay();
   display.setTextSize(1);
   display.setCursor(0,0);
-  display.println("Target Game!");
+  display.println(F("Target Game!"));
   display.setTextSize(2);
   display.setCursor(0,20);
-  display.print("Target:");
+  display.print(F("Target:"));
   display.setCursor(80,20);
   display.print(target);
   display.setTextSize(1);
   display.setCursor(0,50);
-  display.println("Clap exactly the number!");
+  display.println(F("Clap exactly the number!"));
   display.display();
 }
 
@@ -80,28 +94,29 @@ void updateDisplay() {
   display.fillRect(0,40,128,20,SSD1306_BLACK);
   display.setTextSize(2);
   display.setCursor(0,40);
-  display.print("You:");
+  display.print(F("You:"));
   display.setCursor(60,40);
   display.print(clapCount);
   display.display();
 }
 
 void showResult() {
+  trace.state(F("claps"), clapCount);
   display.clearDisplay();
   display.setTextSize(2);
   display.setCursor(0,10);
   if (clapCount == target) {
-    display.println("You Win!");
+    display.println(F("You Win!"));
   } else if (clapCount < target) {
-    display.println("Too few!");
+    display.println(F("Too few!"));
   } else {
-    display.println("Too many!");
+    display.println(F("Too many!"));
   }
   display.setTextSize(1);
   display.setCursor(0,50);
-  display.print("Target:");
+  display.print(F("Target:"));
   display.print(target);
-  display.print(" You:");
+  display.print(F(" You:"));
   display.print(clapCount);
   display.display();
 }
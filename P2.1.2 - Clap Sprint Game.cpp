@@ -1,6 +1,9 @@
 /* Clap Timer Challenge - count claps in 10 seconds
 Goal: Start a 10-second countdown; kids clap as many times as they can before time runs out. Final score appears.
-Explanation: A clap starts a 10s timer. Each detected clap increments the score shown on the OLED. After 10s the final score displays.
+Explanation: A clap starts a 10s timer. Each detected clap increments the score shown on the OLED. After 10s the final score displays,
+  with the player's peak clap rate and a histogram of the gaps between claps.
+  Claps are counted in an interrupt from the sensor edge, and the screen is redrawn at a fixed frame rate, so fast clappers
+  (15+ claps/s) are never missed while the display updates.
 Wiring:
   OLED (I2C): VCC->5V, GND->GND, SDA->A4, SCL->A5
   LM393: VCC->5V, GND->GND, D0->D2
@@ -9,20 +12,49 @@ Wiring:
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include "OledWidgets.h"
+#include "ClapCounter.h"
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 #define OLED_RESET -1
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 
-const int SOUND_PIN = 2;
-unsigned long clapCount = 0;
-int lastState = LOW;
+const int SOUND_PIN = 2;   // INT0
 
 const unsigned long countdownMs = 10000; // 10 seconds
 bool running = false;
 unsigned long startMillis = 0;
 
+// Screen refresh, independent of how fast people clap
+const unsigned long FRAME_MS = 100;      // 10 frames per second
+unsigned long lastFrame = 0;
+
+// Running screen widgets: only the parts that changed are redrawn each frame
+TextWidget timeWidget(0, 0, 128, 1);
+NumberWidget scoreWidget(0, 20, 128, 3);
+
+// Counted by the INT0 handler, read by loop() with interrupts off
+ClapCounter claps;
+
+// INT0 rising edge = clap: count it and update the interval stats right away
+void onClap() {
+  claps.edge(micros());
+}
+
+void resetClaps() {
+  noInterrupts();
+  claps.reset();
+  interrupts();
+}
+
+unsigned long readClaps() {
+  noInterrupts();
+  unsigned long c = claps.count;
+  interrupts();
+  return c;
+}
+
 void setup() {
   pinMode(SOUND_PIN, INPUT);
   Serial.begin(9600);
@@ -33,36 +65,37 @@ void setup() {
   display.setCursor(0,0);    
   display.print("Start");
   display.display();         // update display
+  attachInterrupt(digitalPinToInterrupt(SOUND_PIN), onClap, RISING);
   showStartScreen();
 }
 
 void loop() {
-  int s = digitalRead(SOUND_PIN);
-
   // start the challenge when a clap is heard and not running
-  if (!running && s == HIGH && lastState == LOW) {
-    running = true;
-    clapCount = 0;
-    startMillis = millis();
-    showRunning();
-    delay(150);
+  if (!running) {
+    if (readClaps() > 0) {
+      resetClaps();          // the starting clap does not score
+      running = true;
+      startMillis = millis();
+      lastFrame = 0;
+      widgetClear(display);  // start screen gone, widgets repaint in full
+    }
+    return;
   }
 
-  if (running) {
-    if (s == HIGH && lastState == LOW) {
-      clapCount++;
-      showRunning();
-      delay(120);
-    }
-    if (millis() - startMillis >= countdownMs) {
-      running = false;
-      showResult();
-      delay(3000);
-      showStartScreen();
-    }
+  unsigned long now = millis();
+  if (now - startMillis >= countdownMs) {
+    running = false;
+    showResult();
+    delay(3000);
+    showStartScreen();
+    resetClaps();            // claps during the result screen do not start a game
+    return;
   }
 
-  lastState = s;
+  if (lastFrame == 0 || now - lastFrame >= FRAME_MS) {
+    lastFrame = now;
+    showRunning();
+  }
 }
 
 void showStartScreen() {
@@ -76,28 +109,51 @@ void showStartScreen() {
   display.display();
 }
 
+// One frame: live countdown in tenths plus the current score
 void showRunning() {
-  unsigned long left = (countdownMs - (millis() - startMillis)) / 1000;
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0,0);
-  display.print("Time left: ");
-  display.print(left);
-  display.println(" s");
-  display.setTextSize(3);
-  display.setCursor(0,20);
-  display.print(clapCount);
-  display.display();
+  unsigned long elapsed = millis() - startMillis;
+  unsigned long left = elapsed < countdownMs ? (countdownMs - elapsed) / 100 : 0;
+  char buf[20];
+  sprintf(buf, "Time left: %u.%u s", (unsigned)(left / 10), (unsigned)(left % 10));
+  bool changed = timeWidget.set(display, buf);
+  changed |= scoreWidget.set(display, readClaps());
+  if (changed) display.display();
 }
 
 void showResult() {
+  noInterrupts();
+  unsigned long score = claps.count;
+  uint8_t peak = claps.peakPerSec;
+  uint16_t hist[IOI_BUCKETS];
+  for (uint8_t i = 0; i < IOI_BUCKETS; i++) hist[i] = claps.ioiHist[i];
+  interrupts();
+
   display.clearDisplay();
   display.setTextSize(2);
-  display.setCursor(0,10);
-  display.println("Time's up!");
-  display.setTextSize(2);
-  display.setCursor(0,35);
+  display.setCursor(0,0);
   display.print("Score:");
-  display.print(clapCount);
+  display.print(score);
+  display.setTextSize(1);
+  display.setCursor(0,18);
+  display.print("Peak: ");
+  display.print(peak);
+  display.print(" claps/s");
+
+  // interval histogram, fast (left) to slow (right), tallest bar = 28 px
+  uint16_t top = 1;
+  for (uint8_t i = 0; i < IOI_BUCKETS; i++) if (hist[i] > top) top = hist[i];
+  for (uint8_t i = 0; i < IOI_BUCKETS; i++) {
+    int h = (int)((hist[i] * 28UL + top - 1) / top);
+    display.fillRect(i * 16, 63 - h, 13, h, SSD1306_WHITE);
+  }
+  display.setCursor(0,27);
+  display.print("<60ms");
+  display.setCursor(98,27);
+  display.print(">0.5s");
   display.display();
+
+  Serial.print("Score: ");
+  Serial.print(score);
+  Serial.print(" peak/s: ");
+  Serial.println(peak);
 }
@@ -1,69 +1,427 @@
 /* Decibel meter (Serial calibration + EEPROM)
    - Mic AO -> A0
+   - Optional, for auto range ('a'): Mic AO -> 1 uF -> A1, and A1 biased to
+     ~0.55 V with 82k to 5V and 10k to GND (A1 is read against 1.1 V)
    - OLED SSD1306 (I2C) -> SDA A4, SCL A5
+   - Optional second OLED on the same bus, address jumper set to 0x3D
+     (the main one stays at 0x3C)
    - Serial commands:
-       c : start calibration (measure then type phone SPL)
+       c : start calibration (measure then type phone SPL; the meter keeps running,
+           b, k and w wait until the SPL prompt)
        s : save current calibration to EEPROM
        r : reset/clear calibration
        p : print current calibration value
+       t : print loop stage timings (min/p99/max + histogram)
+       j : print sampling rate, jitter, noise floor and sleep duty cycle
+       n : toggle ADC Noise Reduction sleep sampling
+       b : benchmark the hot functions (cycles per call, JSON) vs the baseline
+       k : run the benchmark and keep it as the baseline (EEPROM)
+       w : toggle the scrolling spectrogram waterfall screen (leaving it prints the row rate)
+       m : next time weighting (Fast / Slow / Impulse), resets Lmax/Lmin
+       x : reset Lmax, Lmin and Leq
+       d : second OLED: off / mirror / level history
+       u : RAM use: globals, heap, stack peak and least free RAM since reset
+       l : lesson statistics L10/L50/L90 + time above 70 dB (toggles the OLED page)
+       z : start a new lesson (clears the statistics)
+       a : toggle auto range (quiet sound through A1 with the 1.1 V reference)
+   - A log line goes out every 1.5 s; it is queued and sent a few bytes per
+     loop() pass (Telemetry.h), so printing never stretches a sample chunk
+   - The OLED is drawn page by page (OledPaged.h): there is no 1 KB
+     framebuffer, which the Uno's 2 KB of RAM cannot hold next to the
+     sampling, statistics and log state of this sketch
 */
 
 #include <Wire.h>
 #include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
 #include <EEPROM.h>
 #include <math.h>
+#include <util/atomic.h>
+#include <avr/sleep.h>
+#include "LessonStats.h"
+#include "LevelMath.h"
+#include "OledPaged.h"
+#include "QuietSampler.h"
+#include "RamMonitor.h"
+#include "SerialCalibration.h"
+#include "Telemetry.h"
+#include "Waterfall.h"
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
-#define OLED_RESET -1
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+PagedOled display;   // one 128-byte page in RAM
 
 // ----- Hardware pins & sampling -----
 const uint8_t MIC_PIN = A0;
 
-// RMS measurement window and sampling
+// Sampling runs without gaps; the window is only used in 'n' quiet mode
 const unsigned long SAMPLE_WINDOW_MS = 120; // measurement window in ms
-const unsigned long SAMPLE_RATE = 5000UL;   // approximate samples per second
-const unsigned long SAMPLE_PERIOD_US = 1000000UL / SAMPLE_RATE;
+const unsigned long SAMPLE_RATE = 5000UL;   // samples per second, paced by Timer1
+
+// Timer1 runs at F_CPU (no prescaler) in CTC mode, one compare match per sample.
+// 16 MHz / 5000 = 3200 ticks = 25 ADC clocks at /128, so every trigger lands
+// on the same ADC clock phase and the sample instants carry no jitter.
+const uint16_t ACQ_TIMER_TOP = F_CPU / SAMPLE_RATE - 1;
+const float ACQ_RATE_HZ = (float)F_CPU / (ACQ_TIMER_TOP + 1);
+
+// In ADC Noise Reduction sleep the I/O clock stops, so Timer1 (and Timer0,
+// i.e. millis()) pause for each conversion: 13 ADC clocks = 1664 CPU cycles.
+// Timer1 gets a shorter period so trigger + conversion still add up to the
+// sample period (within one ADC clock, as the CPU clock restarts each time).
+const uint16_t ACQ_CONV_TICKS = 13 * 128;
+const uint16_t ACQ_NR_TOP = ACQ_TIMER_TOP - ACQ_CONV_TICKS;
 
 // ADC reference voltage (change to 3.3 if you're using 3.3V ADC ref)
 const float VREF_VOLTS = 5.0f;
+// microvolts per 1/64 ADC count, Q8: the log's vrms is isqrt32(msQ8 << 4) * this >> 8
+const uint32_t UV_PER_64TH_Q8 = (uint32_t)(VREF_VOLTS / 1023.0 * 1e6 / 64.0 * 256.0 + 0.5);
+
+// ----- EEPROM map -----
+// Fixed addresses, so a record that grows cannot move the ones after it;
+// the static_asserts below the records check that none runs into the next.
+// Each record starts with a magic byte that is changed whenever its layout
+// changes: an old record, or bytes left by another sketch (the clap game's
+// input trace starts at 0), read as "none". Bytes 0..3 held the calibration
+// as a bare float, which had no such check; they are not read any more.
+const int BENCH_EEPROM_ADDR = 4;       // BenchRecord
+const int STATS_EEPROM_ADDR = 29;      // StatsRecord
+const int RANGE_EEPROM_ADDR = 354;     // RangeRecord
+const int CALIB_EEPROM_ADDR = 357;     // CalibRecord
+const int EEPROM_BYTES = 1024;         // ATmega328P
 
-// EEPROM address to store float calibration offset
-const int EEPROM_ADDR = 0;
+const uint8_t CALIB_MAGIC = 0xCA;
+struct CalibRecord {
+  uint8_t magic;
+  float offset;                        // CALIB_OFFSET
+};
 
 // Calibration offset variable (unique name to avoid macro collisions)
 // SPL_estimate = dBFS + CALIB_OFFSET
 float CALIB_OFFSET = 0.0f;
+int16_t calibCdb = 0;      // same offset in centi-dB (1/100 dB) for the integer path
 bool calibLoaded = false;
 
+// ----- Compile-time lookup tables (LevelMath.h) -----
+// Levels in the per-frame path are integers in centi-dB, so loop() needs no
+// log10() and drawMeter() no float division. MeterScale<LOG_BITS, MIN_DB,
+// MAX_DB, BAR_W, LOUD_DB>: change the numbers to retune the meter.
+typedef MeterScale<6, 30, 120, 116, 70> Scale;
+
+// dBFS = 10*log10(meanSquareQ8) - 10*log10(256 * 1023^2), see msToDbfsCdb()
+const int16_t FULL_SCALE_CDB = (int16_t)(1000.0 * log10Const(256.0 * 1023.0 * 1023.0) + 0.5);
+
+// ----- Loop stage profiler (LoopProfiler.h) -----
+// PROF_BEGIN(stage) / PROF_END(stage) time one named stage of loop(); the
+// durations are bucketed by PROF_FOLD() at the top of loop(), 't' prints them.
+// Set PROFILE_ENABLED to 0 and the macros, the stats RAM and the 't' report
+// all compile out.
+#define PROFILE_ENABLED 1
+#include "LoopProfiler.h"
+
+enum ProfStage { PROF_SAMPLE, PROF_MATH, PROF_FORMAT, PROF_DRAW, PROF_FLUSH, PROF_LOG, PROF_LOOP, PROF_COUNT };
+const char PROF_NAMES[PROF_COUNT][7] PROGMEM = { "sample", "math", "format", "draw", "flush", "log", "loop" };
+#if PROFILE_ENABLED
+LoopProfiler<PROF_COUNT> profiler;
+#endif
+
+// ----- On-device kernel benchmark ('b' / 'k') -----
+// Each kernel runs BENCH_CALLS times between two micros() reads (4 us = 64
+// cycles), so short kernels average down to a few cycles per call. Numbers
+// include ~10 cycles of loop overhead per call.
+// drawSame formats a meter frame that did not change (nothing is sent),
+// frame draws and sends all 8 pages of one. profEnd is one PROF_END (the
+// bucketing is left to PROF_FOLD() and is not in this number).
+enum BenchKernel { BENCH_DBFS, BENCH_FORMAT, BENCH_DRAW_SAME, BENCH_FRAME, BENCH_SAMPLE, BENCH_PROF_END, BENCH_COUNT };
+const char BENCH_NAMES[BENCH_COUNT][12] PROGMEM = { "msToDbfsCdb", "formatCdb", "drawSame", "frame", "sample", "profEnd" };
+const uint8_t BENCH_CALLS[BENCH_COUNT] PROGMEM = { 200, 200, 50, 8, 4, 200 };
+const uint8_t BENCH_REGRESS_PCT = 10;   // slower than the baseline by more = regression
+
+const uint8_t BENCH_MAGIC = 0xB9;    // bumped when the kernel list changes
+struct BenchRecord {
+  uint8_t magic;
+  uint32_t cycles[BENCH_COUNT];
+};
+
+// ----- Timer1-paced ADC acquisition -----
+// Timer1 compare match B auto-triggers every conversion, so sample instants
+// are set by hardware, not by loop timing. The ADC ISR adds each sample to the
+// window sums; the Timer1 ISR counts triggers, so a conversion that was not
+// read before the next trigger shows up as an overrun.
+volatile uint16_t acqTarget = 0;      // samples wanted in this window
+volatile uint16_t acqCount = 0;       // samples taken so far
+volatile uint16_t acqTriggers = 0;    // Timer1 triggers during this window
+volatile bool acqPending = false;     // conversion triggered but not read yet
+volatile bool acqDone = true;
+volatile int32_t acqSum = 0;
+volatile uint32_t acqSumSq = 0;
+volatile int16_t acqDc = 512;         // centre for the sums (last window's mean)
+// The squares are also summed per 32-sample part of the window (6.4 ms),
+// so Impulse can follow a bang inside a 20 ms chunk; the last part takes
+// the rest of a longer window.
+const uint8_t ACQ_PART_SHIFT = 5;
+const uint8_t ACQ_PART = 1 << ACQ_PART_SHIFT;
+const uint8_t ACQ_PARTS = 8;
+volatile uint32_t acqPartSq[ACQ_PARTS];
+
+// jitter statistics since the last 'j' report
+volatile uint16_t acqLatMin = 0xFFFF; // trigger -> ADC ISR, in Timer1 ticks (1/16 us)
+volatile uint16_t acqLatMax = 0;
+volatile uint16_t acqOverruns = 0;
+uint32_t acqTotalSamples = 0;
+uint32_t acqTotalTriggers = 0;
+float acqEffectiveRate = ACQ_RATE_HZ; // samples/s actually delivered last window
+
+// ADC Noise Reduction sleep mode ('n'): CPU, Timer0, I2C and the UART are
+// stopped while each sample converts. A pin change on RX wakes the CPU and
+// keeps the next samples awake (QuietSampler.h). Duty cycle since 'j':
+volatile bool acqQuiet = false;
+volatile bool acqRxEdge = false;      // pin change on RX (PD0) since the last look
+QuietStats quietStats;
+uint32_t floorQ8[2] = { 0xFFFFFFFFUL, 0xFFFFFFFFUL }; // lowest window mean square, normal / quiet
+
+// ----- Spectrogram waterfall ('w') -----
+// Sampling runs without stopping; the ADC ISR drops 8-bit samples into a ring
+// of WF_BLOCKS blocks. loop() runs a 32-point FFT on every finished block and
+// sums the power per bin; every WF_ROW_MS the sums become one new row on top
+// (16 bins x 8 px, low pitch on the left) and the picture scrolls down one
+// pixel: the panel's start line moves, no framebuffer (Waterfall.h). The ring
+// covers ~38 ms, longer than any loop() pass.
+const uint8_t WF_BLOCKS = 6;
+const unsigned long WF_ROW_MS = 100;    // 10 rows per second
+
+bool wfOn = false;
+volatile bool wfStreaming = false;      // ADC ISR feeds the ring instead of the window sums
+uint8_t wfRing[WF_BLOCKS * WF_N];
+volatile uint8_t wfHead = 0;            // next sample slot (ISR)
+volatile uint8_t wfReady = 0;           // finished blocks not yet processed
+volatile uint16_t wfDropped = 0;        // blocks lost because the ring was full
+uint8_t wfTail = 0;                     // next block to process (loop)
+WfSpectrum wfSpectrum;                  // power sums of the current row
+WfScroll wfScroll;                      // start line ring of the panel
+unsigned long wfLastRow = 0;
+unsigned long wfStartMs = 0;
+
+// ----- Serial line input -----
+// Filled a byte at a time from loop() (SerialCalibration.h)
+LineReader<16> serialLine;
+
+// ----- Calibration state machine -----
+// 'c' -> CAL_MEASURE: the next CAL_SAMPLES samples are averaged while
+// the meter keeps running; CAL_WAIT_SPL then waits for the phone SPL line,
+// also without stopping the meter. Waterfall and benchmark wait until the
+// measurement is done (they would stop it).
+Calibration cal;
+const uint32_t CAL_SAMPLES = SAMPLE_RATE * 6 / 5;   // 1.2 s, about the old 3 x 400 ms
+float calDbfsRef = 0.0f;
+unsigned long calMsgUntil = 0;        // "saved" banner on the meter until then
+
+// ----- Time weighting, Lmax/Lmin and Leq -----
+// loop() takes whatever the ADC ISR summed since the last call (at least
+// LEVEL_CHUNK_SAMPLES) and steps the exponential integrators by exactly that
+// many samples:  y = x + (y - x) * exp(-n / (tau * rate)), with the factor
+// from a Q15 table per time constant (LevelMath.h), no float math.
+// Fast 125 ms and Slow 1 s as in IEC 61672; Impulse rises with 35 ms and
+// falls with 1.5 s, stepped part by part (acqPartSq): averaged over a whole
+// chunk first, a 5 ms burst read up to 3 dB low (tests/ToneBurstTest.cpp
+// checks all three against the tone-burst table). Lmax/Lmin hold the extremes of the selected weighting,
+// Leq is the energy average since the last 'x' (64-bit sums: years of run time).
+enum Weighting { W_FAST, W_SLOW, W_IMPULSE, W_COUNT };
+const char WEIGHT_NAMES[W_COUNT][8] PROGMEM = { "Fast", "Slow", "Impulse" };
+typedef DecayTable<SAMPLE_RATE, 125> FastDecay;
+typedef DecayTable<SAMPLE_RATE, 1000> SlowDecay;
+typedef DecayTable<SAMPLE_RATE, 35> ImpulseRise;
+typedef DecayTable<SAMPLE_RATE, 1500> ImpulseFall;
+const uint16_t LEVEL_CHUNK_SAMPLES = SAMPLE_RATE / 50;   // 20 ms
+const unsigned long METER_FRAME_MS = 100;                 // screen refresh
+uint8_t weighting = W_FAST;
+uint32_t levelQ8[W_COUNT];            // weighted mean square, Q8 counts^2
+uint32_t chunkPartQ8[ACQ_PARTS];      // mean square per part of the last acqTake() chunk
+uint8_t chunkParts = 0;               // parts in chunkPartQ8, 0 = step Impulse by whole chunks
+bool levelsPrimed = false;            // integrators start at the first reading
+uint32_t lmaxQ8 = 0;
+uint32_t lminQ8 = 0xFFFFFFFFUL;
+uint64_t leqSumQ8 = 0;                // sum of mean square x samples
+uint64_t leqSamples = 0;
+
+// ----- Serial log (Telemetry.h): integers, sent in the background -----
+const unsigned long LOG_MS = 1500;
+const TelemetryField LOG_FIELDS[] PROGMEM = {
+  { "vrms", 6 },   // volts, in uV
+  { "dbfs", 2 },   // levels in centi-dB
+  { "spl", 2 },    // "-" until calibrated
+  { "lmax", 2 },
+  { "lmin", 2 },
+  { "leq", 2 },
+};
+const uint8_t LOG_FIELD_COUNT = sizeof(LOG_FIELDS) / sizeof(LOG_FIELDS[0]);
+Telemetry<LOG_FIELD_COUNT, 2> logQueue(LOG_FIELDS, WEIGHT_NAMES[0], sizeof(WEIGHT_NAMES[0]));
+
+// ----- Meter screen -----
+// drawMeter() formats everything the meter shows into `meter` and starts a
+// frame only when that changed. The pages are drawn from this copy, so a
+// frame sent over several loop() passes shows one consistent reading.
+struct MeterFrame {
+  char title[21];                          // title / calibration status
+  char spl[8];                             // "-120 dB" at most
+  char leq[20];                            // "Impulse  Leq -84.3"
+  char minMax[23];                         // "Max -84.3  Min -84.3"
+  int8_t face;                             // -1 blank, 0 ":)", 1 ">:("
+  uint8_t bar;                             // bar fill in px, SPL range set in Scale
+};
+MeterFrame meter;
+uint16_t meterHash = 0;                    // of the frame last started, 0 = none
+
+// ----- Second OLED at 0x3D (optional) -----
+// A screen goes out one page (128 bytes) per loop() pass, so sample chunks
+// are taken in between instead of after a whole 1 KB transfer. In mirror
+// mode PagedOled sends every page to panel B as well. In history mode panel
+// B gets one new column a second, sweeping left to right like the
+// waterfall: the panel itself holds the history, the sketch keeps none.
+const uint8_t PANEL_A_ADDR = 0x3C;
+const uint8_t PANEL_B_ADDR = 0x3D;
+enum DualMode { DUAL_OFF, DUAL_MIRROR, DUAL_HISTORY, DUAL_COUNT };
+const char DUAL_NAMES[DUAL_COUNT][8] PROGMEM = { "off", "mirror", "history" };
+const unsigned long HIST_MS = 1000;       // one history column per second
+const int16_t HIST_MIN_CDB = -8000;       // -80 dBFS = empty column, 0 dBFS = full
+bool panelB = false;                      // second panel found at boot
+uint8_t dualMode = DUAL_OFF;
+int8_t framePage = -1;                    // next page to draw and send, -1 = idle
+uint8_t histX = 0;                        // next history column on panel B
+
+// ----- Lesson statistics ('l', 'z') -----
+// Once a second the SPL (only when calibrated) is counted in a histogram of
+// 0.5 dB bins (LessonStats.h). The 16-bit totals stay in EEPROM; RAM holds
+// only the seconds per bin since the last save (160 bytes). Saved every
+// STATS_SAVE_MS and when a bin in RAM is full (EEPROM.put only writes the
+// bytes that changed), so a reset loses at most that much.
+const unsigned long STATS_SAVE_MS = 300000UL;
+const uint8_t STATS_MAGIC = 0x5C;          // 0x5A/0x5B: totals were kept in RAM
+struct StatsRecord {
+  uint8_t magic;
+  uint32_t seconds;
+  uint16_t bins[STATS_BINS];
+};
+struct SavedBins {
+  static int addr(uint8_t bin) { return STATS_EEPROM_ADDR + offsetof(StatsRecord, bins) + bin * sizeof(uint16_t); }
+  uint16_t get(uint8_t bin) const {
+    uint16_t n;
+    EEPROM.get(addr(bin), n);
+    return n;
+  }
+  void set(uint8_t bin, uint16_t n) const { EEPROM.put(addr(bin), n); }
+};
+LessonStats<SavedBins> stats;
+bool statsPage = false;                    // OLED shows the summary instead of the meter
+
+// ----- Auto range ('a') -----
+// With the 5 V reference a quiet room moves the ADC by only a few counts.
+// In auto range, quiet sound is read through A1 against the internal 1.1 V
+// reference instead: 4.5x finer steps. The 1.1 V reference cannot take the
+// module's 2.5 V bias, so A1 gets the mic AC-coupled and re-biased to ~0.55 V
+// (see the wiring at the top). When the peak on A1 gets near its limit the
+// meter goes back to A0 / 5 V at once; it goes down to A1 again after
+// RANGE_HOLD_SAMPLES of peaks that would fit. After a switch the reference
+// (and the AREF capacitor) must settle, so the first samples are dropped.
+// A1 mean squares are scaled to A0 counts (rangeScaleQ16), so dBFS, SPL,
+// Lmax/Lmin and Leq run on across a switch (tests/AutoRangeTest.cpp ramps a
+// tone up and down through both switches). Continuous sampling only: quiet
+// mode ('n') and the waterfall stay on A0.
+const uint8_t MIC_LOW_PIN = A1;
+const float VREF_LOW_VOLTS = 1.1f;
+enum AdcRange { RANGE_HIGH, RANGE_LOW };
+const uint16_t RANGE_UP_PEAK = 480;          // A1 counts from the bias: close to clipping
+const uint16_t RANGE_DOWN_PEAK = 80;         // A0 counts: ~370 on A1, room for a jump
+const uint16_t RANGE_HOLD_SAMPLES = SAMPLE_RATE / 2;  // 0.5 s quiet before going down
+const uint16_t RANGE_SETTLE_LOW = SAMPLE_RATE / 40;   // 25 ms: AREF pin falls 5 V -> 1.1 V
+const uint16_t RANGE_SETTLE_HIGH = SAMPLE_RATE / 500; // 2 ms: AVCC drives it back up
+const uint8_t RANGE_MAGIC = 0xA1;
+struct RangeRecord {
+  uint8_t magic;
+  int16_t lowTrimCdb;                        // A1 calibration relative to A0
+};
+
+static_assert(BENCH_EEPROM_ADDR + sizeof(BenchRecord) <= STATS_EEPROM_ADDR, "BenchRecord runs into the stats");
+static_assert(STATS_EEPROM_ADDR + sizeof(StatsRecord) <= RANGE_EEPROM_ADDR, "StatsRecord runs into the range record");
+static_assert(RANGE_EEPROM_ADDR + sizeof(RangeRecord) <= CALIB_EEPROM_ADDR, "RangeRecord runs into the calibration");
+static_assert(CALIB_EEPROM_ADDR + sizeof(CalibRecord) <= EEPROM_BYTES, "CalibRecord is past the end of the EEPROM");
+bool autoRange = false;
+uint8_t adcRange = RANGE_HIGH;
+int16_t rangeDc[2] = { 512, 512 };           // acqDc kept per input
+uint16_t rangeQuiet = 0;                     // samples with a small peak, on A0
+uint16_t rangeSwitches = 0;                  // since the last 'a'
+int16_t lowTrimCdb = 0;
+uint32_t rangeScaleQ16;                      // A1 mean square -> A0 counts^2, Q16
+uint16_t acqChunkPeak = 0;                   // peak of the last acqTake() chunk
+volatile uint16_t acqPeak = 0;               // largest |sample - acqDc| so far
+volatile uint16_t acqSkip = 0;               // samples still to drop after a switch
+
 // ---- Forward declarations ----
 void showHiSplash();
 void screenFlashTest();
 void printHelp();
 void loadCalibration();
 void saveCalibration();
-float measureVrmsMs(unsigned long windowMs);
-void drawMeter(float spl, float dbfs);
+uint32_t measureMeanSquareMs(unsigned long windowMs);
+bool acqTake(uint16_t minSamples, uint32_t *msQ8, uint16_t *n);
+uint32_t acqMeanSquare(uint16_t samples, uint16_t triggers, int32_t sum, uint32_t sumSquares);
+void acqParts(uint16_t samples, int32_t sum);
+void levelsUpdate(uint32_t msQ8, uint16_t n);
+void levelsReset();
+int16_t levelCdb(uint32_t msQ8);
+bool pollSerialLine();
+void handleLine(char *line);
+void calibrationFeed(uint32_t msQ8, uint16_t n);
+void calibrationAnswer(const char *line);
+int16_t msToDbfsCdb(uint32_t msQ8);
+void drawMeter(int16_t splCdb);
+bool i2cProbe(uint8_t addr);
+void frameStart();
+void frameStep();
+void drawMeterStrip(uint8_t page);
+void panelClear(uint8_t addr);
+void histPush(int16_t dbfsCdb);
+void formatCdb(int16_t cdb, char *out);
+void acqInit();
+void acqStart(uint16_t samples);
+void acqStop();
+void acqRunQuiet(uint16_t samples);
+void printAcqStats();
+void benchRun(uint32_t *cycles);
+void benchCommand(bool keep);
+void wfStart();
+void wfStop();
+void wfStep();
+void statsLoad();
+void statsReset();
+void statsSave();
+void statsReport();
+void drawStatsStrip(uint8_t page);
+void rangeSet(uint8_t range);
+void rangeStep(uint16_t peak, uint16_t n);
+void rangeSetTrim(int16_t trimCdb);
+void rangeLoad();
 
 void setup() {
   Serial.begin(115200);
   delay(50);
   Serial.println(F("Decibel meter starting... (Serial calibration)"));
 
-  // OLED init (try 0x3C then 0x3D)
-  if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
-    Serial.println(F("[WARN] OLED not found at 0x3C, trying 0x3D..."));
-    if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3D)) {
-      Serial.println(F("[ERROR] OLED not found at 0x3D either. Halt."));
-      for (;;) {}
-    } else {
-      Serial.println(F("[INFO] OLED initialized at 0x3D"));
-    }
-  } else {
-    Serial.println(F("[INFO] OLED initialized at 0x3C"));
+  // OLED init: probe 0x3C and 0x3D; with both present 0x3D is panel B.
+  // begin() only sends the init sequence, so panel B is initialised first
+  // and the object is left talking to panel A.
+  Wire.begin();
+  bool atA = i2cProbe(PANEL_A_ADDR);
+  bool atB = i2cProbe(PANEL_B_ADDR);
+  if (!atA && !atB) {
+    Serial.println(F("[ERROR] OLED not found at 0x3C or 0x3D. Halt."));
+    for (;;) {}
   }
+  panelB = atA && atB;
+  if (panelB) display.begin(PANEL_B_ADDR);
+  display.begin(atA ? PANEL_A_ADDR : PANEL_B_ADDR);
+  Serial.println(atA ? F("[INFO] OLED initialized at 0x3C") : F("[INFO] OLED initialized at 0x3D"));
+  if (panelB) Serial.println(F("[INFO] Second OLED at 0x3D ('d' to use it)"));
+
+  acqInit();
 
   // quick visual checks
   showHiSplash();
@@ -77,160 +435,334 @@ void setup() {
   } else {
     Serial.println(F("[INFO] No valid calibration in EEPROM. Use 'c' to calibrate."));
   }
+  statsLoad();
+  rangeLoad();
 
   // initial user hint on OLED
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
-  display.setCursor(6, 18);
-  display.print("Open Serial @115200");
-  display.setCursor(6, 34);
-  display.print("Type 'c' to calibrate");
-  display.display();
+  display.firstPage();
+  do {
+    display.setTextSize(1);
+    display.setTextColor(SSD1306_WHITE);
+    display.setCursor(6, 18);
+    display.print(F("Open Serial @115200"));
+    display.setCursor(6, 34);
+    display.print(F("Type 'c' to calibrate"));
+  } while (display.nextPage());
   delay(900);
 
   printHelp();
 }
 
 void loop() {
-  // Handle serial commands (non-blocking read)
-  if (Serial.available()) {
-    String cmd = Serial.readStringUntil('\n');
-    cmd.trim();
-    if (cmd.length() == 0) { /* ignore empty */ }
-    else if (cmd.equalsIgnoreCase("c")) {
-      Serial.println(F("\n[CMD] Calibration started..."));
-      Serial.println(F("Place phone playing steady tone/noise near mic."));
-      // take multiple passes for stability
-      const int passes = 3;
-      float accVrms = 0.0f;
-      for (int i = 0; i < passes; i++) {
-        float vr = measureVrmsMs(400); // 400 ms -> ~1.2s total
-        accVrms += vr;
-        Serial.print(F("  meas Vrms: "));
-        Serial.print(vr, 6);
-        Serial.println(F(" V"));
-      }
-      float vrefMeas = accVrms / (float)passes;
-      if (vrefMeas < 1e-6f) vrefMeas = 1e-6f; // avoid zeros
-
-      float dbfs_ref = 20.0f * log10(vrefMeas / VREF_VOLTS);
-      Serial.print(F("\nMeasured Vrms (avg) = "));
-      Serial.print(vrefMeas, 6);
-      Serial.println(F(" V"));
-      Serial.print(F("Measured dBFS = "));
-      Serial.print(dbfs_ref, 3);
-      Serial.println(F(" dBFS"));
-
-      Serial.println(F("\nType PHONE app SPL (e.g., 75.5) then Enter, or type 'skip' to cancel:"));
-      // wait for user input (blocking is fine here)
-      while (!Serial.available()) { delay(10); }
-      String sval = Serial.readStringUntil('\n');
-      sval.trim();
-      if (sval.equalsIgnoreCase("skip")) {
-        Serial.println(F("[INFO] Calibration canceled."));
-      } else {
-        float phoneSPL = sval.toFloat();
-        if (phoneSPL == 0.0f && sval != "0" && sval != "0.0") {
-          Serial.println(F("[ERROR] Invalid number. Calibration aborted."));
-        } else {
-          CALIB_OFFSET = phoneSPL - dbfs_ref;
-          calibLoaded = true;
-          saveCalibration();
-          Serial.print(F("[OK] Calibration saved. CALIB_OFFSET = "));
-          Serial.println(CALIB_OFFSET, 4);
-
-          // brief OLED feedback
-          display.clearDisplay();
-          display.setTextSize(1);
-          display.setCursor(6, 8);
-          display.print("Calibration saved:");
-          display.setCursor(6, 28);
-          display.print("offset = ");
-          display.print(CALIB_OFFSET, 2);
-          display.display();
-          delay(1400);
-        }
-      }
-      printHelp();
-    }
-    else if (cmd.equalsIgnoreCase("s")) {
-      if (calibLoaded) {
-        saveCalibration();
-        Serial.println(F("[OK] Calibration saved to EEPROM."));
-      } else {
-        Serial.println(F("[ERR] No calibration to save."));
-      }
-      printHelp();
+  PROF_PERIOD(LOOP);
+  PROF_FOLD();          // bucket the stage times of the last pass
+
+  // Handle serial commands: bytes are collected as they arrive, never waited for
+  if (pollSerialLine()) handleLine(serialLine.buf);
+
+  // Log bytes that fit in the UART buffer right now
+  PROF_BEGIN(LOG);
+  logQueue.pump(Serial);
+  PROF_END(LOG);
+
+  if (wfOn) {         // waterfall screen replaces the meter until 'w' again
+    wfStep();
+    return;
+  }
+
+  // One page of the screen per pass, sample chunks are taken in between
+  if (framePage >= 0) frameStep();
+
+  // Sampling never stops: take what the ISR summed since the last pass.
+  // Quiet mode sleeps through whole windows instead (gaps between them).
+  uint32_t msQ8;
+  uint16_t n;
+  PROF_BEGIN(SAMPLE);
+  if (acqQuiet) {
+    n = SAMPLE_WINDOW_MS * SAMPLE_RATE / 1000UL;
+    msQ8 = measureMeanSquareMs(SAMPLE_WINDOW_MS);
+    chunkParts = 0;
+  } else {
+    if (acqDone) acqStart(0);   // (re)start continuous sampling
+    if (!acqTake(LEVEL_CHUNK_SAMPLES, &msQ8, &n)) return;
+    if (autoRange) rangeStep(acqChunkPeak, n);   // next chunk on the other input
+  }
+  PROF_END(SAMPLE);
+
+  PROF_BEGIN(MATH);
+  levelsUpdate(msQ8, n);
+  PROF_END(MATH);
+
+  if (cal.state == CAL_MEASURE) calibrationFeed(msQ8, n);
+
+  // new frame only once the previous one is fully on both panels
+  static unsigned long lastFrame = 0;
+  if (millis() - lastFrame >= METER_FRAME_MS && framePage < 0) {
+    lastFrame = millis();
+    if (!statsPage) drawMeter(levelCdb(levelQ8[weighting]));
+  }
+
+  static unsigned long lastHist = 0;
+  if (millis() - lastHist >= HIST_MS) {
+    lastHist = millis();
+    histPush(msToDbfsCdb(levelQ8[weighting]));
+    if (calibLoaded && stats.add(levelCdb(levelQ8[weighting]))) statsSave();
+    if (statsPage && framePage < 0) frameStart();
+  }
+
+  static unsigned long lastStatsSave = 0;
+  if (millis() - lastStatsSave >= STATS_SAVE_MS) {
+    lastStatsSave = millis();
+    statsSave();
+  }
+
+  // occasional serial log: only queued here, pump() above sends it
+  static unsigned long lastLog = 0;
+  if (millis() - lastLog > LOG_MS) {
+    lastLog = millis();
+    uint32_t levelMsQ8 = levelQ8[weighting];
+    int16_t dbfsCdb = msToDbfsCdb(levelMsQ8);
+    int32_t v[LOG_FIELD_COUNT];
+    v[0] = (int32_t)((isqrt32(levelMsQ8 < 0x10000000UL ? levelMsQ8 << 4 : 0xFFFFFFFUL) * UV_PER_64TH_Q8) >> 8);
+    v[1] = dbfsCdb;
+    v[2] = calibLoaded ? dbfsCdb + calibCdb : TELEMETRY_NONE;
+    v[3] = levelCdb(lmaxQ8);
+    v[4] = levelCdb(lminQ8);
+    v[5] = levelCdb(leqSamples ? leqSumQ8 / leqSamples : 0);
+    logQueue.push(lastLog, weighting, v);
+  }
+}
+
+// ---------- Serial commands ----------
+
+// Feed the bytes that arrived into serialLine; true once a complete,
+// non-empty line is there (the rest waits for the next pass).
+bool pollSerialLine() {
+  while (Serial.available()) {
+    uint8_t r = serialLine.feed(Serial.read());
+    if (r == LINE_TOO_LONG) Serial.println(F("[ERR] Line too long."));
+    if (r == LINE_READY) return true;
+  }
+  return false;
+}
+
+void handleLine(char *line) {
+  uint8_t route = cal.route(line);
+  if (route == CAL_ROUTE_ANSWER) {
+    calibrationAnswer(line);
+    return;
+  }
+  if (route == CAL_ROUTE_CANCEL) {
+    cal.state = CAL_IDLE;
+    Serial.println(F("[INFO] Calibration canceled."));
+    return;
+  }
+  if (route == CAL_ROUTE_BUSY) {
+    Serial.println(F("[ERR] Calibrating: wait for the SPL prompt or type 'skip'."));
+    return;
+  }
+
+  char cmd = (line[1] == '\0') ? tolower(line[0]) : '?';
+  if (wfOn && (cmd == 'c' || cmd == 'b' || cmd == 'k' || cmd == 'l')) {
+    Serial.println(F("[ERR] Leave the waterfall ('w') first."));
+    return;
+  }
+  if (cmd == 'w') {
+    if (wfOn) wfStop();
+    else wfStart();
+  }
+  else if (cmd == 'm') {
+    weighting = (weighting + 1) % W_COUNT;
+    lmaxQ8 = 0;
+    lminQ8 = 0xFFFFFFFFUL;
+    char name[8];
+    strcpy_P(name, WEIGHT_NAMES[weighting]);
+    Serial.print(F("[OK] Time weighting: "));
+    Serial.println(name);
+  }
+  else if (cmd == 'd') {
+    if (!panelB) {
+      Serial.println(F("[ERR] No second OLED at 0x3D."));
+    } else {
+      dualMode = (dualMode + 1) % DUAL_COUNT;
+      display.mirrorTo(dualMode == DUAL_MIRROR ? PANEL_B_ADDR : 0);
+      if (dualMode != DUAL_MIRROR) panelClear(PANEL_B_ADDR);
+      histX = 0;                  // history starts again at the left edge
+      frameStart();   // both panels get the current screen
+      char name[8];
+      strcpy_P(name, DUAL_NAMES[dualMode]);
+      Serial.print(F("[OK] Second OLED: "));
+      Serial.println(name);
     }
-    else if (cmd.equalsIgnoreCase("r")) {
-      // clear calibration (mark invalid in EEPROM)
-      calibLoaded = false;
-      CALIB_OFFSET = 0.0f;
-      float nanMark = NAN;
-      EEPROM.put(EEPROM_ADDR, nanMark); // write invalid marker
-      Serial.println(F("[OK] Calibration cleared from EEPROM."));
-      printHelp();
+  }
+  else if (cmd == 'u') {
+    ramReport(Serial);
+  }
+  else if (cmd == 'l') {
+    statsReport();
+    statsPage = !statsPage;
+    frameStart();   // the other screen, page by page
+  }
+  else if (cmd == 'z') {
+    statsReset();
+    Serial.println(F("[OK] New lesson: statistics cleared."));
+  }
+  else if (cmd == 'x') {
+    levelsReset();
+    Serial.println(F("[OK] Lmax, Lmin and Leq reset."));
+  }
+  else if (cmd == 'c') {
+    Serial.println(F("\n[CMD] Calibration started..."));
+    Serial.println(F("Place phone playing steady tone/noise near mic."));
+    cal.start(CAL_SAMPLES);
+  }
+  else if (cmd == 's') {
+    if (calibLoaded) {
+      saveCalibration();
+      Serial.println(F("[OK] Calibration saved to EEPROM."));
+    } else {
+      Serial.println(F("[ERR] No calibration to save."));
     }
-    else if (cmd.equalsIgnoreCase("p")) {
-      Serial.print(F("[INFO] CALIB_OFFSET = "));
-      if (calibLoaded) Serial.println(CALIB_OFFSET, 4);
-      else Serial.println(F("not set"));
-      printHelp();
+    printHelp();
+  }
+  else if (cmd == 'r') {
+    // clear calibration (mark invalid in EEPROM)
+    calibLoaded = false;
+    CALIB_OFFSET = 0.0f;
+    calibCdb = 0;
+    EEPROM.update(CALIB_EEPROM_ADDR, 0xFF);   // no magic = no calibration
+    rangeSetTrim(0);
+    Serial.println(F("[OK] Calibration cleared from EEPROM."));
+    printHelp();
+  }
+  else if (cmd == 'p') {
+    Serial.print(F("[INFO] CALIB_OFFSET = "));
+    if (calibLoaded) Serial.println(CALIB_OFFSET, 4);
+    else Serial.println(F("not set"));
+    printHelp();
+  }
+  else if (cmd == 'j') {
+    printAcqStats();
+  }
+  else if (cmd == 'a') {
+    autoRange = !autoRange;
+    if (autoRange) {
+      acqQuiet = false;           // auto range needs continuous sampling
+      rangeSwitches = 0;
+      Serial.print(F("[OK] Auto range ON: quiet sound on A1 / 1.1 V, "));
+      Serial.print(20.0f * log10(VREF_VOLTS / VREF_LOW_VOLTS), 1);
+      Serial.println(F(" dB more range at the bottom"));
+    } else {
+      rangeSet(RANGE_HIGH);
+      Serial.print(F("[OK] Auto range OFF after "));
+      Serial.print(rangeSwitches);
+      Serial.println(F(" switches"));
     }
-    else {
-      Serial.println(F("[ERR] Unknown command."));
-      printHelp();
+  }
+  else if (cmd == 'n') {
+    acqQuiet = !acqQuiet;
+    if (acqQuiet && autoRange) {
+      autoRange = false;
+      rangeSet(RANGE_HIGH);
+      Serial.println(F("[INFO] Auto range off (quiet mode reads A0 only)."));
     }
+    Serial.print(F("[OK] ADC noise reduction sleep "));
+    Serial.println(acqQuiet ? F("ON (millis() pauses during conversions)") : F("OFF"));
   }
+  else if (cmd == 'b' || cmd == 'k') {
+    benchCommand(cmd == 'k');
+  }
+  else if (cmd == 't') {
+#if PROFILE_ENABLED
+    profiler.dump(Serial, PROF_NAMES[0], sizeof(PROF_NAMES[0]));
+    profiler.reset();
+#else
+    Serial.println(F("[INFO] Profiler disabled (PROFILE_ENABLED 0)."));
+#endif
+  }
+  else {
+    Serial.println(F("[ERR] Unknown command."));
+    printHelp();
+  }
+}
 
-  // Normal measurement
-  float vrms = measureVrmsMs(SAMPLE_WINDOW_MS);
-  if (vrms < 1e-6f) vrms = 1e-6f;
-  float dbfs = 20.0f * log10(vrms / VREF_VOLTS);
-  float spl = dbfs + CALIB_OFFSET;
+// Samples taken during CAL_MEASURE; after CAL_SAMPLES ask for the phone SPL
+void calibrationFeed(uint32_t msQ8, uint16_t n) {
+  if (!cal.feed(msQ8, n, adcRange)) return;
+  uint32_t calAccQ8 = cal.meanQ8();
 
-  drawMeter(spl, dbfs);
+  float vrefMeas = sqrt(calAccQ8 / 256.0) * (VREF_VOLTS / 1023.0);
+  calDbfsRef = msToDbfsCdb(calAccQ8) / 100.0f; // same table as the live reading
+  Serial.print(F("\nMeasured Vrms (avg) = "));
+  Serial.print(vrefMeas, 6);
+  Serial.println(F(" V"));
+  Serial.print(F("Measured dBFS = "));
+  Serial.print(calDbfsRef, 3);
+  Serial.println(F(" dBFS"));
 
-  // occasional serial log
-  static unsigned long lastLog = 0;
-  if (millis() - lastLog > 1500) {
-    lastLog = millis();
-    Serial.print(F("Vrms: "));
-    Serial.print(vrms, 6);
-    Serial.print(F(" V, dBFS: "));
-    Serial.print(dbfs, 2);
-    Serial.print(F(" dBFS, SPL: "));
-    if (calibLoaded) Serial.println(spl, 2);
-    else Serial.println(F("N/A (not calibrated)"));
-  }
+  Serial.println(F("\nType PHONE app SPL (e.g., 75.5) then Enter, or type 'skip' to cancel:"));
+  Serial.println(F("(the meter keeps running while you type)"));
+}
 
-  delay(80);
+void calibrationAnswer(const char *line) {
+  cal.state = CAL_IDLE;
+  if (!strcasecmp_P(line, PSTR("skip"))) {
+    Serial.println(F("[INFO] Calibration canceled."));
+  } else {
+    float phoneSPL;
+    if (!calParseSpl(line, &phoneSPL)) {
+      Serial.println(F("[ERROR] Invalid number. Calibration aborted."));
+    } else if (cal.ranges == (1 << RANGE_LOW | 1 << RANGE_HIGH)) {
+      Serial.println(F("[ERROR] Range switched while measuring. Use a steadier sound and 'c' again."));
+    } else if (cal.ranges == 1 << RANGE_LOW && calibLoaded) {
+      // measured on A1 only: the A0 offset stays, A1 gets a trim on top
+      rangeSetTrim(lowTrimCdb + (int16_t)lround((phoneSPL - calDbfsRef) * 100.0f) - calibCdb);
+      Serial.print(F("[OK] A1 (1.1 V) range trim saved: "));
+      Serial.print(lowTrimCdb / 100.0f, 2);
+      Serial.println(F(" dB"));
+      calMsgUntil = millis() + 1400;
+    } else {
+      if (cal.ranges == 1 << RANGE_LOW) {   // no A0 offset yet: this one is for both
+        calDbfsRef -= lowTrimCdb / 100.0f;
+        rangeSetTrim(0);
+      }
+      CALIB_OFFSET = phoneSPL - calDbfsRef;
+      calibCdb = (int16_t)lround(CALIB_OFFSET * 100.0f);
+      calibLoaded = true;
+      saveCalibration();
+      Serial.print(F("[OK] Calibration saved. CALIB_OFFSET = "));
+      Serial.println(CALIB_OFFSET, 4);
+      calMsgUntil = millis() + 1400; // brief OLED feedback in the meter title
+    }
+  }
+  printHelp();
 }
 
 // ---------- Helper implementations ----------
 
 void showHiSplash() {
-  display.clearDisplay();
   display.setTextColor(SSD1306_WHITE);
   display.setTextSize(4);
   int16_t x1, y1; uint16_t w, h;
   display.getTextBounds("Hi", 0, 0, &x1, &y1, &w, &h);
   int16_t cx = (SCREEN_WIDTH - w) / 2;
   int16_t cy = (SCREEN_HEIGHT - h) / 2;
-  display.setCursor(cx, cy);
-  display.print("Hi");
-  display.display();
+  display.firstPage();
+  do {
+    display.setCursor(cx, cy);
+    display.print(F("Hi"));
+  } while (display.nextPage());
   delay(2000);
 }
 
 void screenFlashTest() {
-  display.clearDisplay();
-  display.fillRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, SSD1306_WHITE);
-  display.display();
+  display.firstPage();
+  do {
+    display.fillRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, SSD1306_WHITE);
+  } while (display.nextPage());
   delay(250);
-  display.clearDisplay();
-  display.display();
+  display.firstPage();
+  while (display.nextPage()) {}   // blank pages
   delay(120);
 }
 
@@ -241,6 +773,19 @@ void printHelp() {
   Serial.println(F("  s  - save current calibration to EEPROM"));
   Serial.println(F("  r  - reset/clear calibration"));
   Serial.println(F("  p  - print current calibration value"));
+  Serial.println(F("  t  - print loop stage timings (then reset them)"));
+  Serial.println(F("  j  - print sampling rate, jitter, noise floor, sleep duty (then reset)"));
+  Serial.println(F("  n  - toggle ADC noise reduction sleep sampling"));
+  Serial.println(F("  b  - benchmark hot functions, compare with baseline"));
+  Serial.println(F("  k  - benchmark and keep the result as baseline"));
+  Serial.println(F("  w  - toggle spectrogram waterfall screen"));
+  Serial.println(F("  m  - next time weighting Fast/Slow/Impulse"));
+  Serial.println(F("  x  - reset Lmax, Lmin and Leq"));
+  Serial.println(F("  d  - second OLED (0x3D): off / mirror / level history"));
+  Serial.println(F("  u  - RAM use and stack high-water mark"));
+  Serial.println(F("  l  - lesson L10/L50/L90 and time above 70 dB (OLED page on/off)"));
+  Serial.println(F("  z  - start a new lesson (clear the statistics)"));
+  Serial.println(F("  a  - auto range: quiet sound via A1 and the 1.1 V reference"));
   Serial.println();
   Serial.println(F("Calibration flow:"));
   Serial.println(F("  1) On phone app play steady tone/noise and note SPL."));
@@ -250,11 +795,13 @@ void printHelp() {
 }
 
 void loadCalibration() {
-  float f;
-  EEPROM.get(EEPROM_ADDR, f);
-  // check plausible float
-  if (isfinite(f) && f > -200.0f && f < 200.0f) {
+  CalibRecord rec;
+  EEPROM.get(CALIB_EEPROM_ADDR, rec);
+  float f = rec.offset;
+  // check the magic and for a plausible float
+  if (rec.magic == CALIB_MAGIC && isfinite(f) && f > -200.0f && f < 200.0f) {
     CALIB_OFFSET = f;
+    calibCdb = (int16_t)lround(f * 100.0f);
     calibLoaded = true;
   } else {
     calibLoaded = false;
@@ -262,79 +809,905 @@ void loadCalibration() {
 }
 
 void saveCalibration() {
-  EEPROM.put(EEPROM_ADDR, CALIB_OFFSET);
+  CalibRecord rec = { CALIB_MAGIC, CALIB_OFFSET };
+  EEPROM.put(CALIB_EEPROM_ADDR, rec);
 }
 
-// RMS measurement over a window in ms
-float measureVrmsMs(unsigned long windowMs) {
-  unsigned long start = millis();
-  unsigned long samples = 0;
-  double sumSquares = 0.0;
+// Mean square over a window in ms, in ADC counts^2 scaled by 256 (Q8).
+// The window is a sample count at the exact Timer1 rate, not a millis() span.
+uint32_t measureMeanSquareMs(unsigned long windowMs) {
+  uint16_t n = (uint16_t)(windowMs * SAMPLE_RATE / 1000UL);
+  if (n == 0) n = 1;
 
-  // quick DC offset estimate (small set)
-  long dcSum = 0;
-  const uint8_t DC_N = 16;
-  for (uint8_t i = 0; i < DC_N; i++) {
-    dcSum += analogRead(MIC_PIN);
-    delayMicroseconds(200);
+  if (acqQuiet) {
+    acqRunQuiet(n);
+  } else {
+    acqStart(n);
+    unsigned long start = millis();
+    while (!acqDone) {
+      if (millis() - start > 2 * windowMs + 10) { acqStop(); break; } // ADC not running
+    }
   }
-  double dc = (double)dcSum / DC_N;
 
-  while (millis() - start < windowMs) {
-    unsigned long t0 = micros();
-    int raw = analogRead(MIC_PIN);
-    double centered = (double)raw - dc;
-    sumSquares += centered * centered;
-    samples++;
+  uint16_t samples, triggers;
+  int32_t sum;
+  uint32_t sumSquares;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    samples = acqCount;
+    triggers = acqTriggers;
+    sum = acqSum;
+    sumSquares = acqSumSq;
+  }
+  return acqMeanSquare(samples, triggers, sum, sumSquares);
+}
+
+// Continuous sampling (acqStart(0)): hand over everything summed since the
+// last call, once there are minSamples, and restart the sums in the same
+// atomic step so no sample falls between two chunks
+bool acqTake(uint16_t minSamples, uint32_t *msQ8, uint16_t *n) {
+  uint16_t samples, triggers;
+  int32_t sum;
+  uint32_t sumSquares;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    samples = acqCount;
+    if (samples < minSamples) return false;
+    triggers = acqTriggers;
+    sum = acqSum;
+    sumSquares = acqSumSq;
+    acqCount = 0;
+    acqTriggers = 0;
+    acqSum = 0;
+    acqSumSq = 0;
+    acqChunkPeak = acqPeak;
+    acqPeak = 0;
+    chunkParts = samples > ACQ_PARTS * ACQ_PART ? ACQ_PARTS : (samples + ACQ_PART - 1) >> ACQ_PART_SHIFT;
+    for (uint8_t k = 0; k < chunkParts; k++) chunkPartQ8[k] = acqPartSq[k];
+  }
+  *n = samples;
+  *msQ8 = acqMeanSquare(samples, triggers, sum, sumSquares);
+  acqParts(samples, sum);
+  return true;
+}
 
-    unsigned long dt = micros() - t0;
-    if (dt < SAMPLE_PERIOD_US) delayMicroseconds(SAMPLE_PERIOD_US - dt);
+// chunkPartQ8[] from sums of squares to mean squares about the chunk mean,
+// scaled like the chunk (a full part divides by a shift)
+void acqParts(uint16_t samples, int32_t sum) {
+  int32_t meanQ8 = (sum * 256L) / samples;
+  uint32_t dcQ8 = (uint32_t)(((int64_t)meanQ8 * meanQ8) >> 8);
+  for (uint8_t k = 0; k < chunkParts; k++) {
+    uint32_t s = chunkPartQ8[k];
+    uint16_t m = k + 1 < chunkParts ? ACQ_PART : samples - k * ACQ_PART;
+    uint32_t rawQ8 = m == ACQ_PART ? s << (8 - ACQ_PART_SHIFT) : ((s / m) << 8) + ((s % m) << 8) / m;
+    uint32_t x = rawQ8 > dcQ8 ? rawQ8 - dcQ8 : 0;
+    if (adcRange == RANGE_LOW) x = ((uint64_t)x * rangeScaleQ16 + 0x8000) >> 16;
+    chunkPartQ8[k] = x;
   }
+}
+
+// Window/chunk sums -> mean square about the mean (Q8), plus rate statistics
+uint32_t acqMeanSquare(uint16_t samples, uint16_t triggers, int32_t sum, uint32_t sumSquares) {
+  acqTotalSamples += samples;
+  acqTotalTriggers += triggers;
+  if (triggers > 0) acqEffectiveRate = ACQ_RATE_HZ * samples / triggers;
 
-  if (samples == 0) return 0.0f;
-  double meanSquare = sumSquares / (double)samples;
-  double vrms = sqrt(meanSquare) * (VREF_VOLTS / 1023.0); // ADC units -> volts
-  return (float)vrms;
+  // sums are centred on acqDc and the exact window mean is removed here;
+  // they stay in 32 bits for windows up to ~2000 samples
+  if (samples == 0) return 0;
+  uint32_t rawQ8 = ((sumSquares / samples) << 8) + ((sumSquares % samples) << 8) / samples;
+  int32_t meanQ8 = (sum * 256L) / samples;
+  uint32_t dcQ8 = (uint32_t)(((int64_t)meanQ8 * meanQ8) >> 8);
+  int16_t dcStep = (int16_t)((meanQ8 + (meanQ8 < 0 ? -128 : 128)) / 256);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {   // the ADC ISR reads acqDc: no torn 16-bit value
+    acqDc += dcStep;
+  }
+  uint32_t msQ8 = rawQ8 > dcQ8 ? rawQ8 - dcQ8 : 0;
+  if (adcRange == RANGE_LOW) msQ8 = ((uint64_t)msQ8 * rangeScaleQ16 + 0x8000) >> 16;
+  if (msQ8 < floorQ8[acqQuiet]) floorQ8[acqQuiet] = msQ8;
+  return msQ8;
 }
 
-void drawMeter(float spl, float dbfs) {
-  display.clearDisplay();
+// Step Fast/Slow/Impulse by n samples of mean square msQ8 (Impulse by the
+// chunk's parts when there are any), then Lmax/Lmin/Leq
+void levelsUpdate(uint32_t msQ8, uint16_t n) {
+  uint32_t x = msQ8;
+  if (!levelsPrimed) {
+    for (uint8_t w = 0; w < W_COUNT; w++) levelQ8[w] = x;
+    levelsPrimed = true;
+  }
+  levelQ8[W_FAST] = levelStep(levelQ8[W_FAST], x, decayFactor(FastDecay::data, n));
+  levelQ8[W_SLOW] = levelStep(levelQ8[W_SLOW], x, decayFactor(SlowDecay::data, n));
 
-  // Title
-  display.setTextSize(1);
-  display.setCursor(6, 0);
-  display.setTextColor(SSD1306_WHITE);
-  display.print("dB METER (approx)");
+  uint32_t hi = 0, lo = 0xFFFFFFFFUL;   // Impulse extremes within the chunk
+  uint8_t parts = chunkParts ? chunkParts : 1;
+  for (uint8_t k = 0; k < parts; k++) {
+    uint32_t xk = chunkParts ? chunkPartQ8[k] : x;
+    uint16_t m = !chunkParts ? n : (k + 1 < parts ? ACQ_PART : n - k * ACQ_PART);
+    uint32_t &y = levelQ8[W_IMPULSE];
+    y = levelStep(y, xk, decayFactor(xk < y ? ImpulseFall::data : ImpulseRise::data, m));
+    if (y > hi) hi = y;
+    if (y < lo) lo = y;
+  }
+
+  if (weighting != W_IMPULSE) hi = lo = levelQ8[weighting];
+  if (hi > lmaxQ8) lmaxQ8 = hi;
+  if (lo < lminQ8) lminQ8 = lo;
+  leqSumQ8 += (uint64_t)msQ8 * n;
+  leqSamples += n;
+}
+
+void levelsReset() {
+  lmaxQ8 = 0;
+  lminQ8 = 0xFFFFFFFFUL;
+  leqSumQ8 = 0;
+  leqSamples = 0;
+}
+
+// Mean square -> displayed level: SPL if calibrated, else dBFS (offset 0)
+int16_t levelCdb(uint32_t msQ8) {
+  return msToDbfsCdb(msQ8) + calibCdb;
+}
+
+// Mean square (Q8 counts^2) -> dBFS in centi-dB via the PROGMEM log table.
+// The position of the leading one gives whole 3.0103 dB steps, the next
+// LOG_BITS bits index the mantissa table (log10Cdb() in LevelMath.h).
+int16_t msToDbfsCdb(uint32_t msQ8) {
+  return log10Cdb<Scale>(msQ8) - FULL_SCALE_CDB;
+}
+
+// Format a centi-dB value with one decimal, e.g. -4523 -> "-45.2"
+void formatCdb(int16_t cdb, char *out) {
+  if (cdb < 0) { *out++ = '-'; cdb = -cdb; }
+  cdb = (cdb + 5) / 10;
+  itoa(cdb / 10, out, 10);
+  out += strlen(out);
+  *out++ = '.';
+  *out++ = '0' + cdb % 10;
+  *out = '\0';
+}
 
-  // Big SPL (if calibrated)
-  display.setTextSize(2);
-  display.setCursor(6, 14);
+// Format the meter screen into `meter`; a frame is started only when the
+// text, face or bar changed (FNV-1a hash of the whole copy)
+void drawMeter(int16_t splCdb) {
+  PROF_BEGIN(FORMAT);
+  memset(&meter, 0, sizeof(meter));   // no old bytes after the strings
+
+  // bar width and face state come from one PROGMEM byte per whole dB
+  int16_t db = (splCdb + 50) / 100;
+  if (db < Scale::minDb) db = Scale::minDb;
+  if (db > Scale::maxDb) db = Scale::maxDb;
+  uint8_t cell = pgm_read_byte(&Scale::Bar::data[db - Scale::minDb]);
+
+  // Title (doubles as calibration status)
+  char *t = meter.title;
+  if (cal.state == CAL_MEASURE) {
+    strcpy_P(t, PSTR("CAL: measuring..."));
+  } else if (cal.state == CAL_WAIT_SPL) {
+    strcpy_P(t, PSTR("CAL: type phone SPL"));
+  } else if ((long)(calMsgUntil - millis()) > 0) {
+    strcpy_P(t, PSTR("Saved, offset "));
+    formatCdb(calibCdb, t + strlen(t));
+  } else {
+    strcpy_P(t, PSTR("dB METER (approx)"));
+  }
+
+  // Big SPL and face (if calibrated)
   if (calibLoaded) {
-    display.print((int)round(spl));
-    display.print(" dB");
+    itoa((splCdb + (splCdb < 0 ? -50 : 50)) / 100, meter.spl, 10);
+    strcat_P(meter.spl, PSTR(" dB"));
   } else {
-    display.print("--- dB");
+    strcpy_P(meter.spl, PSTR("--- dB"));
   }
+  meter.face = calibLoaded ? ((cell & 0x80) ? 1 : 0) : -1;
 
-  // dBFS small
-  display.setTextSize(1);
-  display.setCursor(6, 40);
-  display.print("dBFS:");
-  display.setCursor(48, 40);
-  display.print(dbfs, 1);
+  // weighting + Leq, then Lmax/Lmin (same units as the big number)
+  strcpy_P(meter.leq, WEIGHT_NAMES[weighting]);
+  strcat_P(meter.leq, PSTR("  Leq "));
+  formatCdb(levelCdb(leqSamples ? leqSumQ8 / leqSamples : 0), meter.leq + strlen(meter.leq));
+  strcpy_P(meter.minMax, PSTR("Max "));
+  formatCdb(levelCdb(lmaxQ8), meter.minMax + strlen(meter.minMax));
+  strcat_P(meter.minMax, PSTR("  Min "));
+  formatCdb(levelCdb(lminQ8 == 0xFFFFFFFFUL ? 0 : lminQ8), meter.minMax + strlen(meter.minMax));
 
   // bar meter
-  int barX = 6, barY = 52, barW = 116, barH = 8;
-  display.drawRoundRect(barX - 1, barY - 1, barW + 2, barH + 2, 3, SSD1306_WHITE);
-
-  // map SPL to bar between 30..120 dB (tweakable)
-  float minSPL = 30.0f;
-  float maxSPL = 120.0f;
-  float pct = (spl - minSPL) / (maxSPL - minSPL);
-  if (pct < 0) pct = 0;
-  if (pct > 1) pct = 1;
-  int fill = (int)(pct * barW);
-  if (fill > 0) display.fillRect(barX, barY, fill, barH, SSD1306_WHITE);
-
-  display.display();
+  meter.bar = cell & 0x7F;
+
+  uint16_t h = 0x811C;
+  const uint8_t *p = (const uint8_t *)&meter;
+  for (uint8_t i = 0; i < sizeof(meter); i++) { h ^= p[i]; h *= 0x0193; }
+  if (h == 0) h = 1;
+  bool changed = h != meterHash;
+  meterHash = h;
+  PROF_END(FORMAT);
+
+  if (changed) frameStart();   // sent page by page from loop()
+}
+
+// true if rows y .. y + h - 1 touch this page (8 rows)
+static inline bool onPage(uint8_t page, int16_t y, int16_t h) {
+  return y < page * 8 + 8 && y + h > page * 8;
+}
+
+// The meter elements that fall on one page, from the `meter` copy
+void drawMeterStrip(uint8_t page) {
+  display.setTextColor(SSD1306_WHITE);
+  display.setTextSize(1);
+  if (onPage(page, 0, 8)) {
+    display.setCursor(6, 0);
+    display.print(meter.title);
+  }
+  if (onPage(page, 14, 16)) {
+    display.setTextSize(2);
+    display.setCursor(6, 14);
+    display.print(meter.spl);
+    if (meter.face >= 0) {
+      display.setCursor(92, 14);
+      display.print(meter.face ? F(">:(") : F(":)"));
+    }
+    display.setTextSize(1);
+  }
+  if (onPage(page, 32, 8)) {
+    display.setCursor(6, 32);
+    display.print(meter.leq);
+  }
+  if (onPage(page, 42, 8)) {
+    display.setCursor(6, 42);
+    display.print(meter.minMax);
+  }
+  if (onPage(page, 51, 10)) {
+    display.drawRoundRect(5, 51, Scale::barW + 2, 10, 3, SSD1306_WHITE);
+    if (meter.bar) display.fillRect(6, 52, meter.bar, 8, SSD1306_WHITE);
+  }
+}
+
+// ---------- Screen, page by page ----------
+// frameStart() (re)starts sending the current screen, meter or lesson page;
+// frameStep() draws and sends one page to panel A, to panel B as well in
+// mirror mode
+void frameStart() {
+  display.firstPage();
+  framePage = 0;
+}
+
+void frameStep() {
+  PROF_BEGIN(DRAW);
+  if (statsPage) drawStatsStrip(framePage);
+  else drawMeterStrip(framePage);
+  PROF_END(DRAW);
+
+  PROF_BEGIN(FLUSH);
+  Wire.setClock(400000);
+  display.nextPage();
+  PROF_END(FLUSH);
+  if (++framePage == PagedOled::PAGES) framePage = -1;
+}
+
+// ---------- Timer1-paced acquisition ----------
+
+void acqInit() {
+  // ADC: AVCC reference, mic channel, /128 clock, auto-trigger on Timer1 compare B
+  ADMUX = _BV(REFS0) | ((MIC_PIN - A0) & 0x07);
+  ADCSRB = _BV(ADTS2) | _BV(ADTS0);
+  ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  DIDR0 |= _BV(MIC_PIN - A0);   // digital input buffer off on the mic pin
+
+  // Timer1: CTC with TOP = OCR1A, no prescaler; compare B at TOP is the trigger,
+  // so TCNT1 read in the ADC ISR is the time since that sample's trigger
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS10);
+  OCR1A = ACQ_TIMER_TOP;
+  OCR1B = ACQ_TIMER_TOP;
+  TIMSK1 = 0;
+}
+
+void acqStart(uint16_t samples) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    acqTarget = samples;
+    acqCount = 0;
+    acqTriggers = 0;
+    acqSum = 0;
+    acqSumSq = 0;
+    acqPending = false;
+    acqPeak = 0;
+    acqDone = false;
+    TCNT1 = 0;
+    TIFR1 = _BV(OCF1B);
+    TIMSK1 |= _BV(OCIE1B);
+    ADCSRA |= _BV(ADIF) | _BV(ADATE) | _BV(ADIE);
+  }
+}
+
+void acqStop() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    ADCSRA &= ~(_BV(ADATE) | _BV(ADIE));
+    TIMSK1 &= ~_BV(OCIE1B);
+    acqDone = true;
+  }
+}
+
+// Sleep modes and Timer1 set-up for quietWindow() (QuietSampler.h)
+struct AcqQuietHw {
+  bool done() { return acqDone; }
+  uint16_t sinceTrigger() { return TCNT1; }
+
+  // Idle sleep keeps Timer1 running; sleep only while nothing is pending
+  void idleUntilTrigger() {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    while (!acqPending) {
+      sleep_enable();
+      sei();
+      sleep_cpu();
+      sleep_disable();
+      cli();
+    }
+    sei();
+  }
+
+  // Entering ADC Noise Reduction sleep starts the conversion. With RX already
+  // busy the conversion is started awake instead.
+  void convertAsleep() {
+    set_sleep_mode(SLEEP_MODE_ADC);
+    cli();
+    if (acqRxEdge) {
+      sei();
+      ADCSRA |= _BV(ADSC);
+    } else if (acqPending) {
+      sleep_enable();
+      sei();
+      sleep_cpu();
+      sleep_disable();
+    }
+    sei();
+    while (acqPending) {}         // woken early by another source: wait for the ADC
+  }
+
+  // Auto-triggered conversion: Idle sleep until the ADC ISR has read it
+  void convertAwake() {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    while (acqPending) {
+      sleep_enable();
+      sei();
+      sleep_cpu();
+      sleep_disable();
+      cli();
+    }
+    sei();
+  }
+
+  // Sleeping: shortened period, conversion started by the sleep instruction.
+  // Awake: normal period, Timer1 compare B auto-triggers the ADC.
+  void nrTiming(bool nr) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      uint16_t top = nr ? ACQ_NR_TOP : ACQ_TIMER_TOP;
+      OCR1A = top;
+      OCR1B = top;
+      TCNT1 = 0;
+      TIFR1 = _BV(OCF1B);
+      acqPending = false;
+      if (nr) ADCSRA &= ~_BV(ADATE);
+      else ADCSRA |= _BV(ADATE);
+    }
+  }
+
+  bool rxSeen() {
+    bool seen = acqRxEdge || Serial.available();
+    acqRxEdge = false;
+    return seen;
+  }
+};
+
+// Quiet window: idle until each Timer1 trigger, then enter ADC Noise Reduction
+// sleep, which starts the conversion with the CPU and I/O clocks stopped; the
+// ADC ISR wakes the core and adds the result to the same window sums. Serial
+// input switches to awake conversions for a while (QuietSampler.h).
+void acqRunQuiet(uint16_t samples) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    acqTarget = samples;
+    acqCount = 0;
+    acqTriggers = 0;
+    acqSum = 0;
+    acqSumSq = 0;
+    acqPending = false;
+    acqDone = false;
+    TIMSK1 |= _BV(OCIE1B);
+    ADCSRA |= _BV(ADIF) | _BV(ADIE);
+  }
+
+  PCMSK2 |= _BV(PCINT16);       // RX pin change wakes the CPU
+  PCIFR = _BV(PCIF2);
+  PCICR |= _BV(PCIE2);
+  AcqQuietHw hw;                // nrTiming() sets Timer1 and ADATE
+  quietWindow(hw, quietStats, ACQ_NR_TOP + 1, ACQ_TIMER_TOP + 1, ACQ_CONV_TICKS);
+  PCICR &= ~_BV(PCIE2);
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    OCR1A = ACQ_TIMER_TOP;
+    OCR1B = ACQ_TIMER_TOP;
+  }
+}
+
+// Wakes the CPU from ADC Noise Reduction sleep on an RX start bit
+ISR(PCINT2_vect) {
+  acqRxEdge = true;
+}
+
+// One trigger per sample period; a still-pending conversion means the previous
+// result was never read in time
+ISR(TIMER1_COMPB_vect) {
+  if (acqPending) acqOverruns++;
+  acqPending = true;
+  acqTriggers++;
+}
+
+ISR(ADC_vect) {
+  uint16_t lat = TCNT1;         // Timer1 ticks since this sample's trigger
+  uint16_t raw = ADC;
+  acqPending = false;
+  if (!acqQuiet) {              // TCNT1 is frozen during quiet conversions
+    if (lat < acqLatMin) acqLatMin = lat;
+    if (lat > acqLatMax) acqLatMax = lat;
+  }
+
+  if (wfStreaming) {            // waterfall: fill the block ring, never stop
+    wfRing[wfHead++] = raw >> 2;
+    if (wfHead % WF_N == 0) {
+      if (wfReady >= WF_BLOCKS - 1) {   // next block is still being read: drop this one
+        wfDropped++;
+        wfHead -= WF_N;
+      } else {
+        wfReady++;
+        if (wfHead == WF_BLOCKS * WF_N) wfHead = 0;
+      }
+    }
+    return;
+  }
+
+  if (acqSkip) {                // reference still settling after a range switch
+    acqSkip--;
+    return;
+  }
+  int16_t c = (int16_t)raw - acqDc;
+  uint16_t mag = c < 0 ? -c : c;
+  if (mag > acqPeak) acqPeak = mag;
+  uint32_t sq = (uint32_t)((int32_t)c * c);
+  acqSum += c;
+  acqSumSq += sq;
+  uint8_t part = ACQ_PARTS - 1;
+  if (acqCount < ACQ_PARTS * ACQ_PART) {
+    part = acqCount >> ACQ_PART_SHIFT;
+    if (!(acqCount & (ACQ_PART - 1))) acqPartSq[part] = 0;   // first sample of a part
+  }
+  acqPartSq[part] += sq;
+  if (++acqCount >= acqTarget && acqTarget != 0) {   // target 0 = continuous
+    ADCSRA &= ~(_BV(ADATE) | _BV(ADIE));
+    TIMSK1 &= ~_BV(OCIE1B);
+    acqDone = true;
+  }
+}
+
+// Configured vs delivered rate, overruns and ISR service jitter (then reset).
+// Conversion start is hardware-timed; the latency spread shows how late the
+// ISR got to each result because of other interrupts (Timer0, I2C, UART).
+void printAcqStats() {
+  uint16_t latMin, latMax, overruns;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    latMin = acqLatMin; latMax = acqLatMax; overruns = acqOverruns;
+    acqLatMin = 0xFFFF; acqLatMax = 0; acqOverruns = 0;
+  }
+  if (latMin > latMax) latMin = latMax = 0;
+
+  Serial.print(F("[ACQ] rate set "));
+  Serial.print(ACQ_RATE_HZ, 1);
+  Serial.print(F(" Hz, effective "));
+  Serial.print(acqEffectiveRate, 1);
+  Serial.println(F(" Hz"));
+  Serial.print(F("[ACQ] samples "));
+  Serial.print(acqTotalSamples);
+  Serial.print(F(" / triggers "));
+  Serial.print(acqTotalTriggers);
+  Serial.print(F(", overruns "));
+  Serial.println(overruns);
+  Serial.print(F("[ACQ] ISR latency min "));
+  Serial.print(latMin / 16.0f, 2);
+  Serial.print(F(" us, max "));
+  Serial.print(latMax / 16.0f, 2);
+  Serial.print(F(" us, jitter "));
+  Serial.print((latMax - latMin) / 16.0f, 2);
+  Serial.println(F(" us"));
+
+  // noise floor = quietest window since the last report, per mode
+  for (uint8_t q = 0; q < 2; q++) {
+    Serial.print(q ? F("[ACQ] floor (NR sleep): ") : F("[ACQ] floor (normal):   "));
+    if (floorQ8[q] == 0xFFFFFFFFUL) { Serial.println(F("n/a")); continue; }
+    Serial.print(sqrt(floorQ8[q] / 256.0), 3);
+    Serial.print(F(" counts RMS, "));
+    Serial.print(msToDbfsCdb(floorQ8[q]) / 100.0f, 2);
+    Serial.println(F(" dBFS"));
+    floorQ8[q] = 0xFFFFFFFFUL;
+  }
+
+  uint32_t total = quietStats.awakeTicks + quietStats.idleTicks + quietStats.sleepTicks;
+  if (total > 0) {
+    Serial.print(F("[ACQ] NR duty: CPU awake "));
+    Serial.print(100.0f * quietStats.awakeTicks / total, 1);
+    Serial.print(F("%, idle "));
+    Serial.print(100.0f * quietStats.idleTicks / total, 1);
+    Serial.print(F("%, ADC sleep "));
+    Serial.print(100.0f * quietStats.sleepTicks / total, 1);
+    Serial.print(F("%, "));
+    Serial.print(quietStats.rxSamples);
+    Serial.println(F(" samples awake for serial input"));
+  }
+  quietStats.awakeTicks = quietStats.idleTicks = quietStats.sleepTicks = 0;
+  quietStats.rxSamples = 0;
+  acqTotalSamples = 0;
+  acqTotalTriggers = 0;
+}
+
+// ---------- Auto range ----------
+
+// Switch input and reference between chunks. The sums restart so no chunk
+// mixes the two scales; the conversion already running and the settling
+// time are dropped in the ADC ISR (acqSkip).
+void rangeSet(uint8_t range) {
+  if (range == adcRange) return;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    rangeDc[adcRange] = acqDc;
+    adcRange = range;
+    acqDc = rangeDc[range];
+    if (range == RANGE_LOW) {
+      ADMUX = _BV(REFS1) | _BV(REFS0) | ((MIC_LOW_PIN - A0) & 0x07);
+      acqSkip = RANGE_SETTLE_LOW;
+    } else {
+      ADMUX = _BV(REFS0) | ((MIC_PIN - A0) & 0x07);
+      acqSkip = RANGE_SETTLE_HIGH;
+    }
+    acqCount = 0;
+    acqTriggers = 0;
+    acqSum = 0;
+    acqSumSq = 0;
+    acqPeak = 0;
+  }
+  rangeQuiet = 0;
+  rangeSwitches++;
+}
+
+// Called with the peak of every continuous chunk: up at once, down after a quiet hold
+void rangeStep(uint16_t peak, uint16_t n) {
+  if (adcRange == RANGE_LOW) {
+    if (peak >= RANGE_UP_PEAK) rangeSet(RANGE_HIGH);
+    // bias far from 0.55 V: A1 is not wired for auto range
+    if (acqDc < 32 || acqDc > 1023 - 32) {
+      rangeSet(RANGE_HIGH);
+      autoRange = false;
+      Serial.println(F("[ERR] A1 is not biased (see wiring at the top). Auto range off."));
+    }
+  } else if (peak < RANGE_DOWN_PEAK) {
+    rangeQuiet += n;
+    if (rangeQuiet >= RANGE_HOLD_SAMPLES) rangeSet(RANGE_LOW);
+  } else {
+    rangeQuiet = 0;
+  }
+}
+
+// A1 -> A0 scale: (1.1 V / 5 V)^2 in mean square, plus the A1 calibration trim
+void rangeSetTrim(int16_t trimCdb) {
+  lowTrimCdb = trimCdb;
+  float ratio = VREF_LOW_VOLTS / VREF_VOLTS;
+  rangeScaleQ16 = (uint32_t)(ratio * ratio * pow(10.0, trimCdb / 1000.0) * 65536.0 + 0.5);
+  RangeRecord rec = { RANGE_MAGIC, lowTrimCdb };
+  EEPROM.put(RANGE_EEPROM_ADDR, rec);
+}
+
+void rangeLoad() {
+  RangeRecord rec;
+  EEPROM.get(RANGE_EEPROM_ADDR, rec);
+  rangeSetTrim(rec.magic == RANGE_MAGIC ? rec.lowTrimCdb : 0);
+}
+
+// ---------- Kernel benchmark ----------
+#ifdef __AVR__
+extern char __data_load_end;   // end of the flash image (code + initialised data)
+#endif
+
+// Cycles per call of every kernel, fixed inputs so runs are comparable
+void benchRun(uint32_t *cycles) {
+  static volatile int32_t sink;   // keeps results from being optimised away
+  char buf[8];
+  bool quiet = acqQuiet;
+  acqQuiet = false;               // micros() stops while the CPU sleeps
+
+  for (uint8_t k = 0; k < BENCH_COUNT; k++) {
+    uint8_t calls = pgm_read_byte(&BENCH_CALLS[k]);
+    if (k == BENCH_DRAW_SAME) drawMeter(7250);   // the frame now holds these values
+    unsigned long t0 = micros();
+    for (uint8_t i = 0; i < calls; i++) {
+      switch (k) {
+        case BENCH_DBFS:      sink += msToDbfsCdb(((uint32_t)i << 16) + 257); break;
+        case BENCH_FORMAT:    formatCdb(-4523 + i, buf); sink += buf[1]; break;
+        case BENCH_DRAW_SAME: drawMeter(7250); break;
+        case BENCH_FRAME:     frameStart(); while (framePage >= 0) frameStep(); break;
+        case BENCH_SAMPLE:    sink += measureMeanSquareMs(SAMPLE_WINDOW_MS); break;
+        case BENCH_PROF_END: {
+          uint16_t _prof_LOG = profNow() - 25000;   // began 100 ms ago
+          PROF_END(LOG);
+          sink += i;
+          break;
+        }
+      }
+    }
+    cycles[k] = (micros() - t0) * (F_CPU / 1000000UL) / calls;
+  }
+
+  acqQuiet = quiet;
+#if PROFILE_ENABLED
+  profiler.reset();               // the profEnd probes are not real stages
+#endif
+  meterHash = 0;                  // live meter is sent again next frame
+}
+
+// One JSON object: cycles per call, baseline and regression flag per kernel
+void benchCommand(bool keep) {
+  BenchRecord base;
+  EEPROM.get(BENCH_EEPROM_ADDR, base);
+  bool haveBase = base.magic == BENCH_MAGIC;
+
+  uint32_t cycles[BENCH_COUNT];
+  benchRun(cycles);
+
+  char name[12];
+  Serial.print(F("{\"bench\":["));
+  for (uint8_t k = 0; k < BENCH_COUNT; k++) {
+    strcpy_P(name, BENCH_NAMES[k]);
+    if (k) Serial.print(',');
+    Serial.print(F("{\"kernel\":\""));
+    Serial.print(name);
+    Serial.print(F("\",\"calls\":"));
+    Serial.print(pgm_read_byte(&BENCH_CALLS[k]));
+    Serial.print(F(",\"cycles\":"));
+    Serial.print(cycles[k]);
+    if (haveBase) {
+      bool slower = cycles[k] * 100UL > base.cycles[k] * (100UL + BENCH_REGRESS_PCT);
+      Serial.print(F(",\"base\":"));
+      Serial.print(base.cycles[k]);
+      Serial.print(F(",\"regress\":"));
+      Serial.print(slower ? F("true") : F("false"));
+    }
+    Serial.print('}');
+  }
+  Serial.print(']');
+#ifdef __AVR__
+  Serial.print(F(",\"flash\":"));
+  Serial.print((unsigned long)(size_t)&__data_load_end);
+  Serial.print(F(",\"sram_free\":"));
+  Serial.print(ramFree());
+  Serial.print(F(",\"sram_min_free\":"));
+  Serial.print(ramMinFree());
+#endif
+  Serial.println('}');
+
+  if (keep) {
+    base.magic = BENCH_MAGIC;
+    for (uint8_t k = 0; k < BENCH_COUNT; k++) base.cycles[k] = cycles[k];
+    EEPROM.put(BENCH_EEPROM_ADDR, base);
+    Serial.println(F("[OK] Benchmark baseline saved to EEPROM."));
+  }
+}
+
+// ---------- Spectrogram waterfall ----------
+void wfStart() {
+  rangeSet(RANGE_HIGH);   // the waterfall reads A0; auto range resumes after 'w'
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    wfHead = 0;
+    wfReady = 0;
+    wfDropped = 0;
+    wfStreaming = true;
+  }
+  wfTail = 0;
+  wfSpectrum.clear();
+  wfScroll.reset();
+  wfStartMs = wfLastRow = millis();
+  framePage = -1;                 // a half-sent frame is dropped
+  display.firstPage();
+  while (display.nextPage()) {}   // blank screen
+  display.startLine(0);
+  acqStart(0xFFFF);   // Timer1 pacing as usual; the target is ignored while streaming
+  wfOn = true;
+  Serial.println(F("[OK] Waterfall on ('w' to leave)."));
+}
+
+void wfStop() {
+  acqStop();
+  wfStreaming = false;
+  wfOn = false;
+  display.startLine(0);   // normal screens again
+  meterHash = 0;          // meter is sent again next frame
+  unsigned long ms = millis() - wfStartMs;
+  Serial.print(F("[OK] Waterfall off: "));
+  Serial.print(wfScroll.rows);
+  Serial.print(F(" rows in "));
+  Serial.print(ms / 1000.0f, 1);
+  Serial.print(F(" s = "));
+  Serial.print(ms ? wfScroll.rows * 1000.0f / ms : 0.0f, 2);
+  Serial.print(F(" rows/s, dropped blocks: "));
+  Serial.println(wfDropped);
+}
+
+// Work through every finished block, then add a row when one is due
+void wfStep() {
+  while (wfReady) {
+    wfSpectrum.block(&wfRing[wfTail * WF_N]);
+    if (++wfTail == WF_BLOCKS) wfTail = 0;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { wfReady--; }
+  }
+
+  if (millis() - wfLastRow >= WF_ROW_MS && wfSpectrum.blocks > 0) {
+    wfLastRow += WF_ROW_MS;
+    PROF_BEGIN(DRAW);
+    uint8_t page = wfScroll.add(wfSpectrum, display.buffer());
+    PROF_END(DRAW);
+    PROF_BEGIN(FLUSH);
+    display.sendPageBuffer(page);
+    display.startLine(wfScroll.line);
+    PROF_END(FLUSH);
+  }
+}
+
+// ---------- Second OLED ----------
+// true if a device ACKs its address
+bool i2cProbe(uint8_t addr) {
+  Wire.beginTransmission(addr);
+  return Wire.endTransmission() == 0;
+}
+
+// Blank a whole panel (mirror pages come from PagedOled itself).
+// 16 data bytes per I2C transaction.
+void panelClear(uint8_t addr) {
+  for (uint8_t page = 0; page < PagedOled::PAGES; page++) {
+    Wire.beginTransmission(addr);
+    Wire.write((uint8_t)0x00);                 // command stream
+    Wire.write((uint8_t)SSD1306_COLUMNADDR);
+    Wire.write((uint8_t)0);
+    Wire.write((uint8_t)(SCREEN_WIDTH - 1));
+    Wire.write((uint8_t)SSD1306_PAGEADDR);
+    Wire.write(page);
+    Wire.write(page);
+    Wire.endTransmission();
+
+    for (uint8_t x = 0; x < SCREEN_WIDTH; x += 16) {
+      Wire.beginTransmission(addr);
+      Wire.write((uint8_t)0x40);               // data stream
+      for (uint8_t n = 0; n < 16; n++) Wire.write((uint8_t)0);
+      Wire.endTransmission();
+    }
+  }
+}
+
+// One history column on panel B (history mode only): level in dBFS ->
+// 0..64 px bar from the bottom, then a blank column as the sweep edge
+void histPush(int16_t dbfsCdb) {
+  if (dualMode != DUAL_HISTORY) return;
+  int32_t h = (int32_t)(dbfsCdb - HIST_MIN_CDB) * SCREEN_HEIGHT / -HIST_MIN_CDB;
+  uint8_t col[PagedOled::PAGES];
+  for (uint8_t page = 0; page < PagedOled::PAGES; page++) {
+    // rows at or below 64 - height are lit
+    int32_t top = SCREEN_HEIGHT - h - page * 8;
+    col[page] = top <= 0 ? 0xFF : (top >= 8 ? 0 : (uint8_t)(0xFF << top));
+  }
+  display.sendColumnTo(PANEL_B_ADDR, histX, col);
+  memset(col, 0, sizeof(col));
+  histX = (histX + 1) % SCREEN_WIDTH;
+  display.sendColumnTo(PANEL_B_ADDR, histX, col);
+}
+
+// ---------- Lesson statistics ----------
+void statsLoad() {
+  if (EEPROM.read(STATS_EEPROM_ADDR) != STATS_MAGIC) {
+    statsReset();
+    return;
+  }
+  EEPROM.get(STATS_EEPROM_ADDR + offsetof(StatsRecord, seconds), stats.seconds);
+}
+
+// Takes about 1 s when the old lesson filled most bins (EEPROM writes)
+void statsReset() {
+  stats.clear();
+  EEPROM.put(STATS_EEPROM_ADDR + offsetof(StatsRecord, seconds), stats.seconds);
+  EEPROM.update(STATS_EEPROM_ADDR, STATS_MAGIC);
+}
+
+void statsSave() {
+  stats.flush();
+  EEPROM.put(STATS_EEPROM_ADDR + offsetof(StatsRecord, seconds), stats.seconds);
+}
+
+// Seconds at or above Scale::loudDb (histogram share of the real duration)
+uint32_t statsLoudSeconds() {
+  return stats.secondsFrom(Scale::loudDb * 100);
+}
+
+// "mm:ss" (minutes keep counting past 60)
+void formatMinSec(uint32_t s, char *out) {
+  ultoa(s / 60, out, 10);
+  out += strlen(out);
+  *out++ = ':';
+  *out++ = '0' + (s % 60) / 10;
+  *out++ = '0' + s % 10;
+  *out = '\0';
+}
+
+void statsReport() {
+  char buf[12];
+  if (!calibLoaded) Serial.println(F("[INFO] Not calibrated: seconds are only counted once calibrated ('c')."));
+  formatMinSec(stats.seconds, buf);
+  Serial.print(F("[STATS] Lesson "));
+  Serial.print(buf);
+  if (stats.seconds == 0) {
+    Serial.println(F(", no data yet."));
+    return;
+  }
+  static const uint8_t PCTS[3] = { 10, 50, 90 };
+  for (uint8_t i = 0; i < 3; i++) {
+    Serial.print(F(", L"));
+    Serial.print(PCTS[i]);
+    Serial.print(' ');
+    formatCdb(stats.level(PCTS[i]), buf);
+    Serial.print(buf);
+  }
+  uint32_t loud = statsLoudSeconds();
+  Serial.print(F(" dB, >= "));
+  Serial.print(Scale::loudDb);
+  Serial.print(F(" dB for "));
+  formatMinSec(loud, buf);
+  Serial.print(buf);
+  Serial.print(F(" ("));
+  Serial.print(loud * 100 / stats.seconds);
+  Serial.println(F("%)"));
+}
+
+// Summary page: duration, L10/L50/L90, loud share (text rows 0..27) and
+// the histogram (rows 34..63, 1 dB per column, tallest = 30 px); only the
+// part on this page is worked out
+void drawStatsStrip(uint8_t page) {
+  char buf[12];
+  display.setTextSize(1);
+  display.setTextColor(SSD1306_WHITE);
+  if (onPage(page, 0, 28)) {
+    display.setCursor(0, 0);
+    display.print(F("Lesson "));
+    formatMinSec(stats.seconds, buf);
+    display.print(buf);
+    if (stats.seconds > 0) {
+      display.setCursor(0, 10);
+      display.print(F("L10 "));
+      formatCdb(stats.level(10), buf);
+      display.print(buf);
+      display.print(F("  L50 "));
+      formatCdb(stats.level(50), buf);
+      display.print(buf);
+      display.setCursor(0, 20);
+      display.print(F("L90 "));
+      formatCdb(stats.level(90), buf);
+      display.print(buf);
+      display.print(F("  >"));
+      display.print(Scale::loudDb);
+      display.print(F(" "));
+      display.print(statsLoudSeconds() * 100 / stats.seconds);
+      display.print('%');
+    }
+    return;   // the histogram starts below the text pages
+  }
+
+  uint32_t top = 1;
+  for (uint8_t i = 0; i < STATS_BINS; i += 2) {
+    uint32_t c = stats.bin(i) + stats.bin(i + 1);
+    if (c > top) top = c;
+  }
+  for (uint8_t i = 0; i < STATS_BINS; i += 2) {
+    uint32_t c = stats.bin(i) + stats.bin(i + 1);
+    uint8_t h = c * 30 / top;
+    if (c && !h) h = 1;
+    if (h) display.drawFastVLine(24 + i / 2, 63 - h + 1, h, SSD1306_WHITE);
+  }
 }
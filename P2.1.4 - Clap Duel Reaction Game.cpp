@@ -0,0 +1,264 @@
+/* Clap Duel - two players, who reacts to the flash first?
+Goal: Wait for the screen to flash (and the buzzer to beep), then clap as fast as you can.
+Explanation: After a random 2-5 s wait the screen inverts and the buzzer beeps: that is the cue.
+  Each player has a sound sensor; its first edge after the cue is that player's reaction time,
+  shown in milliseconds. Clapping before the cue is a false start and gives the round to the other
+  player. First to win 3 rounds (best of 5) wins the match; each player's best time is kept.
+  Edges are timestamped inside the INT0/INT1 interrupts from Timer1 (0.5 us per tick), so even
+  claps a fraction of a millisecond apart are ordered correctly. If both edges arrive before the
+  first interrupt could run (a few us apart) the round is a tie.
+  Put the sensors at least 1 m apart and turn their pots down until each one only hears the
+  clap (or a tap on the sensor) of its own player.
+Wiring:
+  OLED (I2C): VCC->5V, GND->GND, SDA->A4, SCL->A5
+  LM393 player 1: VCC->5V, GND->GND, D0->D2 (INT0)
+  LM393 player 2: VCC->5V, GND->GND, D0->D3 (INT1)
+  Buzzer: + -> D8, - -> GND
+*/
+
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include "ClapDuel.h"
+
+#define SCREEN_WIDTH 128
+#define SCREEN_HEIGHT 64
+#define OLED_RESET -1
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+
+const int P1_PIN = 2;      // INT0
+const int P2_PIN = 3;      // INT1
+const int BUZZER_PIN = 8;
+
+const unsigned long WAIT_MIN_MS = 2000;   // random wait before the cue
+const unsigned long WAIT_MAX_MS = 5000;
+const unsigned long ROUND_MS = 2000;      // time to react after the cue
+const uint8_t WIN_ROUNDS = 3;             // best of 5
+const uint8_t TICKS_PER_US = 2;           // Timer1 at 16 MHz / 8
+
+// Timer1 runs free with an overflow count on top: 32-bit time in 0.5 us ticks
+volatile uint16_t t1Overflows = 0;
+DuelRound duel;                               // written by the edge ISRs (ClapDuel.h)
+
+uint8_t score[2] = { 0, 0 };
+uint32_t bestUs[2] = { 0, 0 };                // 0 = no valid time yet
+uint8_t roundNo = 0;
+
+ISR(TIMER1_OVF_vect) {
+  t1Overflows++;
+}
+
+// Time now in ticks; call with interrupts off (as in an ISR)
+uint32_t ticksNow() {
+  uint16_t lo = TCNT1;
+  return duelTicks(lo, t1Overflows, TIFR1 & _BV(TOV1));
+}
+
+// The timer is read before anything else
+void onP1() { duel.edge(0, ticksNow(), EIFR & _BV(INTF1)); }
+void onP2() { duel.edge(1, ticksNow(), EIFR & _BV(INTF0)); }
+
+void setup() {
+  pinMode(P1_PIN, INPUT);
+  pinMode(P2_PIN, INPUT);
+  pinMode(BUZZER_PIN, OUTPUT);
+  Serial.begin(9600);
+  display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+  display.setTextColor(SSD1306_WHITE);
+  randomSeed(analogRead(A3));
+
+  // Timer1: normal mode, /8 prescaler, overflow interrupt for the high word
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = _BV(CS11);
+  TCNT1 = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 = _BV(TOIE1);
+  interrupts();
+
+  attachInterrupt(digitalPinToInterrupt(P1_PIN), onP1, RISING);
+  attachInterrupt(digitalPinToInterrupt(P2_PIN), onP2, RISING);
+
+  showTitle();
+  delay(2000);
+}
+
+void loop() {
+  roundNo++;
+  showWaiting();
+
+  // Arm both players; any edge before the cue is a false start
+  unsigned long waitMs = random(WAIT_MIN_MS, WAIT_MAX_MS + 1);
+  delay(300);                       // let the sensors settle after the last round
+  noInterrupts();
+  duel.arm();
+  interrupts();
+
+  unsigned long waitStart = millis();
+  int8_t falseStart = -1;
+  while (millis() - waitStart < waitMs) {
+    if (duel.edgeSeen[0] || duel.edgeSeen[1]) {
+      noInterrupts();
+      falseStart = duel.falseStart();
+      duel.stop();
+      interrupts();
+      break;
+    }
+  }
+
+  if (falseStart >= 0) {
+    Outcome o = falseStart == 2 ? NOBODY : (falseStart == 0 ? P2_WINS : P1_WINS);
+    finishRound(o, falseStart, 0, 0, false);
+    return;
+  }
+
+  // Cue: the timestamp first, then one display command plus the buzzer.
+  // An edge stamped before it (after the wait loop last looked) is still a
+  // false start; the ~0.3 ms the cue takes to show counts for both players.
+  noInterrupts();
+  uint32_t cue = ticksNow();
+  interrupts();
+  display.invertDisplay(true);
+  tone(BUZZER_PIN, 2000, 150);
+
+  unsigned long cueMs = millis();
+  while (millis() - cueMs < ROUND_MS && !(duel.edgeSeen[0] && duel.edgeSeen[1])) {}
+  display.invertDisplay(false);
+
+  noInterrupts();
+  duel.stop();
+  DuelVerdict v = duel.judge(cue);
+  interrupts();
+
+  if (v.falseStart >= 0) {
+    finishRound(v.outcome, v.falseStart, 0, 0, false);
+    return;
+  }
+
+  uint32_t us[2];
+  for (uint8_t p = 0; p < 2; p++) {
+    us[p] = v.ticks[p] / TICKS_PER_US;
+    if (us[p] && (bestUs[p] == 0 || us[p] < bestUs[p])) bestUs[p] = us[p];
+  }
+  finishRound(v.outcome, -1, us[0], us[1], true);
+}
+
+// Score the round, show it, and end the match when someone has enough wins
+void finishRound(Outcome o, int8_t falseStart, uint32_t us0, uint32_t us1, bool cued) {
+  if (o == P1_WINS) score[0]++;
+  if (o == P2_WINS) score[1]++;
+
+  Serial.print(F("Round "));
+  Serial.print(roundNo);
+  if (!cued) {
+    Serial.print(F(": false start "));
+    Serial.println(falseStart == 2 ? F("by both") : (falseStart == 0 ? F("P1") : F("P2")));
+  } else {
+    Serial.print(F(": P1 "));
+    Serial.print(us0);
+    Serial.print(F(" us, P2 "));
+    Serial.print(us1);
+    Serial.println(F(" us"));
+  }
+
+  showRound(o, falseStart, us0, us1, cued);
+  delay(2500);
+
+  if (score[0] >= WIN_ROUNDS || score[1] >= WIN_ROUNDS) {
+    showMatch();
+    delay(5000);
+    score[0] = score[1] = 0;
+    bestUs[0] = bestUs[1] = 0;
+    roundNo = 0;
+    showTitle();
+    delay(2000);
+  }
+}
+
+// "187.4 ms" from microseconds, "--" if the player did not clap
+void printMs(uint32_t us) {
+  if (us == 0) {
+    display.print(F("--"));
+    return;
+  }
+  display.print(us / 1000);
+  display.print('.');
+  display.print((us % 1000) / 100);
+  display.print(F(" ms"));
+}
+
+void showTitle() {
+  display.clearDisplay();
+  display.setTextSize(2);
+  display.setCursor(0, 0);
+  display.println(F("Clap Duel"));
+  display.setTextSize(1);
+  display.setCursor(0, 24);
+  display.println(F("Clap when the screen"));
+  display.println(F("flashes. Too early ="));
+  display.println(F("round lost. Best of 5"));
+  display.display();
+}
+
+void showWaiting() {
+  display.clearDisplay();
+  display.setTextSize(1);
+  display.setCursor(0, 0);
+  display.print(F("Round "));
+  display.print(roundNo);
+  display.print(F("   P1 "));
+  display.print(score[0]);
+  display.print(F(" - "));
+  display.print(score[1]);
+  display.print(F(" P2"));
+  display.setTextSize(2);
+  display.setCursor(4, 28);
+  display.print(F("Wait..."));
+  display.display();
+}
+
+void showRound(Outcome o, int8_t falseStart, uint32_t us0, uint32_t us1, bool cued) {
+  display.clearDisplay();
+  display.setTextSize(1);
+  display.setCursor(0, 0);
+  if (!cued) {
+    display.print(F("False start: "));
+    display.print(falseStart == 2 ? F("both") : (falseStart == 0 ? F("P1") : F("P2")));
+  } else {
+    display.print(F("P1 "));
+    printMs(us0);
+    display.setCursor(0, 10);
+    display.print(F("P2 "));
+    printMs(us1);
+  }
+  display.setTextSize(2);
+  display.setCursor(0, 26);
+  if (o == P1_WINS) display.print(F("P1 wins"));
+  else if (o == P2_WINS) display.print(F("P2 wins"));
+  else if (o == TIE) display.print(F("Tie!"));
+  else display.print(F("No point"));
+  display.setTextSize(1);
+  display.setCursor(0, 54);
+  display.print(F("Score P1 "));
+  display.print(score[0]);
+  display.print(F(" - "));
+  display.print(score[1]);
+  display.print(F(" P2"));
+  display.display();
+}
+
+void showMatch() {
+  display.clearDisplay();
+  display.setTextSize(2);
+  display.setCursor(0, 0);
+  display.print(score[0] > score[1] ? F("P1") : F("P2"));
+  display.println(F(" wins!"));
+  display.setTextSize(1);
+  display.setCursor(0, 30);
+  display.print(F("Best P1 "));
+  printMs(bestUs[0]);
+  display.setCursor(0, 42);
+  display.print(F("Best P2 "));
+  printMs(bestUs[1]);
+  display.display();
+}
@@ -1,6 +1,26 @@
 /* Improved Noise Meter Face
    Shows :) if quiet, >:( if loud
-   Uses averaging for better sensitivity
+   The mic is sampled all the time (Timer1 + ADC interrupt), and the noise
+   level on screen is the RMS of the last 20 ms, refreshed 25 times a second.
+   Only sustained chatter makes the face angry: every 50 ms window is
+   classified as silence, speech or a bang (dropped book, chair), and the face
+   follows the speech votes of the last second. A window is only a bang
+   when the sound was gone again one window later (NoiseTree.h), so the
+   start of a sentence is not one. Serial prints the window features as
+   CSV so the tree can be re-trained on a PC (tools/NoiseTreeTrainer.cpp).
+   Event capture: the last 164 ms of mic signal are always kept (8-bit
+   u-law). A loud peak, a bang or the face turning angry freezes them 41 ms
+   after the event, and they are sent on Serial between the CSV lines,
+   framed so tools/CaptureToWav.cpp can turn a saved log into WAV files:
+     #CAP <n> <why T/B/A> <rate Hz> <samples> <trigger index>
+     #D <hex bytes, oldest first>          (24 samples per line)
+     #END <16-bit sum of all sample bytes>
+   Decode a byte u (G.711 u-law of ADC counts x 16): u = ~u, e = (u >> 4) & 7,
+   m = u & 15, counts = ((((16 + m) << (e + 1)) + (1 << e) - 33) / 16,
+   negative when bit 7 of the original byte is clear.
+   With PACKED10_SELFTEST set to 1, one "# packed10 ok ..." line at boot
+   checks the packed sample ring (Packed10.h) and prints its cost in CPU
+   cycles per sample (tests/Packed10Test.cpp checks the same on a PC).
    SSD1306 (I2C)
       VCC -> 5V       GND -> GND       SDA -> A4      SCL -> A5
    Mic Module - A0 - Analog out 
@@ -8,73 +28,313 @@
 
 #include <Wire.h>
 #include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
+#include <util/atomic.h>
+#include "OledPaged.h"
+#include "Packed10.h"
+#include "NoiseFeatures.h"
+#include "NoiseTree.h"
 
-#define SCREEN_WIDTH 128
-#define SCREEN_HEIGHT 64
-#define OLED_RESET -1
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+// Drawn page by page (OledPaged.h): the 896 bytes saved hold the capture
+PagedOled display;
+
+// 1 = round-trip check and timing of Packed10 at boot (adds the check code
+// to flash and a "#" line before the CSV); 0 = left out
+#define PACKED10_SELFTEST 0
 
 const int MIC_A = A0;  // Analog pin from LM393
-int noiseLevel = 0;
 
-// Adjust this after testing in your room
+// Adjust this after testing in your room (RMS of the mic signal, ADC counts)
 const int QUIET_THRESHOLD = 25;  
+const uint16_t QUIET_ENERGY = (uint16_t)QUIET_THRESHOLD * QUIET_THRESHOLD;
+
+// ----- Continuous sampling -----
+// Timer1 compare B starts a conversion every 160 us (6.25 kHz, about the
+// speed of the old analogRead() loop, so the tree thresholds still fit).
+// The ADC ISR takes off the mic's DC bias, keeps the last RING_SAMPLES
+// samples and a running sum of their squares: add the new square, subtract
+// the one that drops out. O(1) per sample, and the RMS of the latest
+// window is ready at any time. The ring holds 10-bit values (sample + 512,
+// clipped to 0..1023) packed 4 in 5 bytes: 160 bytes instead of 256.
+const unsigned long SAMPLE_RATE = 6250UL;
+const uint16_t ACQ_TIMER_TOP = F_CPU / SAMPLE_RATE - 1;   // 20 ADC clocks at /128
+const uint8_t RING_SAMPLES = 128;       // RMS window, 20.5 ms (power of two)
+const uint8_t DC_SHIFT = 8;             // DC follows over 256 samples (41 ms)
+
+Packed10<RING_SAMPLES> ring;            // DC-free samples + 512, oldest at ringHead
+volatile uint8_t ringHead = 0;
+volatile uint32_t ringSumSq = 0;        // sum of the squares in ring[]
+volatile int32_t dcQ8 = 512L << DC_SHIFT;
+
+// ----- Event capture -----
+// Every second sample (pair average, 3125 Hz) goes into cap[] as u-law.
+// WARMING fills the ring once, ARMED waits for a trigger, POST keeps
+// recording CAP_POST samples, FROZEN stops it until the dump is sent.
+const uint16_t CAP_SAMPLES = 512;       // 164 ms
+const uint16_t CAP_POST = 128;          // 41 ms after the trigger
+const int16_t CAP_TRIG_COUNTS = 300;    // a sample this far from the bias triggers by itself
+const float CAP_RATE_HZ = SAMPLE_RATE / 2.0;
+const uint8_t CAP_LINE = 24;            // samples per #D line (fits the 64-byte TX buffer)
+enum CapState { CAP_WARMING, CAP_ARMED, CAP_POST_TRIG, CAP_FROZEN };
+
+volatile uint8_t cap[CAP_SAMPLES];
+volatile uint16_t capHead = 0;          // next write = oldest sample
+volatile uint8_t capState = CAP_WARMING;
+volatile uint16_t capCount = 0;         // samples since warming / since the trigger
+volatile uint16_t capTrigAt = 0;        // ring index of the trigger sample
+volatile char capWhy = 0;               // 'T' peak, 'B' bang, 'A' angry face
+volatile char capSoftTrig = 0;          // trigger request from loop()
+int16_t capPair = 0;                    // first sample of the pair (ISR only)
+bool capOdd = false;
+uint16_t capDumps = 0;
+int16_t capLine = -1;                   // next dump line, -1 = header
+
+// ----- Screen: 25 frames per second, redrawn only when something changed -----
+const unsigned long FRAME_MS = 40;
+
+// ----- Window features -----
+const int WINDOW_SAMPLES = 50;          // newest 50 samples (8 ms), as before
+const unsigned long WINDOW_MS = 50;     // one window every 50 ms
+const uint8_t WINDOWS_PER_CSV = 4;      // Serial CSV every 200 ms
+const int ZCR_HYST = 2;                 // ADC counts around the mean ignored by zero crossings
+
+const char *const CLASS_NAMES[] = { "quiet", "talk", "bang" };
+
+// Features of the newest window and the last second (NoiseFeatures.h),
+// classified with NOISE_TREE (NoiseTree.h). Re-train offline from the
+// Serial CSV with tools/NoiseTreeTrainer.cpp and paste its table there.
+uint16_t feat[F_COUNT];
+NoiseHistory history = {};
+const uint8_t SPEECH_VOTES = 12;        // speech windows in the last second for angry face
+
+uint32_t speechBits = 0;
+uint8_t windowCount = 0;
+uint8_t lastClass = C_SILENCE;
 
 void setup() {
   Serial.begin(9600);
-  display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
-  display.clearDisplay();    // clear screen
-  display.setTextSize(2);    // text size 1–3
+#if PACKED10_SELFTEST
+  Packed10<16>::check(Serial);
+#endif
+  for (uint8_t i = 0; i < RING_SAMPLES; i++) ring.set(i, 512);   // silence
+  display.begin(0x3C);
   display.setTextColor(SSD1306_WHITE); 
-  display.setCursor(0,0);    
-  display.print("STart ");
-  display.display();  
+  display.firstPage();
+  do {
+    display.setTextSize(2);  // text size 1–3
+    display.setCursor(0,0);    
+    display.print(F("STart "));
+  } while (display.nextPage());
+  delay(500);
+
+  acqBegin();
 }
 
 void loop() {
-  // Take multiple samples and average them
-  long sum = 0;
-  for (int i = 0; i < 50; i++) {
-    sum += analogRead(MIC_A);
-    delayMicroseconds(50);  // tiny delay between samples
+  unsigned long now = millis();
+
+  // Classify the newest samples every 50 ms; sampling goes on meanwhile
+  static unsigned long lastWindow = 0;
+  if (now - lastWindow >= WINDOW_MS) {
+    lastWindow = now;
+    measureFeatures();
+    uint8_t prevClass = lastClass;
+    bool wasAngry = countBits(speechBits) >= SPEECH_VOTES;
+    lastClass = noiseClassify(NOISE_TREE, feat);
+    speechBits = ((speechBits << 1) | (lastClass == C_SPEECH)) & ((1UL << NOISE_HISTORY) - 1);
+
+    // a new bang or the face turning angry freezes the capture
+    if (lastClass == C_IMPACT && prevClass != C_IMPACT) capTrigger('B');
+    if (!wasAngry && countBits(speechBits) >= SPEECH_VOTES) capTrigger('A');
+
+    // CSV for offline training: energy,zcr,crest,onsets,loud,burst,class
+    if (++windowCount >= WINDOWS_PER_CSV) {
+      windowCount = 0;
+      for (uint8_t f = 0; f < F_COUNT; f++) {
+        Serial.print(feat[f]);
+        Serial.print(',');
+      }
+      Serial.println(lastClass);
+    }
+  }
+
+  // Frame from the latest window, sent only if something changed
+  static unsigned long lastFrame = 0;
+  if (now - lastFrame >= FRAME_MS) {
+    lastFrame = now;
+    drawScreen(windowRms(), lastClass, countBits(speechBits) >= SPEECH_VOTES);
+  }
+
+  if (capState == CAP_FROZEN) capDumpStep();
+}
+
+void drawScreen(int level, uint8_t cls, bool angry) {
+  static int lastLevel = -1;
+  static uint8_t lastCls = 0xFF;
+  static bool lastAngry = false;
+  if (level == lastLevel && cls == lastCls && angry == lastAngry) return;
+  lastLevel = level;
+  lastCls = cls;
+  lastAngry = angry;
+
+  display.firstPage();
+  do {
+    display.setTextSize(1);
+    display.setCursor(0,0);
+    display.print(F("Noise Level: "));
+    display.print(level);
+    display.setCursor(0,8);
+    display.print(F("Heard: "));
+    display.print(CLASS_NAMES[cls]);
+    display.setTextSize(4);
+    display.setCursor(20,20);
+    display.print(angry ? F(">:(") : F(":)"));
+    display.setTextSize(1);
+    display.setCursor(80,56);
+    display.print(angry ? F("Loud!") : F("Quiet"));
+  } while (display.nextPage());
+}
+
+// ADC: AVCC reference, mic channel, /128 clock, started by Timer1 compare B
+void acqBegin() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    ADMUX = _BV(REFS0) | ((MIC_A - A0) & 0x07);
+    ADCSRB = _BV(ADTS2) | _BV(ADTS0);
+    ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADIF) |
+             _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+    DIDR0 |= _BV(MIC_A - A0);
+
+    TCCR1A = 0;
+    TCCR1B = _BV(WGM12) | _BV(CS10);  // CTC, TOP = OCR1A, no prescaler
+    OCR1A = ACQ_TIMER_TOP;
+    OCR1B = ACQ_TIMER_TOP;
+    TCNT1 = 0;
+    TIFR1 = _BV(OCF1B);
+    TIMSK1 = _BV(OCIE1B);
+  }
+}
+
+// Only clears OCF1B, so the next compare match triggers the ADC again
+EMPTY_INTERRUPT(TIMER1_COMPB_vect);
+
+ISR(ADC_vect) {
+  int16_t raw = ADC;
+  dcQ8 += raw - (dcQ8 >> DC_SHIFT);
+  int16_t d = constrain(raw - (int16_t)(dcQ8 >> DC_SHIFT), -512, 511);
+  int16_t old = (int16_t)ring.get(ringHead) - 512;
+  // unsigned wrap-around is fine: the true sum never goes negative
+  ringSumSq += (uint32_t)((int32_t)d * d) - (uint32_t)((int32_t)old * old);
+  ring.set(ringHead, d + 512);
+  ringHead = (ringHead + 1) & (RING_SAMPLES - 1);
+
+  // event capture at half rate
+  if (capState == CAP_FROZEN) return;
+  capOdd = !capOdd;
+  if (capOdd) {
+    capPair = d;
+    return;
+  }
+  int16_t c = (capPair + d) >> 1;
+  cap[capHead] = muEncode(c);
+  if (capState == CAP_WARMING) {
+    if (++capCount >= CAP_SAMPLES - CAP_POST) capState = CAP_ARMED;
+  } else if (capState == CAP_ARMED) {
+    if (capSoftTrig || c >= CAP_TRIG_COUNTS || c <= -CAP_TRIG_COUNTS) {
+      capWhy = capSoftTrig ? capSoftTrig : 'T';
+      capSoftTrig = 0;
+      capTrigAt = capHead;
+      capCount = 0;
+      capState = CAP_POST_TRIG;
+    }
+  } else if (++capCount >= CAP_POST) {
+    capState = CAP_FROZEN;
   }
-  noiseLevel = sum / 50;  // average of 50 readings
+  if (++capHead == CAP_SAMPLES) capHead = 0;
+}
 
-  Serial.println(noiseLevel);
+// G.711 u-law of a sample in ADC counts (x16 = the 14-bit range u-law expects)
+uint8_t muEncode(int16_t c) {
+  uint8_t sign = 0;
+  if (c < 0) { c = -c; sign = 0x80; }
+  uint16_t v = c > 509 ? 8191 : (c << 4) + 33;
+  uint8_t seg = 0;
+  for (uint16_t t = v >> 6; t; t >>= 1) seg++;
+  return ~(sign | (seg << 4) | ((v >> (seg + 1)) & 0x0F));
+}
 
-  // Show result on display
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0,0);
-  display.print("Noise Level: ");
-  display.println(noiseLevel);
+// Trigger from loop(); ignored while a capture is being recorded or sent
+void capTrigger(char why) {
+  if (capState == CAP_ARMED) capSoftTrig = why;
+}
 
-  if (noiseLevel < QUIET_THRESHOLD) {
-    drawSmiley();
+// One framed line per call, only when it fits in the TX buffer, so the
+// CSV and the measurement carry on while a capture goes out
+void capDumpStep() {
+  char line[4 + 2 * CAP_LINE + 3];
+  uint16_t lines = (CAP_SAMPLES + CAP_LINE - 1) / CAP_LINE;
+  static uint16_t sum;
+  uint8_t len;
+  if (capLine < 0) {
+    len = 40;   // header is shorter than this
+  } else if (capLine < (int16_t)lines) {
+    len = 3 + 2 * CAP_LINE + 2;
   } else {
-    drawAngry();
+    len = 14;
   }
+  if (Serial.availableForWrite() < len) return;
 
-  display.display();
-  delay(200);  // refresh 5 times per second
+  if (capLine < 0) {
+    sum = 0;
+    Serial.print(F("#CAP "));
+    Serial.print(++capDumps);
+    Serial.print(' ');
+    Serial.print(capWhy);
+    Serial.print(' ');
+    Serial.print(CAP_RATE_HZ, 0);
+    Serial.print(' ');
+    Serial.print(CAP_SAMPLES);
+    Serial.print(' ');
+    Serial.println((capTrigAt + CAP_SAMPLES - capHead) % CAP_SAMPLES);
+  } else if (capLine < (int16_t)lines) {
+    static const char HEX_DIGITS[] PROGMEM = "0123456789ABCDEF";
+    char *p = line;
+    *p++ = '#'; *p++ = 'D'; *p++ = ' ';
+    for (uint8_t i = 0; i < CAP_LINE; i++) {
+      uint16_t k = capLine * CAP_LINE + i;
+      if (k >= CAP_SAMPLES) break;
+      uint8_t b = cap[(capHead + k) % CAP_SAMPLES];
+      sum += b;
+      *p++ = pgm_read_byte(&HEX_DIGITS[b >> 4]);
+      *p++ = pgm_read_byte(&HEX_DIGITS[b & 15]);
+    }
+    *p = '\0';
+    Serial.println(line);
+  } else {
+    Serial.print(F("#END "));
+    Serial.println(sum);
+    capLine = -1;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      capCount = 0;
+      capState = CAP_WARMING;   // refill before the next trigger
+    }
+    return;
+  }
+  capLine++;
 }
 
-void drawSmiley() {
-  display.setTextSize(4);
-  display.setCursor(20,20);
-  display.print(":)");
-  display.setTextSize(1);
-  display.setCursor(90,50);
-  display.println("Quiet");
+// RMS of the last RING_SAMPLES samples, ADC counts
+int windowRms() {
+  uint32_t s;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { s = ringSumSq; }
+  return (int)sqrt(s / RING_SAMPLES);
 }
 
-void drawAngry() {
-  display.setTextSize(4);
-  display.setCursor(20,20);
-  display.print(">:(");
-  display.setTextSize(1);
-  display.setCursor(80,50);
-  display.println("Loud!");
-  delayMicroseconds(2000);
+// Copy the newest WINDOW_SAMPLES samples and fill feat[] (one pass, integers only)
+void measureFeatures() {
+  int16_t s[WINDOW_SAMPLES];
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    ring.unpack(ringHead + RING_SAMPLES - WINDOW_SAMPLES, WINDOW_SAMPLES, s, 512);
+  }
+  WindowFeatures w;
+  windowFeatures(s, WINDOW_SAMPLES, ZCR_HYST, w);
+  history.update(w, QUIET_ENERGY, feat);
 }
@@ -7,8 +7,17 @@
      Mic A0     : A0 -> analog output of mic module (LM393 or better amp)
 
    Notes:
-     - The sketch samples A0 quickly for a short window, computes RMS,
+     - The sketch samples A0 for a short window, computes RMS,
        smooths it, and compares to calibrated quietLevel.
+     - Samples are paced by Timer1 (ADC auto-trigger), so the rate is exact.
+       Send 'j' on Serial to print the effective rate and jitter statistics.
+     - Send 'n' to toggle ADC Noise Reduction sleep sampling: the CPU sleeps
+       through every conversion, which lowers the noise floor that sets THRESH.
+     - Send 'o' to toggle x4 oversampling: one more bit and a lower floor
+       for quiet rooms, but only sound below ~1 kHz (see ACQ_OS_TOP).
+     - Send 'u' to print the RAM use and the stack high-water mark.
+     - The debug line is queued and sent while the next window is sampled
+       (Telemetry.h), so Serial never holds up the measurement.
      - If the mic signal is too small, increase module gain (pot) or use a better mic amp.
 */
 
@@ -16,6 +25,12 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include <Arduino.h>
+#include <util/atomic.h>
+#include <avr/sleep.h>
+#include "OledWidgets.h"
+#include "QuietSampler.h"
+#include "RamMonitor.h"
+#include "Telemetry.h"
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
@@ -25,16 +40,84 @@ Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 // Prototype
 void updateDisplay(bool quiet);
 void quickCalibrate();
+double measureRmsWindow();
+void acqInit();
+void acqStart(uint16_t samples);
+void acqRunQuiet(uint16_t samples);
+void acqSetOversample(uint8_t shift);
+float acqRawRate();
+uint16_t acqWindowSamples();
+void printAcqStats();
 
 const int MIC_PIN = A0;            // analog input from mic
 const unsigned int WINDOW_MS = 20; // RMS window (ms)
-const unsigned int SAMPLE_DELAY_US = 200; // microseconds between samples (~5kHz)
+const unsigned long SAMPLE_RATE = 5000UL; // samples per second, paced by Timer1
+const uint16_t WINDOW_SAMPLES = WINDOW_MS * SAMPLE_RATE / 1000UL;
 const float SMOOTH_ALPHA = 0.18;   // smoothing factor (0..1)
 
+// Timer1 (CTC, no prescaler) compare match B starts each ADC conversion.
+// 3200 ticks per sample = 25 ADC clocks at /128: no sampling jitter.
+const uint16_t ACQ_TIMER_TOP = F_CPU / SAMPLE_RATE - 1;
+const float ACQ_RATE_HZ = (float)F_CPU / (ACQ_TIMER_TOP + 1);
+
+// ADC Noise Reduction sleep stops the I/O clock, so Timer1 pauses for each
+// 13-ADC-clock conversion; its period is shortened by that much.
+const uint16_t ACQ_CONV_TICKS = 13 * 128;
+const uint16_t ACQ_NR_TOP = ACQ_TIMER_TOP - ACQ_CONV_TICKS;
+
+// Oversampling ('o'): the ADC clock stays at /128 (125 kHz, inside the 50..200
+// kHz the datasheet gives for full 10-bit accuracy) with a trigger every 16 ADC
+// clocks (7.8 kHz), and the ISR adds 4^k raw samples into one output sample
+// >> k, i.e. k extra bits. The mic's own ~1 count of noise is the dither that
+// makes those bits real. x4 gives 11 bits at 1.95 kHz: the boxcar reads 1 kHz
+// 3.7 dB low and nulls 1.95 kHz, so a voice's upper band is lost. x16 (488 Hz)
+// and x64 (122 Hz) would keep only hum, so they are not offered.
+// tests/OversampleTest.cpp has the floor, band and interrupt cost of both modes.
+const uint16_t ACQ_OS_TOP = 16 * 128 - 1;
+const float ACQ_OS_RAW_HZ = (float)F_CPU / (ACQ_OS_TOP + 1);
+const uint8_t ACQ_OS_MAX_SHIFT = 1;
+const uint16_t ACQ_MIN_WINDOW = 16;     // output samples per window at least
+
+// Window sums filled by the ADC ISR
+volatile uint16_t acqTarget = 0;
+volatile uint16_t acqCount = 0;
+volatile uint16_t acqTriggers = 0;
+volatile bool acqPending = false;
+volatile bool acqDone = true;
+volatile int32_t acqSum = 0;
+volatile uint32_t acqSumSq = 0;
+int16_t acqDc = 512;               // centre for the sums (last window's mean)
+volatile uint8_t acqOsShift = 0;   // 0 = off, k = 4^k raw samples per output sample
+volatile uint16_t acqOsAcc = 0;    // raw samples summed so far (64 x 1023 fits)
+volatile uint8_t acqOsCount = 0;
+
+// Jitter statistics since the last 'j' report
+volatile uint16_t acqLatMin = 0xFFFF; // trigger -> ADC ISR, Timer1 ticks (1/16 us)
+volatile uint16_t acqLatMax = 0;
+volatile uint16_t acqOverruns = 0;
+uint32_t acqTotalSamples = 0;
+uint32_t acqTotalTriggers = 0;
+float acqEffectiveRate = ACQ_RATE_HZ; // samples/s delivered in the last window
+
+// ADC Noise Reduction sleep ('n') and its stats since the last 'j' report.
+// The UART stops with the I/O clock, so a pin change on RX wakes the CPU and
+// the next samples are taken awake (QuietSampler.h).
+volatile bool acqQuiet = false;
+volatile bool acqRxEdge = false;   // pin change on RX (PD0) since the last look
+QuietStats quietStats;
+double floorRms[2] = { 1e9, 1e9 };  // quietest window RMS, normal / NR sleep
+
 float smoothRms = 0.0;
 float quietLevel = 0.0;
 bool calibrated = false;
 
+// Debug log: levels in thousandths of an ADC count, state quiet/loud
+const TelemetryField LOG_FIELDS[] PROGMEM = {
+  { "vrms", 3 }, { "quiet", 3 }, { "smooth", 3 }, { "rel", 3 }
+};
+const char LOG_STATES[2][6] PROGMEM = { "loud", "quiet" };
+Telemetry<4, 4> logQueue(LOG_FIELDS, LOG_STATES[0], sizeof(LOG_STATES[0]));
+
 void setup() {
   Serial.begin(115200);
   pinMode(MIC_PIN, INPUT);
@@ -47,6 +130,8 @@ void setup() {
   display.clearDisplay();
   display.setTextColor(SSD1306_WHITE);
 
+  acqInit();
+
   // Quick auto-calibration to get quiet baseline
   delay(200);
   quickCalibrate();
@@ -54,30 +139,27 @@ void setup() {
 }
 
 void loop() {
-  // 1) sample for WINDOW_MS and compute mean and sum of squared deviations
-  unsigned long t0 = millis();
-  unsigned long tend = t0 + WINDOW_MS;
-
-  // First pass: compute mean (quick)
-  long n = 0;
-  double acc = 0.0;
-  while (millis() < tend) {
-    acc += analogRead(MIC_PIN);
-    n++;
-    delayMicroseconds(SAMPLE_DELAY_US);
-  }
-  if (n == 0) n = 1;
-  double mean = acc / (double)n;
-
-  // Second pass: RMS (sum squares of (sample - mean))
-  double ss = 0.0;
-  for (long i = 0; i < n; i++) {
-    double v = analogRead(MIC_PIN) - mean;
-    ss += v * v;
-    delayMicroseconds(SAMPLE_DELAY_US);
-  }
-  double msq = ss / (double)max(1, (int)n);
-  double vrms = sqrt(msq); // RMS in ADC units
+  if (Serial.available()) {
+    char c = Serial.read();
+    if (c == 'j') printAcqStats();
+    if (c == 'u') ramReport(Serial);
+    if (c == 'n') {
+      acqSetOversample(0);        // NR sleep timing assumes the normal sample period
+      acqQuiet = !acqQuiet;
+      Serial.println(acqQuiet ? F("NR sleep sampling ON") : F("NR sleep sampling OFF"));
+    }
+    if (c == 'o') {
+      acqQuiet = false;
+      acqSetOversample(acqOsShift == ACQ_OS_MAX_SHIFT ? 0 : acqOsShift + 1);
+      Serial.print(F("Oversampling x")); Serial.print(1 << (2 * acqOsShift));
+      Serial.print(F(", ")); Serial.print(10 + acqOsShift);
+      Serial.print(F(" bit at ")); Serial.print(acqRawRate() / (1 << (2 * acqOsShift)), 0);
+      Serial.println(F(" Hz"));
+    }
+  }
+
+  // 1) sample one window at the Timer1 rate and compute RMS
+  double vrms = measureRmsWindow(); // RMS in ADC units
 
   // Smooth value for stable display
   smoothRms = (SMOOTH_ALPHA * vrms) + (1.0 - SMOOTH_ALPHA) * smoothRms;
@@ -99,13 +181,16 @@ void loop() {
     lastState = isQuiet;
   }
 
-  // Debug (optional)
-   Serial.print("vrms: "); Serial.print(vrms,2);
-   Serial.print("quietLevel: "); Serial.print(quietLevel,2);
-   Serial.print(" smooth: "); Serial.print(smoothRms,2);
-   Serial.print(" rel: "); Serial.println(rel,2);
+  // Debug (optional): queued, sent during the pause and the next window
+  int32_t v[4] = {
+    (int32_t)(vrms * 1000), (int32_t)(quietLevel * 1000),
+    (int32_t)(smoothRms * 1000), (int32_t)(rel * 1000)
+  };
+  logQueue.push(millis(), isQuiet, v);
 
-  delay(80); // small pause — controls refresh speed
+  // small pause — controls refresh speed
+  unsigned long pauseStart = millis();
+  while (millis() - pauseStart < 80) logQueue.pump(Serial);
 }
 
 // Simple quick calibration: sample a few times and set quietLevel
@@ -113,27 +198,7 @@ void quickCalibrate() {
   const int PASSES = 5;
   double vals[PASSES];
   for (int p = 0; p < PASSES; p++) {
-    unsigned long t0 = millis();
-    unsigned long tend = t0 + WINDOW_MS;
-    long n = 0;
-    double acc = 0.0;
-    while (millis() < tend) {
-      acc += analogRead(MIC_PIN);
-      n++;
-      delayMicroseconds(SAMPLE_DELAY_US);
-    }
-    if (n == 0) n = 1;
-    double mean = acc / (double)n;
-
-    double ss = 0.0;
-    for (int i = 0; i < n; i++) {
-      double v = analogRead(MIC_PIN) - mean;
-      ss += v * v;
-      delayMicroseconds(SAMPLE_DELAY_US);
-    }
-    double msq = ss / (double)max(1, (int)n);
-    double rms = sqrt(msq);
-    vals[p] = rms;
+    vals[p] = measureRmsWindow();
     delay(40);
   }
   // sort and pick middle value (median-ish)
@@ -146,31 +211,307 @@ void quickCalibrate() {
   }
   quietLevel = vals[PASSES / 2];
   calibrated = true;
-  Serial.print("Calibrated quietLevel = ");
+  Serial.print(F("Calibrated quietLevel = "));
   Serial.println(quietLevel, 3);
 }
 
-// Display smiley or angry face (simple text-based faces)
-void updateDisplay(bool quiet) {
-  display.clearDisplay();
-
-  display.setTextSize(1);
-  display.setCursor(0,0);
-  display.print("Noise Meter");
-
-  display.setTextSize(4);
-  display.setCursor(28, 18);
-  if (quiet) {
-    display.println(":)"); // smiley
-    display.setTextSize(1);
-    display.setCursor(80, 52);
-    display.println("Quiet");
+// One window: single pass of sum and sum of squares in the ADC ISR, RMS
+// (ADC units, fractional when oversampling) about the window mean
+double measureRmsWindow() {
+  uint16_t want = acqWindowSamples();
+  if (acqQuiet) {
+    acqRunQuiet(want);
   } else {
-    display.println(">:("); // angry
-    display.setTextSize(1);
-    display.setCursor(80, 52);
-    display.println("Loud!");
-    delayMicroseconds(2000);
+    acqStart(want);
+    unsigned long windowMs = want * 1000UL * (1 << (2 * acqOsShift)) / acqRawRate();
+    unsigned long start = millis();
+    while (!acqDone) {
+      logQueue.pump(Serial);
+      if (millis() - start > 2 * windowMs + 10) break; // ADC not running
+    }
+  }
+
+  uint16_t n, triggers;
+  int32_t sum;
+  uint32_t ss;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    ADCSRA &= ~(_BV(ADATE) | _BV(ADIE));
+    TIMSK1 &= ~_BV(OCIE1B);
+    acqDone = true;
+    n = acqCount; triggers = acqTriggers; sum = acqSum; ss = acqSumSq;
+  }
+  acqTotalSamples += n;
+  acqTotalTriggers += triggers;
+  if (triggers > 0) acqEffectiveRate = acqRawRate() * n / triggers;
+  if (n == 0) return 0.0;
+
+  // sums are in ADC counts x 2^k when oversampling
+  double mean = (double)sum / n;
+  double msq = (double)ss / n - mean * mean;
+  acqDc += (int16_t)lround(mean);
+  double rms = msq > 0.0 ? sqrt(msq) / (1 << acqOsShift) : 0.0;
+  if (rms < floorRms[acqQuiet]) floorRms[acqQuiet] = rms;
+  return rms;
+}
+
+// Sleep modes and Timer1 set-up for quietWindow() (QuietSampler.h)
+struct AcqQuietHw {
+  bool done() { return acqDone; }
+  uint16_t sinceTrigger() { return TCNT1; }
+
+  void idleUntilTrigger() {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    while (!acqPending) {
+      sleep_enable();
+      sei();
+      sleep_cpu();
+      sleep_disable();
+      cli();
+    }
+    sei();
+  }
+
+  // ADC Noise Reduction sleep starts the conversion; with RX busy it is
+  // started awake instead
+  void convertAsleep() {
+    set_sleep_mode(SLEEP_MODE_ADC);
+    cli();
+    if (acqRxEdge) {
+      sei();
+      ADCSRA |= _BV(ADSC);
+    } else if (acqPending) {
+      sleep_enable();
+      sei();
+      sleep_cpu();
+      sleep_disable();
+    }
+    sei();
+    while (acqPending) {}       // woken early by another source: wait for the ADC
+  }
+
+  void convertAwake() {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    while (acqPending) {
+      sleep_enable();
+      sei();
+      sleep_cpu();
+      sleep_disable();
+      cli();
+    }
+    sei();
+  }
+
+  // shortened period while sleeping, auto-trigger at the normal period awake
+  void nrTiming(bool nr) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      uint16_t top = nr ? ACQ_NR_TOP : ACQ_TIMER_TOP;
+      OCR1A = top;
+      OCR1B = top;
+      TCNT1 = 0;
+      TIFR1 = _BV(OCF1B);
+      acqPending = false;
+      if (nr) ADCSRA &= ~_BV(ADATE);
+      else ADCSRA |= _BV(ADATE);
+    }
+  }
+
+  bool rxSeen() {
+    bool seen = acqRxEdge || Serial.available();
+    acqRxEdge = false;
+    return seen;
+  }
+};
+
+// Quiet window: Idle sleep until each Timer1 trigger, then ADC Noise Reduction
+// sleep, which starts the conversion; the ADC ISR wakes the core with the
+// result. Serial input switches to awake conversions for a while.
+void acqRunQuiet(uint16_t samples) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    acqTarget = samples;
+    acqCount = 0;
+    acqTriggers = 0;
+    acqSum = 0;
+    acqSumSq = 0;
+    acqPending = false;
+    acqDone = false;
+    TIMSK1 |= _BV(OCIE1B);
+    ADCSRA |= _BV(ADIF) | _BV(ADIE);
   }
-  display.display();
+
+  PCMSK2 |= _BV(PCINT16);       // RX pin change wakes the CPU
+  PCIFR = _BV(PCIF2);
+  PCICR |= _BV(PCIE2);
+  AcqQuietHw hw;                // nrTiming() sets Timer1 and ADATE
+  quietWindow(hw, quietStats, ACQ_NR_TOP + 1, ACQ_TIMER_TOP + 1, ACQ_CONV_TICKS);
+  PCICR &= ~_BV(PCIE2);
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    OCR1A = ACQ_TIMER_TOP;
+    OCR1B = ACQ_TIMER_TOP;
+  }
+}
+
+void acqInit() {
+  // ADC: AVCC reference, mic channel, /128 clock, auto-trigger on Timer1 compare B
+  ADMUX = _BV(REFS0) | ((MIC_PIN - A0) & 0x07);
+  ADCSRB = _BV(ADTS2) | _BV(ADTS0);
+  ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  DIDR0 |= _BV(MIC_PIN - A0);
+
+  // Timer1: CTC with TOP = OCR1A; compare B at TOP triggers the ADC, so TCNT1
+  // read in the ADC ISR is the time since that sample's trigger
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS10);
+  OCR1A = ACQ_TIMER_TOP;
+  OCR1B = ACQ_TIMER_TOP;
+  TIMSK1 = 0;
+}
+
+void acqStart(uint16_t samples) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    acqTarget = samples;
+    acqCount = 0;
+    acqOsAcc = 0;
+    acqOsCount = 0;
+    acqTriggers = 0;
+    acqSum = 0;
+    acqSumSq = 0;
+    acqPending = false;
+    acqDone = false;
+    TCNT1 = 0;
+    TIFR1 = _BV(OCF1B);
+    TIMSK1 |= _BV(OCIE1B);
+    ADCSRA |= _BV(ADIF) | _BV(ADATE) | _BV(ADIE);
+  }
+}
+
+// Wakes the CPU from ADC Noise Reduction sleep on an RX start bit
+ISR(PCINT2_vect) {
+  acqRxEdge = true;
+}
+
+// A trigger while the previous result is still unread is an overrun
+ISR(TIMER1_COMPB_vect) {
+  if (acqPending) acqOverruns++;
+  acqPending = true;
+  acqTriggers++;
+}
+
+ISR(ADC_vect) {
+  uint16_t lat = TCNT1;
+  uint16_t raw = ADC;
+  acqPending = false;
+  if (!acqQuiet) {            // TCNT1 is frozen during quiet conversions
+    if (lat < acqLatMin) acqLatMin = lat;
+    if (lat > acqLatMax) acqLatMax = lat;
+  }
+
+  // oversampling: a boxcar sum of 4^k raw samples (first-order CIC), >> k
+  if (acqOsShift) {
+    acqOsAcc += raw;
+    if (++acqOsCount < (1 << (2 * acqOsShift))) return;
+    raw = acqOsAcc >> acqOsShift;
+    acqOsAcc = 0;
+    acqOsCount = 0;
+  }
+  int16_t c = (int16_t)raw - acqDc;
+
+  acqSum += c;
+  acqSumSq += (uint32_t)((int32_t)c * c);
+  if (++acqCount >= acqTarget) {
+    ADCSRA &= ~(_BV(ADATE) | _BV(ADIE));
+    TIMSK1 &= ~_BV(OCIE1B);
+    acqDone = true;
+  }
+}
+
+// Switch the capture between the normal 5 kHz path (shift 0) and 4^shift
+// oversampling; the next window starts with the new rate
+void acqSetOversample(uint8_t shift) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    acqOsShift = shift;
+    uint16_t top = shift ? ACQ_OS_TOP : ACQ_TIMER_TOP;
+    OCR1A = top;
+    OCR1B = top;
+    acqDc = 512 << shift;
+  }
+}
+
+// Raw trigger rate of the current mode
+float acqRawRate() {
+  return acqOsShift ? ACQ_OS_RAW_HZ : ACQ_RATE_HZ;
+}
+
+// Output samples per WINDOW_MS window at the current output rate
+uint16_t acqWindowSamples() {
+  if (!acqOsShift) return WINDOW_SAMPLES;
+  uint16_t n = WINDOW_MS * acqRawRate() / (1000UL << (2 * acqOsShift));
+  return n < ACQ_MIN_WINDOW ? ACQ_MIN_WINDOW : n;
+}
+
+// Set vs effective rate, overruns, ADC ISR latency spread, noise floor per
+// mode and NR sleep duty cycle (then reset)
+void printAcqStats() {
+  uint16_t latMin, latMax, overruns;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    latMin = acqLatMin; latMax = acqLatMax; overruns = acqOverruns;
+    acqLatMin = 0xFFFF; acqLatMax = 0; acqOverruns = 0;
+  }
+  if (latMin > latMax) latMin = latMax = 0;
+
+  if (acqOsShift) {
+    Serial.print(F("oversampling x")); Serial.print(1 << (2 * acqOsShift));
+    Serial.print(F(" (")); Serial.print(10 + acqOsShift); Serial.println(F(" bit), rates are output samples"));
+  }
+  Serial.print(F("rate set ")); Serial.print(acqRawRate() / (1 << (2 * acqOsShift)), 1);
+  Serial.print(F(" Hz, effective ")); Serial.print(acqEffectiveRate, 1);
+  Serial.println(F(" Hz"));
+  Serial.print(F("samples ")); Serial.print(acqTotalSamples);
+  Serial.print(F(" / triggers ")); Serial.print(acqTotalTriggers);
+  Serial.print(F(", overruns ")); Serial.println(overruns);
+  Serial.print(F("ISR latency min ")); Serial.print(latMin / 16.0f, 2);
+  Serial.print(F(" us, max ")); Serial.print(latMax / 16.0f, 2);
+  Serial.print(F(" us, jitter ")); Serial.print((latMax - latMin) / 16.0f, 2);
+  Serial.println(F(" us"));
+
+  Serial.print(F("floor rms normal ")); Serial.print(floorRms[0] < 1e9 ? floorRms[0] : 0.0, 3);
+  Serial.print(F(", NR sleep ")); Serial.println(floorRms[1] < 1e9 ? floorRms[1] : 0.0, 3);
+  floorRms[0] = floorRms[1] = 1e9;
+
+  uint32_t total = quietStats.awakeTicks + quietStats.idleTicks + quietStats.sleepTicks;
+  if (total > 0) {
+    Serial.print(F("NR duty: awake ")); Serial.print(100.0f * quietStats.awakeTicks / total, 1);
+    Serial.print(F("%, idle ")); Serial.print(100.0f * quietStats.idleTicks / total, 1);
+    Serial.print(F("%, ADC sleep ")); Serial.print(100.0f * quietStats.sleepTicks / total, 1);
+    Serial.print(F("%, ")); Serial.print(quietStats.rxSamples);
+    Serial.println(F(" samples awake for serial input"));
+  }
+  quietStats.awakeTicks = quietStats.idleTicks = quietStats.sleepTicks = 0;
+  quietStats.rxSamples = 0;
+  acqTotalSamples = 0;
+  acqTotalTriggers = 0;
+}
+
+// Display smiley or angry face (simple text-based faces)
+// Screen widgets: title once, face and caption only when quiet/loud flips
+// (all in flash: F() cannot be used at global scope)
+const char TITLE_TEXT[] PROGMEM = "Noise Meter";
+const char FACE_LOUD[] PROGMEM = ">:(";
+const char FACE_QUIET[] PROGMEM = ":)";
+const char CAPTION_LOUD[] PROGMEM = "Loud!";
+const char CAPTION_QUIET[] PROGMEM = "Quiet";
+const char *const NOISE_FACES[] PROGMEM = { FACE_LOUD, FACE_QUIET };     // index = quiet
+const char *const NOISE_CAPTIONS[] PROGMEM = { CAPTION_LOUD, CAPTION_QUIET };
+LabelWidget titleLabel(0, 0, 1, TITLE_TEXT, true);
+FaceWidget faceWidget(28, 18, 72, 4, NOISE_FACES, true);
+FaceWidget captionWidget(80, 52, 48, 1, NOISE_CAPTIONS, true);
+
+void updateDisplay(bool quiet) {
+  bool changed = titleLabel.draw(display);
+  changed |= faceWidget.set(display, quiet ? 1 : 0);
+  changed |= captionWidget.set(display, quiet ? 1 : 0);
+  if (!quiet) delayMicroseconds(2000);
+  if (changed) display.display();   // nothing to send while the mood holds
 }
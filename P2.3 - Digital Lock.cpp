@@ -7,6 +7,12 @@
   - PIN is "1234"
   - Press '#' to submit (open if PIN matches)
   - Press '*' to immediately lock (close)
+  - Optional second factor: a clap/knock rhythm on the sound sensor.
+    While unlocked press 'A' to enrol a rhythm (stored in EEPROM), 'B' to
+    remove it. With a rhythm enrolled, a correct PIN asks for the rhythm,
+    and only a matching rhythm opens the lock. The match ignores tempo.
+    Short rhythms are easy to guess: use 6 or more claps with uneven gaps
+    (tests/RhythmTest.cpp measures the false-accept and false-reject rates).
 
   Wiring (Arduino UNO example):
   --------------------------------
@@ -18,7 +24,10 @@
 
   4x4 Keypad (example pins)
     Rows -> D9, D8, D7, D6
-    Cols -> D5, D4, D3, D2
+    Cols -> D5, D4, D3, D12   (D2 is kept for the sound sensor interrupt)
+
+  LM393 sound sensor:
+    D0 -> D2 (INT0)
 
   Buzzer:
     + -> D10
@@ -32,21 +41,33 @@
   Libraries required:
     Keypad.h
     Adafruit_GFX.h
-    Adafruit_SSD1306.h
+    Adafruit_SSD1306.h   (only for names; OledPaged.h drives the panel)
     Servo.h
+    EEPROM.h
+
+  The OLED is drawn page by page (OledPaged.h) instead of through a 1 KB
+  framebuffer, which leaves the RAM for the keypad, String and rhythm code.
+  Send 'u' on Serial (9600) to print the RAM use and the stack high-water
+  mark (RamMonitor.h).
+
+  Timing bugs (a key during the beep, a clap during a message) can be
+  recorded and replayed (InputTrace.h): send 'R' to restart and record the
+  keys and claps, 'P' to restart and replay them exactly (much faster than
+  real time, ends with the CRC of the last screen), 'D' to print the trace.
 */
 
 #include <Wire.h>
 #include <Keypad.h>
 #include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
 #include <Servo.h>
+#include <EEPROM.h>
+#include "OledPaged.h"
+#include "RamMonitor.h"
+#include "InputTrace.h"
+#include "Rhythm.h"
 
 // ---------- OLED setup ----------
-#define SCREEN_WIDTH 128
-#define SCREEN_HEIGHT 64
-#define OLED_RESET    -1
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+PagedOled display;   // 128x64, one 128-byte page in RAM
 
 // ---------- Keypad setup ----------
 const byte ROWS = 4;
@@ -58,7 +79,7 @@ char keysArr[ROWS][COLS] = {
   {'*','0','#','D'}
 };
 byte rowPins[ROWS] = {9, 8, 7, 6};
-byte colPins[COLS] = {5, 4, 3, 2};
+byte colPins[COLS] = {5, 4, 3, 12};
 Keypad keypad = Keypad(makeKeymap(keysArr), rowPins, colPins, ROWS, COLS);
 
 // ---------- Buzzer & Servo ----------
@@ -78,15 +99,41 @@ const int SERVO_UNLOCKED_POS = 90;  // open/unlocked
 // Optional: visual timings
 const unsigned long STATUS_SHOW_MS = 1200; // how long to show "Unlocked" or "Wrong PIN"
 
+// ---------- Clap rhythm (second factor) ----------
+// Clap count limits and match tolerances are in Rhythm.h
+const int SOUND_PIN = 2;                  // LM393 D0, INT0
+const unsigned long CLAP_REFRACTORY_US = 80000UL; // one clap rings for a while
+const unsigned long RHYTHM_END_MS = 1500; // silence that ends a rhythm
+const unsigned long RHYTHM_WAIT_MS = 8000; // time allowed to start clapping
+const int RHYTHM_EEPROM_ADDR = 0;
+const uint8_t RHYTHM_MAGIC = 0xC7;
+
+RhythmRecord enrolled;
+bool rhythmEnrolled = false;
+
+// Input trace in the EEPROM after the rhythm
+InputTrace trace(RHYTHM_EEPROM_ADDR + sizeof(RhythmRecord));
+
+// Onset timestamps captured by the INT0 ISR
+volatile unsigned long onsetUs[RHYTHM_MAX];
+volatile uint8_t onsetCount = 0;
+volatile unsigned long lastOnsetUs = 0;
+
+enum LockMode { MODE_PIN, MODE_RHYTHM, MODE_ENROLL };
+LockMode mode = MODE_PIN;
+bool unlocked = false;
+unsigned long modeStartMs = 0;
+uint8_t shownClaps = 0;
+
 void setup() {
   Serial.begin(9600);
+  trace.begin(0);
 
   // Init OLED
-  if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
+  if (!display.begin(0x3C)) {
     Serial.println(F("SSD1306 init failed"));
     for (;;);
   }
-  display.clearDisplay();
   display.setTextColor(SSD1306_WHITE);
 
   // Init buzzer pin
@@ -97,31 +144,70 @@ void setup() {
   lockServo.attach(SERVO_PIN);
   lockServo.write(SERVO_LOCKED_POS); // start locked
 
+  // Sound sensor: clap onsets are timestamped in the INT0 ISR
+  pinMode(SOUND_PIN, INPUT);
+  if (trace.replaying()) trace.onEdge(0, onClap);   // claps come from the trace
+  else attachInterrupt(digitalPinToInterrupt(SOUND_PIN), onClap, RISING);
+  loadRhythm();
+
   // Show startup message
-  display.setTextSize(1);
-  display.setCursor(0,0);
-  display.println("Digital Safe");
-  display.setCursor(0,12);
-  display.println("Enter PIN and press #");
-  display.display();
-  delay(900);
+  display.firstPage();
+  do {
+    display.setTextSize(1);
+    display.setCursor(0,0);
+    display.println(F("Digital Safe"));
+    display.setCursor(0,12);
+    display.println(F("Enter PIN and press #"));
+  } while (display.nextPage());
+  trace.delay(900);
   showStatus(); // draw initial screen
 }
 
 void loop() {
-  char k = keypad.getKey(); // non-blocking
+  if (trace.poll()) {   // replay finished: fingerprint of the last screen
+    Serial.print(F("#FRAME "));
+    Serial.println(display.frameCrc(), HEX);
+  }
+  if (Serial.available()) {
+    char c = Serial.read();
+    if (c == 'u') ramReport(Serial);
+    else trace.command(c);
+  }
+
+  char k = trace.key(keypad.getKey()); // non-blocking
+
+  // Waiting for a clap rhythm: checked every loop so the servo reacts at once
+  if (mode != MODE_PIN && k != '*') {
+    handleRhythm();
+    return;
+  }
 
   if (k) {
     lastKey = k;
-    Serial.print("Key: "); Serial.println(k);
+    Serial.print(F("Key: ")); Serial.println(k);
 
     beep(); // sound feedback
 
     // If '*' pressed -> immediate lock (clear input)
     if (k == '*') {
       inputBuf = "";
+      mode = MODE_PIN;
+      unlocked = false;
       lockServo.write(SERVO_LOCKED_POS);
-      showTemporaryMessage("Locked", STATUS_SHOW_MS);
+      showTemporaryMessage(F("Locked"), STATUS_SHOW_MS);
+      showStatus();
+      return;
+    }
+
+    // While open: 'A' enrols a clap rhythm, 'B' removes it
+    if (unlocked && k == 'A') {
+      startRhythm(MODE_ENROLL);
+      return;
+    }
+    if (unlocked && k == 'B') {
+      rhythmEnrolled = false;
+      if (trace.live()) EEPROM.update(RHYTHM_EEPROM_ADDR, 0xFF);
+      showTemporaryMessage(F("Rhythm off"), STATUS_SHOW_MS);
       showStatus();
       return;
     }
@@ -129,12 +215,15 @@ void loop() {
     // If '#' pressed -> submit attempt
     if (k == '#') {
       // Check PIN
-      if (inputBuf == CORRECT_PIN) {
-        lockServo.write(SERVO_UNLOCKED_POS); // open
-        showTemporaryMessage("Unlocked!", STATUS_SHOW_MS);
+      if (inputBuf == CORRECT_PIN && rhythmEnrolled) {
+        inputBuf = "";
+        startRhythm(MODE_RHYTHM);   // second factor
+        return;
+      } else if (inputBuf == CORRECT_PIN) {
+        openLock();
       } else {
         // wrong PIN
-        showTemporaryMessage("Wrong PIN", STATUS_SHOW_MS);
+        showTemporaryMessage(F("Wrong PIN"), STATUS_SHOW_MS);
       }
       inputBuf = ""; // clear buffer after attempt
       showStatus();
@@ -161,46 +250,152 @@ void loop() {
 
 // ---------- helper functions ----------
 
+void openLock() {
+  unlocked = true;
+  lockServo.write(SERVO_UNLOCKED_POS); // open
+  showTemporaryMessage(F("Unlocked!"), STATUS_SHOW_MS);
+}
+
+// INT0: timestamp a clap onset, ignoring the ringing right after it. Only
+// the onsets go into the trace: the ringing would fill its 4-event ring.
+void onClap() {
+  unsigned long now = trace.micros();
+  if (now - lastOnsetUs < CLAP_REFRACTORY_US) return;
+  trace.edge(0, now);
+  lastOnsetUs = now;
+  if (onsetCount < RHYTHM_MAX) onsetUs[onsetCount++] = now;
+}
+
+void startRhythm(LockMode m) {
+  noInterrupts();
+  onsetCount = 0;
+  interrupts();
+  mode = m;
+  modeStartMs = trace.millis();
+  shownClaps = 0;
+  trace.state(m == MODE_ENROLL ? F("Enrol rhythm") : F("Clap rhythm"));
+  showRhythmPrompt();
+}
+
+// Runs every loop while a rhythm is expected: a rhythm ends after
+// RHYTHM_END_MS of silence (or RHYTHM_MAX claps), then it is matched at once
+void handleRhythm() {
+  noInterrupts();
+  uint8_t n = onsetCount;
+  unsigned long last = lastOnsetUs;
+  interrupts();
+
+  if (n != shownClaps) {
+    shownClaps = n;
+    showRhythmPrompt();
+  }
+
+  bool ended = n > 0 && (n == RHYTHM_MAX || trace.micros() - last > RHYTHM_END_MS * 1000UL);
+  if (!ended) {
+    if (n == 0 && trace.millis() - modeStartMs > RHYTHM_WAIT_MS) {
+      mode = MODE_PIN;
+      showTemporaryMessage(F("Timed out"), STATUS_SHOW_MS);
+      showStatus();
+    }
+    return;
+  }
+
+  uint16_t ioi[RHYTHM_MAX - 1];
+  rhythmNormalise(onsetUs, n, ioi);
+
+  if (mode == MODE_ENROLL) {
+    if (n < RHYTHM_MIN) {
+      showTemporaryMessage(F("Too short"), STATUS_SHOW_MS);
+    } else {
+      enrolled.magic = RHYTHM_MAGIC;
+      enrolled.claps = n;
+      for (uint8_t i = 0; i < n - 1; i++) enrolled.ioi[i] = ioi[i];
+      if (trace.live()) EEPROM.put(RHYTHM_EEPROM_ADDR, enrolled);   // a replay starts from the same EEPROM
+      rhythmEnrolled = true;
+      showTemporaryMessage(F("Rhythm set"), STATUS_SHOW_MS);
+    }
+    mode = MODE_PIN;
+    showStatus();
+    return;
+  }
+
+  mode = MODE_PIN;
+  if (rhythmMatches(enrolled, n, ioi)) {
+    openLock();
+  } else {
+    showTemporaryMessage(F("Wrong beat"), STATUS_SHOW_MS);
+  }
+  showStatus();
+}
+
+void loadRhythm() {
+  EEPROM.get(RHYTHM_EEPROM_ADDR, enrolled);
+  rhythmEnrolled = enrolled.magic == RHYTHM_MAGIC &&
+                   enrolled.claps >= RHYTHM_MIN && enrolled.claps <= RHYTHM_MAX;
+}
+
+// Prompt while a rhythm is being clapped, with the claps heard so far
+void showRhythmPrompt() {
+  display.firstPage();
+  do {
+    display.setTextSize(1);
+    display.setCursor(0,0);
+    display.println(mode == MODE_ENROLL ? F("New rhythm") : F("Clap your rhythm"));
+    display.setCursor(0,12);
+    display.println(F("* to cancel"));
+    display.setTextSize(2);
+    display.setCursor(0, 34);
+    display.print(F("Claps: "));
+    display.print(shownClaps);
+  } while (display.nextPage());
+}
+
 // Simple beep for feedback
 void beep() {
   tone(BUZZER_PIN, 1000, 120); // 1kHz, 120 ms
-  delay(140);                  // small wait so tone plays (short)
+  trace.delay(140);            // small wait so tone plays (short)
   noTone(BUZZER_PIN);
 }
 
 // Show main OLED status (last key + masked PIN)
 void showStatus() {
-  display.clearDisplay();
-
-  display.setTextSize(1);
-  display.setCursor(0,0);
-  display.println("Digital Safe");
-
-  // show last key pressed
-  display.setTextSize(1);
-  display.setCursor(0,14);
-  display.print("Last Key: ");
-  if (lastKey != 0) display.print(lastKey); else display.print("-");
-
-  // show masked PIN input
-  display.setTextSize(2);
-  display.setCursor(0, 34);
-  String masked = "";
-  for (unsigned int i = 0; i < inputBuf.length(); i++) masked += '*';
-  if (masked.length() == 0) masked = "--"; // show placeholder when empty
-  display.print(masked);
-
-  display.display();
+  char keyText[2] = { lastKey != 0 ? lastKey : '-', '\0' };
+
+  // masked PIN input, placeholder when empty
+  char masked[9];
+  uint8_t n = inputBuf.length() < 8 ? inputBuf.length() : 8;
+  for (uint8_t i = 0; i < n; i++) masked[i] = '*';
+  masked[n] = '\0';
+  if (n == 0) strcpy(masked, "--");
+
+  display.firstPage();
+  do {
+    display.setTextSize(1);
+    display.setCursor(0,0);
+    display.println(F("Digital Safe"));
+
+    // show last key pressed
+    display.setCursor(0,14);
+    display.print(F("Last Key: "));
+    display.print(keyText);
+
+    // show masked PIN input
+    display.setTextSize(2);
+    display.setCursor(0, 34);
+    display.print(masked);
+  } while (display.nextPage());
 }
 
 // Show a temporary message in the center, e.g., "Unlocked!" or "Wrong PIN"
-void showTemporaryMessage(const char *msg, unsigned long ms) {
-  display.clearDisplay();
-  display.setTextSize(2);
+void showTemporaryMessage(const __FlashStringHelper *msg, unsigned long ms) {
   int x = 0;
   int y = 18;
-  display.setCursor(x, y);
-  display.println(msg);
-  display.display();
-  delay(ms);
+  trace.state(msg);
+  display.firstPage();
+  do {
+    display.setTextSize(2);
+    display.setCursor(x, y);
+    display.println(msg);
+  } while (display.nextPage());
+  trace.delay(ms);
 }
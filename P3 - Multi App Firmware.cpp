@@ -0,0 +1,484 @@
+/*
+  Multi App - one firmware, pick the project on the keypad
+  - Instead of re-flashing the board for every project, the apps below
+    share one image and one set of drivers (Wire, OLED, keypad, servo):
+      1 Lock    PIN "1234" + '#' opens the servo, '*' locks (P2.3)
+      2 Target  clap exactly the target number in 5 s (P2.1.1)
+      3 Noise   :) when quiet, >:( when loud (P2.2.2)
+      4 Level   sound level in dBFS with a 12 s history graph
+  - The menu shows the apps; press 1-4 to start one, C to come back.
+  - Each app keeps its state in a shared arena (AppHost.h): only the
+    running app has RAM, and it is all given back when it stops.
+  - Serial (9600):
+      u : flash and RAM use (RamMonitor.h) and arena use
+      s : switch test - starts and stops every app 10 times and checks
+          that no RAM stays taken: the heap must not grow, no app may
+          take arena after its setup() or more in one start than in the
+          first, and the least free RAM ever (painted bytes) must not
+          shrink after the first round, when every app has run once
+  - Flash/RAM against the separate sketches: compile this one and each of
+    P2.3 / P2.1.1 / P2.2.2 (Sketch > Verify) and compare the "Sketch uses"
+    and "Global variables use" lines. Add the OLED framebuffer (1024 bytes,
+    allocated at run time) to the sketches that use Adafruit_SSD1306.
+    On the board, 'u' prints the same two numbers: [FLASH] used= and
+    data + bss of the [RAM] line. No numbers here yet: they have not been
+    measured with the AVR compiler.
+
+  Wiring (Arduino UNO), the Digital Lock's plus the mic's analog output:
+    SSD1306 (I2C): VCC->5V, GND->GND, SDA->A4, SCL->A5
+    4x4 Keypad: Rows -> D9, D8, D7, D6   Cols -> D5, D4, D3, D12
+    LM393 sound sensor: D0 -> D2, AO -> A0
+    Buzzer: + -> D10, - -> GND
+    SG90 Servo: Signal -> D11, Red -> 5V, Brown -> GND
+
+  Libraries required:
+    Keypad.h
+    Adafruit_GFX.h
+    Adafruit_SSD1306.h   (only for names; OledPaged.h drives the panel)
+    Servo.h
+*/
+
+#include <Wire.h>
+#include <Keypad.h>
+#include <Adafruit_GFX.h>
+#include <Servo.h>
+#include <math.h>
+#include "OledPaged.h"
+#include "RamMonitor.h"
+#include "AppHost.h"
+
+// ---------- Shared drivers ----------
+PagedOled display;   // 128x64, one 128-byte page in RAM
+
+const byte ROWS = 4;
+const byte COLS = 4;
+char keysArr[ROWS][COLS] = {
+  {'1','2','3','A'},
+  {'4','5','6','B'},
+  {'7','8','9','C'},
+  {'*','0','#','D'}
+};
+byte rowPins[ROWS] = {9, 8, 7, 6};
+byte colPins[COLS] = {5, 4, 3, 12};
+Keypad keypad = Keypad(makeKeymap(keysArr), rowPins, colPins, ROWS, COLS);
+
+const int SOUND_PIN = 2;     // LM393 D0
+const int MIC_PIN = A0;      // LM393 AO
+const int BUZZER_PIN = 10;
+const int SERVO_PIN = 11;
+Servo lockServo;
+
+const char MENU_KEY = 'C';   // back to the menu from any app
+
+// ---------- Apps ----------
+void lockSetup();
+void lockLoop(char key);
+void lockTeardown();
+void targetSetup();
+void targetLoop(char key);
+void noiseSetup();
+void noiseLoop(char key);
+void levelSetup();
+void levelLoop(char key);
+
+const App APPS[] PROGMEM = {
+  { "Lock",   lockSetup,   lockLoop,   lockTeardown },
+  { "Target", targetSetup, targetLoop, nullptr },
+  { "Noise",  noiseSetup,  noiseLoop,  nullptr },
+  { "Level",  levelSetup,  levelLoop,  nullptr },
+};
+const uint8_t APP_COUNT = sizeof(APPS) / sizeof(APPS[0]);
+const uint16_t ARENA_BYTES = 160;    // largest app state (Level, 126 bytes) fits
+AppHost<ARENA_BYTES> host(APPS, APP_COUNT);
+
+extern char __data_load_end;   // end of program + initial values in flash
+
+void drawMenu();
+void switchTest();
+uint16_t micRms(uint16_t ms);
+
+void setup() {
+  Serial.begin(9600);
+  if (!display.begin(0x3C)) {
+    Serial.println(F("SSD1306 init failed"));
+    for (;;);
+  }
+  display.setTextColor(SSD1306_WHITE);
+  pinMode(BUZZER_PIN, OUTPUT);
+  pinMode(SOUND_PIN, INPUT);
+  randomSeed(analogRead(A3));
+  drawMenu();
+}
+
+void loop() {
+  if (Serial.available()) {
+    char c = Serial.read();
+    if (c == 'u') {
+      Serial.print(F("[FLASH] used="));
+      Serial.println((uint16_t)(uintptr_t)&__data_load_end);
+      ramReport(Serial);
+      Serial.print(F("[ARENA] used="));
+      Serial.print(host.used());
+      Serial.print(F(" peak="));
+      Serial.print(host.peak());
+      Serial.print(F(" size="));
+      Serial.println(host.size());
+    } else if (c == 's') {
+      switchTest();
+    }
+  }
+
+  char k = keypad.getKey();
+  if (host.active() == host.NONE) {
+    if (k >= '1' && k < '1' + APP_COUNT) host.start(k - '1');
+    return;
+  }
+  if (k == MENU_KEY) {
+    host.stop();
+    drawMenu();
+    return;
+  }
+  host.loop(k);
+}
+
+void drawMenu() {
+  display.firstPage();
+  do {
+    display.setTextSize(1);
+    display.setCursor(0, 0);
+    display.print(F("Pick an app (C=menu)"));
+    for (uint8_t i = 0; i < APP_COUNT; i++) {
+      char name[10];
+      host.name(i, name);
+      display.setCursor(6, 14 + i * 12);
+      display.print(i + 1);
+      display.print(F("  "));
+      display.print(name);
+    }
+  } while (display.nextPage());
+}
+
+// Start and stop every app again and again; RAM must come back each time.
+// A malloc() an app never frees moves the heap end up. The arena is a
+// global, so alloc() leaks move neither heap nor stack: they show as arena
+// taken after setup(), or as a setup() that takes more than the last time.
+// Globals an app keeps outside the arena cannot grow, but hold RAM while
+// other apps run: tools/ram_report.py lists them. Anything else that
+// keeps taking RAM (heap or stack) eats into the painted bytes, so the
+// least free RAM ever keeps shrinking from round to round. The first round
+// is allowed to lower it: that is each app's own deepest stack. Later
+// rounds get SWITCH_SLACK bytes for an interrupt that happens to land on
+// the deepest call; a leak adds up over 36 switches.
+const int SWITCH_SLACK = 32;
+
+void switchTest() {
+  uint8_t was = host.active();
+  host.stop();
+  char *heap = ramHeapEnd();
+  int minFreeBefore = ramMinFree();
+  int minFreeSettled = 0;
+  uint16_t setupUsed[APP_COUNT];
+  uint16_t arenaGrew = 0;
+  bool ok = true;
+  uint16_t switches = 0;
+  for (uint8_t round = 0; round < 10; round++) {
+    for (uint8_t i = 0; i < APP_COUNT; i++) {
+      host.start(i);
+      if (round == 0) setupUsed[i] = host.setupUsed();
+      for (uint8_t n = 0; n < 3; n++) host.loop(0);
+      arenaGrew += host.used() - host.setupUsed();
+      ok &= host.setupUsed() == setupUsed[i];
+      host.stop();
+      switches++;
+      ok &= ramHeapEnd() == heap;
+    }
+    if (round == 0) minFreeSettled = ramMinFree();
+  }
+  int minFreeAfter = ramMinFree();
+  ok &= arenaGrew == 0 && minFreeSettled - minFreeAfter <= SWITCH_SLACK;
+  Serial.print(ok ? F("# switch test ok ") : F("# switch test LEAK "));
+  Serial.print(switches);
+  Serial.print(F(" switches, heap +"));
+  Serial.print((int)(ramHeapEnd() - heap));
+  Serial.print(F(", arena +"));
+  Serial.print(arenaGrew);
+  Serial.print(F(", min free RAM "));
+  Serial.print(minFreeBefore);
+  Serial.print(F(" -> "));
+  Serial.print(minFreeSettled);
+  Serial.print(F(" -> "));
+  Serial.print(minFreeAfter);
+  Serial.print(F(", arena peak "));
+  Serial.print(host.peak());
+  Serial.print(F(" of "));
+  Serial.println(host.size());
+  if (was != host.NONE) host.start(was);
+  else drawMenu();
+}
+
+// RMS of the mic signal over ms milliseconds, ADC counts (mean removed)
+uint16_t micRms(uint16_t ms) {
+  unsigned long start = millis();
+  long sum = 0;
+  unsigned long sumSq = 0;
+  uint16_t n = 0;
+  while (millis() - start < ms && n < 250) {
+    int v = analogRead(MIC_PIN);
+    sum += v;
+    sumSq += (unsigned long)v * v;
+    n++;
+  }
+  float mean = (float)sum / n;
+  float ms2 = (float)sumSq / n - mean * mean;
+  return ms2 > 0 ? (uint16_t)sqrt(ms2) : 0;
+}
+
+void beep() {
+  tone(BUZZER_PIN, 1000, 120);   // 1 kHz, 120 ms, does not wait
+}
+
+// ---------- 1: Digital Lock ----------
+const char LOCK_PIN[] = "1234";
+const int SERVO_LOCKED_POS = 0;
+const int SERVO_UNLOCKED_POS = 90;
+const unsigned long STATUS_SHOW_MS = 1200;
+
+struct LockState {
+  char input[9];
+  uint8_t len;
+  char lastKey;
+  bool unlocked;
+  const __FlashStringHelper *msg;   // big message until msgUntil, nullptr = status
+  unsigned long msgUntil;
+};
+LockState *lock;
+
+void lockDraw() {
+  display.firstPage();
+  do {
+    if (lock->msg) {
+      display.setTextSize(2);
+      display.setCursor(0, 18);
+      display.println(lock->msg);
+      continue;
+    }
+    display.setTextSize(1);
+    display.setCursor(0, 0);
+    display.println(F("Digital Safe"));
+    display.setCursor(0, 14);
+    display.print(F("Last Key: "));
+    display.print(lock->lastKey ? lock->lastKey : '-');
+    display.setTextSize(2);
+    display.setCursor(0, 34);
+    if (lock->len == 0) display.print(F("--"));
+    for (uint8_t i = 0; i < lock->len; i++) display.print('*');
+  } while (display.nextPage());
+}
+
+void lockMessage(const __FlashStringHelper *msg) {
+  lock->msg = msg;
+  lock->msgUntil = millis() + STATUS_SHOW_MS;
+}
+
+void lockSetup() {
+  lock = (LockState *)host.alloc(sizeof(LockState));
+  lockServo.attach(SERVO_PIN);
+  lockServo.write(SERVO_LOCKED_POS);
+  lockDraw();
+}
+
+void lockLoop(char k) {
+  if (lock->msg && (long)(millis() - lock->msgUntil) >= 0) {
+    lock->msg = nullptr;
+    lockDraw();
+  }
+  if (!k) return;
+  lock->lastKey = k;
+  beep();
+
+  if (k == '*') {
+    lock->len = 0;
+    lock->unlocked = false;
+    lockServo.write(SERVO_LOCKED_POS);
+    lockMessage(F("Locked"));
+  } else if (k == '#') {
+    lock->input[lock->len] = '\0';
+    if (strcmp(lock->input, LOCK_PIN) == 0) {
+      lock->unlocked = true;
+      lockServo.write(SERVO_UNLOCKED_POS);
+      lockMessage(F("Unlocked!"));
+    } else {
+      lockMessage(F("Wrong PIN"));
+    }
+    lock->len = 0;
+  } else if (k == 'D') {
+    if (lock->len > 0) lock->len--;
+  } else if (k >= '0' && k <= '9' && lock->len < 8) {
+    lock->input[lock->len++] = k;
+  }
+  lockDraw();
+}
+
+// Leaving the app locks the safe and stops the servo pulses. Timer1 stays
+// set up by the Servo library, so no other app may use it.
+void lockTeardown() {
+  noTone(BUZZER_PIN);
+  lockServo.write(SERVO_LOCKED_POS);
+  delay(300);                     // let the servo get there
+  lockServo.detach();
+}
+
+// ---------- 2: Clap Target Game ----------
+const unsigned long TARGET_GAME_MS = 5000;   // 5 seconds to clap
+const unsigned long TARGET_RESULT_MS = 2000;
+const unsigned long CLAP_DEAD_MS = 150;      // one clap rings for a while
+
+struct TargetState {
+  uint8_t target;
+  uint8_t claps;
+  uint8_t lastLevel;
+  bool result;                    // showing the result
+  unsigned long since;            // start of the round / of the result
+  unsigned long lastClap;
+};
+TargetState *game;
+
+void targetDraw() {
+  display.firstPage();
+  do {
+    display.setTextSize(2);
+    if (game->result) {
+      display.setCursor(0, 10);
+      if (game->claps == game->target) display.println(F("You Win!"));
+      else if (game->claps < game->target) display.println(F("Too few!"));
+      else display.println(F("Too many!"));
+      display.setTextSize(1);
+      display.setCursor(0, 50);
+      display.print(F("Target:"));
+      display.print(game->target);
+      display.print(F(" You:"));
+      display.print(game->claps);
+      continue;
+    }
+    display.setTextSize(1);
+    display.setCursor(0, 0);
+    display.println(F("Target Game!"));
+    display.setTextSize(2);
+    display.setCursor(0, 20);
+    display.print(F("Target:"));
+    display.setCursor(90, 20);
+    display.print(game->target);
+    display.setCursor(0, 40);
+    display.print(F("You:"));
+    display.setCursor(90, 40);
+    display.print(game->claps);
+  } while (display.nextPage());
+}
+
+void targetNewRound() {
+  game->target = random(3, 9);    // target between 3 and 8
+  game->claps = 0;
+  game->result = false;
+  game->since = millis();
+  targetDraw();
+}
+
+void targetSetup() {
+  game = (TargetState *)host.alloc(sizeof(TargetState));
+  game->lastLevel = digitalRead(SOUND_PIN);
+  targetNewRound();
+}
+
+void targetLoop(char k) {
+  unsigned long now = millis();
+  if (game->result) {
+    if (now - game->since >= TARGET_RESULT_MS) targetNewRound();
+    return;
+  }
+  uint8_t s = digitalRead(SOUND_PIN);
+  if (s == HIGH && game->lastLevel == LOW && now - game->lastClap >= CLAP_DEAD_MS) {
+    game->lastClap = now;
+    game->claps++;
+    targetDraw();
+  }
+  game->lastLevel = s;
+  if (now - game->since >= TARGET_GAME_MS) {
+    game->result = true;
+    game->since = now;
+    targetDraw();
+  }
+}
+
+// ---------- 3: Noise faces ----------
+const int QUIET_THRESHOLD = 25;   // RMS, ADC counts - adjust for your room
+const float SMOOTH_ALPHA = 0.18;
+
+struct NoiseState {
+  float smooth;
+  int8_t shown;                   // face on screen: 1 quiet, 0 loud, -1 none yet
+};
+NoiseState *noise;
+
+void noiseSetup() {
+  noise = (NoiseState *)host.alloc(sizeof(NoiseState));
+  noise->shown = -1;
+}
+
+void noiseLoop(char k) {
+  uint16_t rms = micRms(20);
+  noise->smooth += SMOOTH_ALPHA * (rms - noise->smooth);
+  int8_t quiet = noise->smooth < QUIET_THRESHOLD;
+  if (quiet == noise->shown) return;
+  noise->shown = quiet;
+  display.firstPage();
+  do {
+    display.setTextSize(4);
+    display.setCursor(20, 14);
+    display.print(quiet ? F(":)") : F(">:("));
+    display.setTextSize(1);
+    display.setCursor(80, 56);
+    display.print(quiet ? F("Quiet") : F("Loud!"));
+  } while (display.nextPage());
+}
+
+// ---------- 4: Sound level ----------
+const unsigned long LEVEL_STEP_MS = 100;   // one history column per 100 ms
+const uint8_t LEVEL_W = 120;               // history columns (12 s)
+const int8_t LEVEL_MIN_DB = -60;           // bottom of the graph, dBFS
+
+struct LevelState {
+  uint8_t hist[LEVEL_W];                   // column heights, oldest at head
+  uint8_t head;
+  int8_t db;                               // newest reading, whole dBFS
+  unsigned long last;
+};
+LevelState *level;
+
+void levelSetup() {
+  level = (LevelState *)host.alloc(sizeof(LevelState));
+  level->db = LEVEL_MIN_DB;
+}
+
+void levelLoop(char k) {
+  if (millis() - level->last < LEVEL_STEP_MS) return;
+  level->last = millis();
+  uint16_t rms = micRms(20);
+  float db = rms > 0 ? 20.0 * log10(rms / 512.0) : LEVEL_MIN_DB;
+  if (db < LEVEL_MIN_DB) db = LEVEL_MIN_DB;
+  level->db = (int8_t)lround(db);
+  level->hist[level->head] = (uint8_t)((level->db - LEVEL_MIN_DB) * 48 / -LEVEL_MIN_DB);
+  level->head = (level->head + 1) % LEVEL_W;
+
+  display.firstPage();
+  do {
+    display.setTextSize(1);
+    display.setCursor(0, 0);
+    display.print(F("Level "));
+    display.print(level->db);
+    display.print(F(" dBFS"));
+    for (uint8_t x = 0; x < LEVEL_W; x++) {
+      uint8_t h = level->hist[(level->head + x) % LEVEL_W];
+      if (h) display.drawFastVLine(4 + x, 63 - h, h, SSD1306_WHITE);
+    }
+  } while (display.nextPage());
+}
@@ -0,0 +1,143 @@
+/* Packed10.h - 10-bit ADC samples, 4 in 5 bytes
+
+   An ADC reading has 10 bits; in a uint16_t slot 6 of every 16 bits are
+   wasted. Packed10<N> keeps N samples (0..1023, N a multiple of 4) in
+   N * 5 / 4 bytes: a 128-sample block takes 160 bytes instead of 256.
+   Every group of 4 samples is 5 bytes: the low 8 bits of each sample,
+   then one byte with the 4 top bit pairs (sample k in bits 2k..2k+1), so
+   one sample is one byte read plus a shift:
+
+     Packed10<128> block;
+     block.set(i, ADC);                  // any index, also from an ISR
+     uint16_t v = block.get(i);
+
+     Packed10<128>::Writer w(block);     // sequential, a little faster
+     w.put(ADC);
+     Packed10<128>::Reader r(block, 0);
+     uint16_t v = r.next();
+
+     int16_t s[50];                      // DSP kernels get plain ints:
+     block.unpack(first, 50, s, 512);    // s[i] = sample(first + i) - 512,
+                                         // index wraps at N (ring buffers)
+
+   check() writes and reads back all 1024 values and prints the cycles per
+   sample of set/get, Writer/Reader and unpack():
+
+     Packed10<16>::check(Serial);        // # packed10 ok set=.. get=.. ...
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+template<uint16_t N>
+class Packed10 {
+  static_assert(N % 4 == 0, "N must be a multiple of 4");
+
+ public:
+  static const uint16_t BYTES = N / 4 * 5;
+
+  uint16_t get(uint16_t i) const {
+    const uint8_t *g = group(i);
+    uint8_t k = i & 3;
+    return g[k] | (uint16_t)((g[4] >> (2 * k)) & 3) << 8;
+  }
+
+  void set(uint16_t i, uint16_t v) {
+    uint8_t *g = group(i);
+    uint8_t k = i & 3;
+    g[k] = (uint8_t)v;
+    uint8_t shift = 2 * k;
+    g[4] = (g[4] & ~(3 << shift)) | ((v >> 8) & 3) << shift;
+  }
+
+  // Samples first, first + 1, ... (index modulo N) minus offset, as plain ints
+  void unpack(uint16_t first, uint16_t count, int16_t *out, int16_t offset) const {
+    Reader r(*this, first % N);
+    while (count--) *out++ = (int16_t)r.next() - offset;
+  }
+
+  // Sequential access: one group pointer, no index math per sample
+  class Reader {
+   public:
+    Reader(const Packed10 &p, uint16_t first)
+      : base_(p.b_), g_(p.group(first)), k_(first & 3) {}
+    uint16_t next() {
+      uint16_t v = g_[k_] | (uint16_t)((g_[4] >> (2 * k_)) & 3) << 8;
+      if (++k_ == 4) {
+        k_ = 0;
+        g_ += 5;
+        if (g_ == base_ + BYTES) g_ = base_;   // wrap
+      }
+      return v;
+    }
+   private:
+    const uint8_t *base_, *g_;
+    uint8_t k_;
+  };
+
+  class Writer {
+   public:
+    Writer(Packed10 &p, uint16_t first = 0)
+      : base_(p.b_), g_(p.group(first)), k_(first & 3) {}
+    void put(uint16_t v) {
+      g_[k_] = (uint8_t)v;
+      uint8_t shift = 2 * k_;
+      g_[4] = (g_[4] & ~(3 << shift)) | ((v >> 8) & 3) << shift;
+      if (++k_ == 4) {
+        k_ = 0;
+        g_ += 5;
+        if (g_ == base_ + BYTES) g_ = base_;
+      }
+    }
+   private:
+    uint8_t *base_, *g_;
+    uint8_t k_;
+  };
+
+  // Round trip of every 10-bit value plus cycles per sample; false on a mismatch
+  static bool check(Print &out) {
+    Packed10 p;
+    int16_t s[N];
+    uint32_t us[4] = { 0, 0, 0, 0 };
+    bool ok = true;
+    for (uint16_t base = 0; base < 1024; base += N) {
+      unsigned long t = micros();
+      for (uint16_t i = 0; i < N; i++) p.set(i, base + i);
+      us[0] += micros() - t;
+      t = micros();
+      for (uint16_t i = 0; i < N; i++) ok &= p.get(i) == base + i;
+      us[1] += micros() - t;
+
+      uint16_t rev = 1023 - base;                  // every value once more, other order
+      t = micros();
+      Writer w(p);
+      for (uint16_t i = 0; i < N; i++) w.put(rev - i);
+      us[2] += micros() - t;
+      t = micros();
+      p.unpack(0, N, s, 0);
+      us[3] += micros() - t;
+      for (uint16_t i = 0; i < N; i++) ok &= s[i] == (int16_t)(rev - i);
+    }
+    static const char NAMES[4][7] PROGMEM = { "set", "get", "put", "unpack" };
+    out.print(ok ? F("# packed10 ok") : F("# packed10 MISMATCH"));
+    for (uint8_t k = 0; k < 4; k++) {
+      char name[7];
+      strcpy_P(name, NAMES[k]);
+      out.print(' ');
+      out.print(name);
+      out.print('=');
+      out.print(us[k] * (F_CPU / 1000000UL) / 1024.0f, 1);   // cycles per sample
+    }
+    out.println();
+    return ok;
+  }
+
+ private:
+  const uint8_t *group(uint16_t i) const { return b_ + (i >> 2) * 5; }
+  uint8_t *group(uint16_t i) { return b_ + (i >> 2) * 5; }
+
+  uint8_t b_[BYTES];
+};
@@ -0,0 +1,81 @@
+/* QuietSampler.h - ADC Noise Reduction sleep sampling that still hears Serial
+
+   In ADC Noise Reduction sleep the CPU and the I/O clock stop while a
+   sample converts: less digital noise in the result, but the USART is
+   clocked by the I/O clock too, so a byte arriving then is garbled or
+   lost. quietWindow() samples one window like this:
+
+     - Idle sleep until the Timer1 trigger of the next sample;
+     - then ADC Noise Reduction sleep, which starts the conversion; the
+       ADC interrupt wakes the CPU with the result;
+     - a pin change interrupt on RX (PD0) also wakes it, within a few
+       cycles of a start bit, and from then on the next QUIET_RX_HOLD
+       samples are converted awake (Idle sleep, I/O clock running, Timer1
+       auto-triggering the ADC at the normal period), so the rest of the
+       line comes in with the clock on.
+
+   The sketch passes its hardware in as a small struct (tests/QuietSamplerTest.cpp
+   passes a model of it instead, with a UART on the side, and counts the
+   bytes lost with and without the RX wake):
+
+     bool done()               window complete
+     uint16_t sinceTrigger()   Timer1 ticks since the last trigger (TCNT1)
+     void idleUntilTrigger()   Idle sleep until the next trigger
+     void convertAsleep()      ADC Noise Reduction sleep until the result is read; if
+                               the RX flag is already set, start the conversion
+                               awake instead (ADSC) and wait for it
+     void convertAwake()       Idle sleep until the ADC (auto-triggered) result is read
+     void nrTiming(bool nr)    Timer1 period for sleeping (shortened by one conversion,
+                               Timer1 stops with the I/O clock) or awake conversions;
+                               restarts the period
+     bool rxSeen()             RX pin changed or bytes wait in the buffer (clears the flag)
+
+     quietWindow(hw, quietStats, ACQ_NR_TOP + 1, ACQ_TIMER_TOP + 1, ACQ_CONV_TICKS);
+
+   The first sample after a switch between the two timings comes up to one
+   period late. Duty cycle in Timer1 ticks goes to QuietStats.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+const uint16_t QUIET_RX_HOLD = 100;   // samples converted awake after RX activity (20 ms at 5 kHz)
+
+struct QuietStats {
+  uint32_t awakeTicks;    // CPU running
+  uint32_t idleTicks;     // Idle sleep, waiting for the next trigger (or an awake conversion)
+  uint32_t sleepTicks;    // ADC Noise Reduction sleep (converting)
+  uint16_t rxSamples;     // samples converted awake because of serial input
+  uint16_t rxHold;        // awake samples still to go
+};
+
+template<class Hw>
+void quietWindow(Hw &hw, QuietStats &st, uint16_t nrPeriod, uint16_t period, uint16_t convTicks) {
+  bool nr = st.rxHold == 0;
+  hw.nrTiming(nr);
+  while (!hw.done()) {
+    if (hw.rxSeen()) st.rxHold = QUIET_RX_HOLD;
+    if (nr != (st.rxHold == 0)) {
+      nr = !nr;
+      hw.nrTiming(nr);
+    }
+
+    uint16_t tAwake = hw.sinceTrigger();
+    if (!nr) tAwake = tAwake > convTicks ? tAwake - convTicks : 0;   // Idle through an awake conversion
+    hw.idleUntilTrigger();
+    st.awakeTicks += tAwake;
+    st.idleTicks += (nr ? nrPeriod : period) - tAwake;
+
+    if (nr) {
+      hw.convertAsleep();
+      st.sleepTicks += convTicks;
+    } else {
+      hw.convertAwake();
+      st.rxSamples++;
+      st.rxHold--;
+    }
+  }
+}
@@ -0,0 +1,74 @@
+/* RamMonitor.h - free RAM and stack high-water mark for the Uno sketches
+
+   The ATmega328P has 2048 bytes of SRAM, shared like this (low to high):
+
+     .data (globals with a value, RAM string literals) | .bss (other globals)
+     | heap (malloc: SSD1306 framebuffer, String) -> free <- stack
+
+   When heap and stack meet the board resets or acts strangely. Before
+   main() runs, ramPaint() fills everything above .bss with RAM_PAINT. The
+   stack overwrites the pattern as it grows, so the painted bytes still left
+   just above the heap are the least free RAM the sketch has ever had:
+
+     ramReport(Serial);   // [RAM] data=.. bss=.. heap=.. stack_peak=.. free=.. min_free=..
+
+   Which globals use the RAM, and string literals left in .data (wrap
+   them in F()) - run on the .elf from a verbose compile:
+
+     python3 tools/ram_report.py sketch.ino.elf
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+const uint8_t RAM_PAINT = 0xA5;
+
+extern char __data_start, __data_end, __bss_start, __bss_end;
+extern char __heap_start, *__brkval;
+extern char __stack;          // last RAM byte (RAMEND)
+
+// Runs from .init3, after the stack pointer is set and before globals are
+// initialised: naked, so it has no prologue and does not use the stack
+void ramPaint() __attribute__((naked, used, section(".init3")));
+void ramPaint() {
+  for (char *p = &__heap_start; p <= &__stack; p++) *p = RAM_PAINT;
+}
+
+// First byte above the heap
+inline char *ramHeapEnd() {
+  return __brkval ? __brkval : &__heap_start;
+}
+
+// Bytes between the heap and the stack right now
+inline int ramFree() {
+  char top;
+  return &top - ramHeapEnd();
+}
+
+// Least free RAM since reset: paint bytes the stack never reached
+inline int ramMinFree() {
+  const char *p = ramHeapEnd();
+  int n = 0;
+  while (p + n < &__stack && p[n] == (char)RAM_PAINT) n++;
+  return n;
+}
+
+// One line with the whole RAM budget, in bytes
+inline void ramReport(Print &out) {
+  int minFree = ramMinFree();
+  out.print(F("[RAM] data="));
+  out.print((int)(&__data_end - &__data_start));
+  out.print(F(" bss="));
+  out.print((int)(&__bss_end - &__bss_start));
+  out.print(F(" heap="));
+  out.print((int)(ramHeapEnd() - &__heap_start));
+  out.print(F(" stack_peak="));
+  out.print((int)(&__stack - ramHeapEnd()) + 1 - minFree);
+  out.print(F(" free="));
+  out.print(ramFree());
+  out.print(F(" min_free="));
+  out.println(minFree);
+}
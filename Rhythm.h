@@ -0,0 +1,63 @@
+/* Rhythm.h - clap rhythm as a second factor, independent of tempo
+
+   A rhythm is the list of clap onset times in microseconds.
+   rhythmNormalise() turns it into the intervals between the claps as per
+   mille of the whole rhythm, so the same rhythm clapped faster or slower
+   gives (almost) the same numbers. rhythmMatches() accepts an attempt when
+   it has the same number of claps and the interval errors stay within
+   tolerances that are relative to the average interval, so a rhythm with
+   many short intervals is held to the same standard as one with few long
+   ones:
+
+     uint16_t ioi[RHYTHM_MAX - 1];
+     rhythmNormalise(onsetUs, n, ioi);
+     if (rhythmMatches(enrolled, n, ioi)) openLock();
+
+   Integer code only, no hardware: tests/RhythmTest.cpp runs it on a PC
+   and prints the false-accept and false-reject rates of the tolerances.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+const uint8_t RHYTHM_MAX = 16;            // claps per rhythm
+const uint8_t RHYTHM_MIN = 3;             // enrolled rhythms need 2+ intervals
+const uint16_t RHYTHM_SUM_TOL = 220;      // sum of |interval errors|, per mille of length
+const uint16_t RHYTHM_WORST_TOL = 500;    // worst interval error, per mille of the average interval
+
+// Enrolled rhythm: intervals normalised to the whole rhythm length (sum ~1000)
+struct RhythmRecord {
+  uint8_t magic;
+  uint8_t claps;
+  uint16_t ioi[RHYTHM_MAX - 1];
+};
+
+// Inter-onset intervals as per mille of the whole rhythm, so tempo drops out.
+// Timestamps are scaled to 16 us units to keep the products in 32 bits.
+inline void rhythmNormalise(const volatile unsigned long *onsetUs, uint8_t n, uint16_t *ioi) {
+  if (n < 2) return;
+  unsigned long total = (onsetUs[n - 1] - onsetUs[0]) >> 4;
+  if (total == 0) total = 1;
+  for (uint8_t i = 0; i < n - 1; i++) {
+    unsigned long d = (onsetUs[i + 1] - onsetUs[i]) >> 4;
+    ioi[i] = (uint16_t)((d * 1000UL + total / 2) / total);
+  }
+}
+
+// Same clap count, then total and worst interval error within tolerance.
+// The average interval is 1000 / (n - 1) per mille, so the worst-interval
+// test is worst * (n - 1) <= RHYTHM_WORST_TOL. At most 15 intervals:
+// bounded time, no extra RAM.
+inline bool rhythmMatches(const RhythmRecord &enrolled, uint8_t n, const uint16_t *ioi) {
+  if (n != enrolled.claps || n < 2) return false;
+  uint16_t sum = 0, worst = 0;
+  for (uint8_t i = 0; i < n - 1; i++) {
+    uint16_t d = ioi[i] > enrolled.ioi[i] ? ioi[i] - enrolled.ioi[i] : enrolled.ioi[i] - ioi[i];
+    sum += d;
+    if (d > worst) worst = d;
+  }
+  return sum <= RHYTHM_SUM_TOL && (uint32_t)worst * (n - 1) <= RHYTHM_WORST_TOL;
+}
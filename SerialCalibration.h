@@ -0,0 +1,113 @@
+/* SerialCalibration.h - serial line input and calibration that never stop the meter
+
+   LineReader collects a command line one byte at a time into a fixed
+   buffer, so loop() hands it whatever Serial has and goes on metering:
+
+     LineReader<16> serialLine;
+     while (Serial.available()) {
+       uint8_t r = serialLine.feed(Serial.read());
+       if (r == LINE_TOO_LONG) Serial.println(F("[ERR] Line too long."));
+       if (r == LINE_READY) handleLine(serialLine.buf);
+     }
+
+   A line ends at '\n' or '\r' (so "\r\n" is one line), leading and
+   trailing spaces are dropped, empty lines are ignored.
+
+   Calibration is a small state machine fed from the same loop():
+   start() -> CAL_MEASURE, where feed() averages the mean squares of the
+   next chunks; once enough samples are in, feed() returns true and the
+   state is CAL_WAIT_SPL until the phone SPL line comes in. route() says
+   what a line means meanwhile: the answer, "skip", a command that would
+   take the meter away (waterfall, benchmark) and so has to wait, or a
+   normal command.
+
+   tests/SerialCalibrationTest.cpp types into a pseudo-serial line on a
+   PC and checks that the meter keeps updating through a 30 s prompt.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+enum LineResult { LINE_NONE, LINE_READY, LINE_TOO_LONG };
+
+template<uint8_t MAX>
+struct LineReader {
+  char buf[MAX + 1];
+  uint8_t len;
+  bool overflow;
+
+  // One received byte; LINE_READY when buf holds a complete, non-empty line
+  uint8_t feed(char ch) {
+    if (ch == '\n' || ch == '\r') {
+      bool tooLong = overflow;
+      while (len > 0 && buf[len - 1] == ' ') len--;
+      buf[len] = '\0';
+      bool empty = (len == 0);
+      len = 0;
+      overflow = false;
+      if (tooLong) return LINE_TOO_LONG;
+      return empty ? LINE_NONE : LINE_READY;
+    }
+    if (len == 0 && ch == ' ') return LINE_NONE;
+    if (len < MAX) buf[len++] = ch;
+    else overflow = true;
+    return LINE_NONE;
+  }
+};
+
+enum CalState { CAL_IDLE, CAL_MEASURE, CAL_WAIT_SPL };
+
+// What a complete line means in the current state
+enum CalRoute { CAL_ROUTE_COMMAND, CAL_ROUTE_ANSWER, CAL_ROUTE_CANCEL, CAL_ROUTE_BUSY };
+
+// Single-letter commands that stop the meter loop while they run
+const char CAL_BUSY_COMMANDS[] PROGMEM = "wbk";
+
+struct Calibration {
+  uint8_t state;
+  uint32_t target;     // samples to average
+  uint32_t samples;
+  uint64_t acc;        // sum of mean square x samples
+  uint8_t ranges;      // bit per input range seen while measuring
+
+  void start(uint32_t n) {
+    state = CAL_MEASURE;
+    target = n;
+    samples = 0;
+    acc = 0;
+    ranges = 0;
+  }
+
+  // A chunk of n samples with mean square msQ8 on input range; true when
+  // the measurement is complete (state is then CAL_WAIT_SPL)
+  bool feed(uint32_t msQ8, uint16_t n, uint8_t range) {
+    if (state != CAL_MEASURE) return false;
+    acc += (uint64_t)msQ8 * n;
+    samples += n;
+    ranges |= 1 << range;
+    if (samples < target) return false;
+    state = CAL_WAIT_SPL;
+    return true;
+  }
+
+  uint32_t meanQ8() const { return samples ? (uint32_t)(acc / samples) : 0; }
+
+  uint8_t route(const char *line) const {
+    if (state == CAL_WAIT_SPL) return CAL_ROUTE_ANSWER;
+    if (state == CAL_MEASURE) {
+      if (!strcasecmp_P(line, PSTR("skip"))) return CAL_ROUTE_CANCEL;
+      if (line[1] == '\0' && line[0] && strchr_P(CAL_BUSY_COMMANDS, tolower(line[0]))) return CAL_ROUTE_BUSY;
+    }
+    return CAL_ROUTE_COMMAND;
+  }
+};
+
+// Phone SPL from the answer line; false unless the whole line is a number
+inline bool calParseSpl(const char *line, float *spl) {
+  char *end;
+  *spl = strtod(line, &end);
+  return end != line && *end == '\0';
+}
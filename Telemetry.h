@@ -0,0 +1,170 @@
+/* Telemetry.h - serial log lines that never make loop() wait
+
+   Serial.print() blocks whenever the 64-byte transmit buffer is full: at
+   115200 baud every extra byte costs ~87 us of waiting, at 9600 ~1 ms, and
+   a measurement window running meanwhile gets stretched. Telemetry keeps
+   the log as fixed-size integer records in a small RAM ring instead.
+   pump() turns them into text a token at a time with integer-only code and
+   hands Serial just as many bytes as fit in its transmit buffer
+   (availableForWrite()); the UART interrupt sends them from there.
+
+   When the ring is full a push() is dropped and counted; the next line
+   then ends with " drop=N".
+
+   Values are fixed-point integers; a PROGMEM table gives each a name and
+   the number of decimals:
+
+     const TelemetryField LOG_FIELDS[] PROGMEM = { {"vrms", 3}, {"dbfs", 2} };
+     Telemetry<2, 4> tlm(LOG_FIELDS);       // 2 values, ring of 4 (holds 3 records)
+     int32_t v[2] = { 123, -3012 };
+     tlm.push(millis(), state, v);          // t=12.345 vrms=0.123 dbfs=-30.12 st=1
+     tlm.pump(Serial);                      // every loop pass
+
+   TELEMETRY_NONE prints as "-" (value not available). Pass a PROGMEM
+   array of names (char[N][SIZE]) to print the state as a word.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+const int32_t TELEMETRY_NONE = INT32_MIN;
+
+struct TelemetryField {
+  char name[7];
+  uint8_t decimals;
+};
+
+// u with dec decimals ("4294967.295"), returns the end of the text
+inline char *telemetryUnsigned(char *p, uint32_t u, uint8_t dec) {
+  char digits[11];
+  uint8_t n = 0;
+  do {
+    digits[n++] = '0' + u % 10;
+    u /= 10;
+  } while (u || n <= dec);   // at least one digit before the point
+  while (n) {
+    *p++ = digits[--n];
+    if (n == dec && n) *p++ = '.';
+  }
+  *p = '\0';
+  return p;
+}
+
+// v with dec decimals ("-30.12"), returns the end of the text
+inline char *telemetryFixed(char *p, int32_t v, uint8_t dec) {
+  if (v == TELEMETRY_NONE) {
+    *p++ = '-';
+    *p = '\0';
+    return p;
+  }
+  if (v < 0) *p++ = '-';
+  return telemetryUnsigned(p, v < 0 ? -(uint32_t)v : (uint32_t)v, dec);
+}
+
+template<uint8_t FIELDS, uint8_t RING>
+class Telemetry {
+  static_assert((RING & (RING - 1)) == 0 && RING >= 2, "RING must be a power of two");
+
+ public:
+  Telemetry(const TelemetryField *fields, const char *stateNames = nullptr, uint8_t nameSize = 0)
+    : fields_(fields), names_(stateNames), nameSize_(nameSize),
+      head_(0), tail_(0), token_(0), pos_(0), len_(0), dropped_(0), lost_(0) {}
+
+  // Queue one record; false (and counted) if the ring is full
+  bool push(uint32_t ms, uint8_t state, const int32_t *values) {
+    uint8_t next = (head_ + 1) & (RING - 1);
+    if (next == tail_) {
+      dropped_++;
+      lost_++;
+      return false;
+    }
+    Record &r = ring_[head_];
+    r.ms = ms;
+    r.state = state;
+    for (uint8_t i = 0; i < FIELDS; i++) r.v[i] = values[i];
+    head_ = next;
+    return true;
+  }
+
+  // Send what fits in the transmit buffer right now, never waits
+  void pump(Print &out) {
+    for (;;) {
+      if (pos_ == len_ && !nextToken()) return;
+      int room = out.availableForWrite();
+      if (room <= 0) return;
+      uint8_t n = len_ - pos_;
+      if (n > room) n = room;
+      out.write((const uint8_t *)tok_ + pos_, n);
+      pos_ += n;
+    }
+  }
+
+  // Records dropped since reset
+  uint16_t lost() const { return lost_; }
+
+ private:
+  struct Record {
+    uint32_t ms;
+    int32_t v[FIELDS];
+    uint8_t state;
+  };
+
+  // Token order per record: time, each value, state, drop count, newline
+  bool nextToken() {
+    if (tail_ == head_) return false;
+    const Record &r = ring_[tail_];
+    char *p = tok_;
+    if (token_ == 0) {
+      *p++ = 't';
+      *p++ = '=';
+      p = telemetryUnsigned(p, r.ms, 3);   // millis() runs past INT32_MAX after 24.8 days
+    } else if (token_ <= FIELDS) {
+      const TelemetryField *f = &fields_[token_ - 1];
+      *p++ = ' ';
+      strcpy_P(p, f->name);
+      p += strlen(p);
+      *p++ = '=';
+      p = telemetryFixed(p, r.v[token_ - 1], pgm_read_byte(&f->decimals));
+    } else if (token_ == FIELDS + 1) {
+      strcpy_P(p, PSTR(" st="));
+      p += 4;
+      if (names_) {
+        strncpy_P(p, names_ + r.state * nameSize_, nameSize_);
+        p[nameSize_] = '\0';
+        p += strlen(p);
+      } else {
+        p = telemetryFixed(p, r.state, 0);
+      }
+    } else if (token_ == FIELDS + 2) {
+      if (dropped_) {
+        strcpy_P(p, PSTR(" drop="));
+        p = telemetryFixed(p + 6, dropped_, 0);
+        dropped_ = 0;
+      }
+    } else {
+      *p++ = '\r';
+      *p++ = '\n';
+    }
+    len_ = p - tok_;
+    pos_ = 0;
+    if (++token_ > FIELDS + 3) {
+      token_ = 0;
+      tail_ = (tail_ + 1) & (RING - 1);   // record fully formatted, free its slot
+    }
+    return true;
+  }
+
+  const TelemetryField *fields_;
+  const char *names_;
+  uint8_t nameSize_;
+  Record ring_[RING];
+  uint8_t head_, tail_;
+  uint8_t token_;            // next token of the record at tail_
+  uint8_t pos_, len_;        // bytes of tok_ already sent / formatted
+  char tok_[24];             // " smooth=-2147483.648" fits
+  uint16_t dropped_;         // since the last " drop=" report
+  uint16_t lost_;
+};
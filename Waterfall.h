@@ -0,0 +1,146 @@
+/* Waterfall.h - spectrogram rows for a 128x64 SSD1306, scrolled by the panel itself
+
+   WfSpectrum::block() takes one block of WF_N 8-bit samples, runs a Hann
+   window and a 32-point integer FFT in place and adds the power of bins
+   1..16 to the running sums. WfScroll::add() turns the sums into one new
+   row of the picture: 16 bins x 8 px across (low pitch on the left),
+   intensity 0..16 = log2 of the mean power above WF_FLOOR_LOG2, shown as
+   a 1-bit ordered dither.
+
+   There is no framebuffer: the panel scrolls. The SSD1306 shows its RAM
+   starting at the "display start line", so the new row goes into the RAM
+   line just above the one shown at the top (the oldest, at the bottom
+   until then) and the start line moves up to it. The whole picture moves
+   down one pixel with a single command, the newest row on top. A row only
+   needs the 128-byte page holding it sent again; the page buffer is
+   cleared when a new page starts, so the bottom 0..7 rows of the oldest
+   page are blank (57..64 rows of history).
+
+     WfSpectrum spectrum;
+     WfScroll scroll;
+     spectrum.block(samples);                         // every finished block
+     uint8_t page = scroll.add(spectrum, display.buffer());   // every row
+     display.sendPageBuffer(page);
+     display.startLine(scroll.line);
+
+   tests/WaterfallTest.cpp replays a WAV file on a PC, writes every screen
+   as a PBM image and reports the row rate.
+
+   Copy this file next to the sketch that includes it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+const uint8_t WF_N = 32;                // samples per block = FFT size (6.4 ms at 5 kHz)
+const uint8_t WF_BINS = WF_N / 2;       // bins 1..16 drawn, 156 Hz each at 5 kHz
+const uint8_t WF_FLOOR_LOG2 = 4;        // power below 2^4 is black, 2^20 and up is white
+const uint8_t WF_LINES = 64;            // panel RAM lines
+const uint8_t WF_BIN_PX = 128 / WF_BINS;
+
+// Q15 cos(2*pi*k/32); sin(k) is cos(|8 - k|)
+const int16_t WF_COS[WF_BINS] PROGMEM = {
+  32767, 32137, 30273, 27245, 23170, 18204, 12539, 6393,
+  0, -6393, -12539, -18204, -23170, -27245, -30273, -32137
+};
+// Hann window, 0..255
+const uint8_t WF_WINDOW[WF_N] PROGMEM = {
+  0, 3, 10, 23, 40, 60, 83, 108, 134, 159, 184, 206, 224, 239, 249, 254,
+  254, 249, 239, 224, 206, 184, 159, 134, 108, 83, 60, 40, 23, 10, 3, 0
+};
+// 4x4 ordered dither thresholds for the 17 intensity levels
+const uint8_t WF_BAYER[16] PROGMEM = { 0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5 };
+
+struct WfSpectrum {
+  uint32_t power[WF_BINS];     // power sums since the last row
+  uint8_t blocks;
+
+  // Hann window + 32-point radix-2 FFT (integer, in place), power of bins
+  // 1..16 added to power. Every stage halves, so int16 never overflows.
+  void block(const uint8_t *s) {
+    int16_t re[WF_N], im[WF_N];
+
+    uint16_t sum = 0;
+    for (uint8_t i = 0; i < WF_N; i++) sum += s[i];
+    int16_t mean = sum / WF_N;
+
+    // load in bit-reversed order (5 bits)
+    for (uint8_t i = 0; i < WF_N; i++) {
+      uint8_t r = ((i & 1) << 4) | ((i & 2) << 2) | (i & 4) | ((i & 8) >> 2) | ((i & 16) >> 4);
+      re[r] = ((int16_t)(s[i] - mean) * pgm_read_byte(&WF_WINDOW[i])) >> 3;
+      im[r] = 0;
+    }
+
+    for (uint8_t size = 2; size <= WF_N; size <<= 1) {
+      uint8_t half = size / 2;
+      uint8_t step = WF_N / size;
+      for (uint8_t k = 0; k < half; k++) {
+        uint8_t t = k * step;
+        int16_t wr = pgm_read_word(&WF_COS[t]);
+        int16_t wi = pgm_read_word(&WF_COS[t < 8 ? 8 - t : t - 8]);   // sin
+        for (uint8_t i = k; i < WF_N; i += size) {
+          uint8_t j = i + half;
+          int16_t tr = ((int32_t)wr * re[j] + (int32_t)wi * im[j]) >> 15;
+          int16_t ti = ((int32_t)wr * im[j] - (int32_t)wi * re[j]) >> 15;
+          re[j] = (re[i] - tr) >> 1;
+          im[j] = (im[i] - ti) >> 1;
+          re[i] = (re[i] + tr) >> 1;
+          im[i] = (im[i] + ti) >> 1;
+        }
+      }
+    }
+
+    for (uint8_t b = 0; b < WF_BINS; b++) {
+      int16_t r = re[b + 1], m = im[b + 1];
+      power[b] += (uint32_t)((int32_t)r * r) + (uint32_t)((int32_t)m * m);
+    }
+    blocks++;
+  }
+
+  // Intensity 0..16 of bin b
+  uint8_t level(uint8_t b) const {
+    uint32_t p = power[b] / (blocks ? blocks : 1);
+    uint8_t lv = 0;
+    while (p > 1) { p >>= 1; lv++; }
+    lv = lv > WF_FLOOR_LOG2 ? lv - WF_FLOOR_LOG2 : 0;
+    return lv > 16 ? 16 : lv;
+  }
+
+  void clear() {
+    memset(power, 0, sizeof(power));
+    blocks = 0;
+  }
+};
+
+struct WfScroll {
+  uint8_t line;      // display start line = RAM line of the newest row
+  uint16_t rows;     // rows added since reset()
+
+  void reset() {
+    line = 0;
+    rows = 0;
+  }
+
+  // The spectrum (then cleared) as the new top row. page is the 128-byte
+  // buffer of the panel page holding it (kept between calls); returns that
+  // page number. Send the page, then make line the start line.
+  uint8_t add(WfSpectrum &sp, uint8_t *page) {
+    line = (line + WF_LINES - 1) % WF_LINES;
+    uint8_t bit = 1 << (line & 7);
+    if (bit == 0x80) memset(page, 0, 128);   // first row of a new page
+
+    const uint8_t *bayer = &WF_BAYER[(rows & 3) * 4];
+    for (uint8_t b = 0; b < WF_BINS; b++) {
+      uint8_t lv = sp.level(b);
+      uint8_t *p = page + b * WF_BIN_PX;
+      for (uint8_t x = 0; x < WF_BIN_PX; x++) {
+        if (lv > pgm_read_byte(&bayer[x & 3])) p[x] |= bit;
+        else p[x] &= ~bit;
+      }
+    }
+    sp.clear();
+    rows++;
+    return line >> 3;
+  }
+};
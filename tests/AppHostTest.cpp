@@ -0,0 +1,191 @@
+/* AppHostTest.cpp - AppHost.h: starting and stopping apps, the shared arena, leaks
+
+     g++ -std=c++11 -I tests -I . tests/AppHostTest.cpp -o apphost && ./apphost
+
+   Made-up apps of the sizes of P3's (Lock 24 bytes, Target 12 + 8 in two
+   blocks, Noise 6, Level 126) and three bad ones: Leaky takes 4 more
+   bytes in every loop(), Greedy takes another size (8..64) in every
+   setup(), Big asks for more than the arena. Each app checks in setup() that its blocks
+   are zeroed, inside the arena and not on top of each other, then fills
+   them, so a block handed out twice would show.
+
+   Checked: 20000 random starts (also of apps that do not exist), stops
+   and loop() passes against a model: active(), used(), setupUsed(),
+   peak() and the teardown() calls. alloc() gives nullptr past the end of
+   the arena and takes nothing then; exactly the arena fits. P3's switch
+   test (every app started and stopped 10 times) passes with the good apps
+   and finds Leaky and Greedy, which move neither heap nor stack.
+*/
+
+#include <Arduino.h>
+#include "AppHost.h"
+
+const uint16_t ARENA = 160;          // as in P3
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+extern AppHost<ARENA> host;
+
+uint32_t setups[8], teardowns[8], nulls = 0;
+bool dirty = false, outside = false;
+
+// A zeroed block inside the arena, then filled
+uint8_t *take(uint16_t n) {
+  static uint8_t *low = nullptr, *high = nullptr;   // arena bounds seen so far
+  uint8_t *p = (uint8_t *)host.alloc(n);
+  if (!p) {
+    nulls++;
+    return p;
+  }
+  for (uint16_t i = 0; i < n; i++) dirty |= p[i] != 0;
+  memset(p, 0xA5, n);
+  if (!low || p < low) low = p;
+  if (!high || p + n > high) high = p + n;
+  outside |= high - low > ARENA;
+  return p;
+}
+
+void lockSetup() { setups[0]++; take(24); }
+void lockTeardown() { teardowns[0]++; }
+void targetSetup() {
+  setups[1]++;
+  uint8_t *a = take(12), *b = take(8);
+  outside |= b != a + 12;
+}
+void noiseSetup() { setups[2]++; take(6); }
+void levelSetup() { setups[3]++; take(126); }
+void leakySetup() { setups[4]++; take(10); }
+void leakyLoop(char) { take(4); }
+void greedySetup() { take(8 + 8 * (++setups[5] % 8)); }
+void bigSetup() {
+  setups[6]++;
+  uint16_t before = nulls;
+  expect("more than the arena: nullptr", !take(ARENA + 1) && host.used() == 0);
+  expect("the whole arena fits", take(ARENA) != nullptr && host.used() == ARENA);
+  expect("then not a byte more", !take(1) && host.used() == ARENA);
+  nulls = before;
+}
+void idleLoop(char) {}
+void bigTeardown() { teardowns[6]++; }
+
+const App APPS[] PROGMEM = {
+  { "Lock",   lockSetup,   idleLoop,  lockTeardown },
+  { "Target", targetSetup, idleLoop,  nullptr },
+  { "Noise",  noiseSetup,  idleLoop,  nullptr },
+  { "Level",  levelSetup,  idleLoop,  nullptr },
+  { "Leaky",  leakySetup,  leakyLoop, nullptr },
+  { "Greedy", greedySetup, idleLoop,  nullptr },
+  { "Big",    bigSetup,    idleLoop,  bigTeardown },
+};
+const uint8_t APP_COUNT = sizeof(APPS) / sizeof(APPS[0]);
+const uint16_t SETUP_BYTES[] = { 24, 20, 6, 126, 10, 0, ARENA };   // Greedy: 8..64, see greedySetup()
+AppHost<ARENA> host(APPS, APP_COUNT);
+
+// P3's switch test over the apps first..last: arena taken after setup()
+// and setup()s that take more than in round 0 make it fail
+bool switchTest(uint8_t first, uint8_t last, uint16_t *grew) {
+  uint16_t setupUsed[APP_COUNT];
+  bool pass = true;
+  *grew = 0;
+  for (uint8_t round = 0; round < 10; round++) {
+    for (uint8_t i = first; i <= last; i++) {
+      host.start(i);
+      if (round == 0) setupUsed[i] = host.setupUsed();
+      for (uint8_t n = 0; n < 3; n++) host.loop(0);
+      *grew += host.used() - host.setupUsed();
+      pass &= host.setupUsed() == setupUsed[i];
+      host.stop();
+      pass &= host.used() == 0;
+    }
+  }
+  return pass && *grew == 0;
+}
+
+int main() {
+  char name[10];
+  host.name(1, name);
+  expect("name from the table", !strcmp(name, "Target") && host.count() == APP_COUNT);
+  expect("no app at first", host.active() == host.NONE && host.used() == 0 && host.peak() == 0);
+  host.stop();
+  host.loop('1');
+  expect("stop and loop without an app do nothing", host.active() == host.NONE);
+
+  // random use against a model
+  uint8_t active = host.NONE;
+  uint16_t used = 0, setupUsed = 0, peak = 0;
+  uint32_t tears[8] = { 0 }, starts = 0, passes = 0, bad = 0;
+  for (uint32_t k = 0; k < 20000; k++) {
+    uint32_t op = next() % 10;
+    if (op < 3) {
+      uint8_t i = next() % (APP_COUNT + 2);    // two that do not exist
+      if (active != host.NONE && (active == 0 || active == 6)) tears[active]++;
+      host.start(i);
+      active = i < APP_COUNT ? i : host.NONE;
+      used = setupUsed = active == host.NONE ? 0 : active == 5 ? 8 + 8 * (setups[5] % 8) : SETUP_BYTES[active];
+      if (used > peak) peak = used;
+      starts += active != host.NONE;
+    } else if (op < 4) {
+      if (active != host.NONE && (active == 0 || active == 6)) tears[active]++;
+      host.stop();
+      active = host.NONE;
+      used = setupUsed = 0;
+    } else {
+      host.loop(0);
+      if (active == 4 && used + 4 <= ARENA) used += 4;
+      if (used > peak) peak = used;
+      passes++;
+    }
+    bad += host.active() != active || host.used() != used || host.setupUsed() != setupUsed || host.peak() != peak;
+  }
+  printf("random: %u starts, %u loop passes, %u wrong; peak %u of %u, %u allocs refused\n",
+         starts, passes, bad, host.peak(), host.size(), nulls);
+  expect("active, used, setupUsed and peak as the model", bad == 0);
+  expect("teardown once per stop of its app", teardowns[0] == tears[0] && teardowns[6] == tears[6]);
+  expect("blocks zeroed every start", !dirty);
+  expect("blocks in the arena, one after the other", !outside);
+  expect("the whole arena was used", host.peak() == ARENA);
+  host.stop();
+
+  // Leaky runs until the arena is full
+  nulls = 0;
+  host.start(4);
+  uint16_t n = 0;
+  while (!nulls && n < 1000) {
+    host.loop(0);
+    n++;
+  }
+  printf("Leaky: arena full after %u passes, used %u of %u\n", n, host.used(), host.size());
+  expect("leak stops at the end of the arena", n == (ARENA - 10) / 4 + 1 && host.used() == 10 + (ARENA - 10) / 4 * 4);
+  host.stop();
+  expect("stop gives it all back", host.used() == 0 && host.setupUsed() == 0);
+
+  // the switch test
+  uint16_t grew;
+  bool good = switchTest(0, 3, &grew);
+  printf("switch test, P3's apps: %s, arena +%u\n", good ? "ok" : "LEAK", grew);
+  expect("switch test passes with the good apps", good && !dirty);
+  bool leaky = switchTest(0, 4, &grew);
+  printf("switch test with Leaky: %s, arena +%u\n", leaky ? "ok" : "LEAK", grew);
+  expect("finds arena taken in loop()", !leaky && grew == 10 * 3 * 4);
+  bool greedy = switchTest(5, 5, &grew);
+  printf("switch test with Greedy: %s, arena +%u\n", greedy ? "ok" : "LEAK", grew);
+  expect("finds setup() taking more each start", !greedy && grew == 0);
+
+  printf(ok ? "apphost ok\n" : "apphost FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+/* Arduino.h - just enough of the Arduino core to run the header-only
+   helpers of the sketches on a PC:
+
+     g++ -std=c++11 -I tests -I . tests/RhythmTest.cpp -o rhythm && ./rhythm
+
+   PROGMEM is ordinary RAM here, Print collects into a string and micros()
+   counts up by 1 per call. A test can set the clock (hostClock()) and
+   hook hostWait(): delay() calls it with the time it waits until, so the
+   test can run its "interrupts" meanwhile. write() takes its bytes out of
+   room, like a transmit buffer filling up; the print() calls ignore room.
+   Numbers print in decimal only. Serial is a Print too. tests/run.sh
+   builds and runs every test.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
+#include <string>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strcasecmp_P strcasecmp
+#define strchr_P strchr
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+
+#define LOW 0
+#define HIGH 1
+#define E2END 1023                   // last EEPROM address of the ATmega328P
+
+// Status and MCU status registers; interrupts are never on by themselves
+inline uint8_t &hostRegister(uint8_t i) {
+  static uint8_t r[2];
+  return r[i];
+}
+#define SREG hostRegister(0)
+#define MCUSR hostRegister(1)
+inline void cli() {}
+inline void sei() {}
+
+inline unsigned long &hostClock() {
+  static unsigned long t = 0;
+  return t;
+}
+
+typedef void (*HostWait)(unsigned long untilUs);
+inline HostWait &hostWait() {
+  static HostWait w = nullptr;
+  return w;
+}
+
+inline unsigned long micros() {
+  return ++hostClock();
+}
+
+inline unsigned long millis() {
+  return micros() / 1000UL;
+}
+
+inline void delay(unsigned long ms) {
+  unsigned long until = hostClock() + ms * 1000UL;
+  if (hostWait()) hostWait()(until);
+  if ((long)(until - hostClock()) > 0) hostClock() = until;
+}
+
+// Output goes to text; room is what availableForWrite() reports
+class Print {
+ public:
+  std::string text;
+  int room = 64;
+
+  int availableForWrite() { return room; }
+  size_t write(const uint8_t *p, size_t n) {
+    text.append((const char *)p, n);
+    room -= n;
+    return n;
+  }
+  size_t print(const __FlashStringHelper *s) { return print((const char *)s); }
+  size_t print(const char *s) {
+    text += s;
+    return strlen(s);
+  }
+  size_t print(char c) {
+    text += c;
+    return 1;
+  }
+  size_t print(double v, int digits) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    return print(buf);
+  }
+  size_t print(long v) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%ld", v);
+    return print(buf);
+  }
+  size_t print(unsigned long v) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%lu", v);
+    return print(buf);
+  }
+  size_t print(int v) { return print((long)v); }
+  size_t print(unsigned v) { return print((unsigned long)v); }
+  size_t print(unsigned char v) { return print((unsigned long)v); }
+  size_t println() { return print("\r\n"); }
+  template<class T> size_t println(T v) { return print(v) + println(); }
+  void flush() {}
+};
+
+static Print Serial;
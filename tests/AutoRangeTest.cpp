@@ -0,0 +1,302 @@
+/* AutoRangeTest.cpp - Decibel Meter auto range: the level runs on across A0 <-> A1 switches
+
+     g++ -std=c++11 -I tests -I . tests/AutoRangeTest.cpp -o autorange && ./autorange
+
+   The auto range of P2.1.3 as its ADC ISR, acqTake(), acqMeanSquare(),
+   rangeStep(), rangeSet() and rangeSetTrim() do it: 5000 samples/s in
+   20 ms chunks, sums centred on acqDc (kept per input), samples dropped
+   while the reference settles (acqSkip), A1 mean squares scaled to A0
+   counts by rangeScaleQ16, up to A0 at once when the A1 peak reaches
+   RANGE_UP_PEAK, down to A1 after RANGE_HOLD_SAMPLES of A0 peaks under
+   RANGE_DOWN_PEAK. dB and the Fast level come from LevelMath.h.
+
+   The mic, made up here: a 440 Hz tone plus 0.3 mV RMS of noise, on the
+   module's 2.5 V bias into A0 and AC-coupled onto 0.543 V into A1; each
+   conversion adds 0.3 counts RMS of ADC noise. After a switch the AREF pin
+   moves exponentially to the new reference: 4 ms time constant going
+   down to 1.1 V, 0.2 ms going up to 5 V (guesses for the Uno's 100 nF,
+   not measured). The tone:
+
+     0 .. 3 s    15 mV peak (the meter goes down to A1 after 0.5 s)
+     3 .. 13 s   up 40 dB to 1.5 V peak (back to A0 on the way)
+     13 .. 15 s  1.5 V peak
+     15 .. 25 s  down to 15 mV (A1 again 0.5 s after it is quiet enough)
+     25 .. 28 s  15 mV peak
+
+   Per chunk the reading is compared with the tone's true mean square
+   over the same samples. Checked: three switches, no clipped A1 sample,
+   chunk readings within 0.3 dB and the Fast level within 0.2 dB of the
+   truth on both inputs, and no jump of the error across a switch larger
+   than 0.15 dB (chunk) / 0.1 dB (Fast). Dropping only the conversion
+   that was running (no settle time) must show up as a larger jump. A
+   chip whose 1.1 V reference is really 1.0 V (the datasheet allows
+   1.0..1.2 V) jumps by about 0.8 dB until the A1 trim from a
+   calibration on A1 takes it out again. A tone that swings +-3 dB
+   around the switch levels (after 2 s of quiet on A1) must go up to A0
+   once and stay there.
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include "LevelMath.h"
+
+typedef MeterScale<6, 30, 120, 116, 70> Scale;   // as in the Decibel Meter
+const uint32_t SAMPLE_RATE = 5000;
+typedef DecayTable<SAMPLE_RATE, 125> FastDecay;
+const uint16_t LEVEL_CHUNK_SAMPLES = SAMPLE_RATE / 50;
+const float VREF_VOLTS = 5.0f;
+const float VREF_LOW_VOLTS = 1.1f;
+enum AdcRange { RANGE_HIGH, RANGE_LOW };
+const uint16_t RANGE_UP_PEAK = 480;
+const uint16_t RANGE_DOWN_PEAK = 80;
+const uint16_t RANGE_HOLD_SAMPLES = SAMPLE_RATE / 2;
+const uint16_t RANGE_SETTLE_LOW = SAMPLE_RATE / 40;
+const uint16_t RANGE_SETTLE_HIGH = SAMPLE_RATE / 500;
+
+const double TONE_HZ = 440, MIC_NOISE = 0.0003, ADC_NOISE = 0.3;
+const double BIAS_A0 = 2.5, BIAS_A1 = 5.0 * 10 / 92;    // 82k / 10k divider
+const double TAU_DOWN = 0.004, TAU_UP = 0.0002;         // AREF settling, s
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+double gauss() {
+  double s = 0;
+  for (int i = 0; i < 12; i++) s += (next() % 100000) / 100000.0;
+  return s - 6;
+}
+
+// The sketch's sampling and auto range state, as in its functions
+struct Meter {
+  int16_t acqDc = 512;
+  uint16_t acqCount = 0, acqPeak = 0, acqSkip = 0, acqChunkPeak = 0;
+  int32_t acqSum = 0;
+  uint32_t acqSumSq = 0;
+  uint8_t adcRange = RANGE_HIGH;
+  int16_t rangeDc[2] = { 512, 512 };
+  uint16_t rangeQuiet = 0, rangeSwitches = 0;
+  uint32_t rangeScaleQ16 = 0;
+  uint16_t settleLow = RANGE_SETTLE_LOW;   // RANGE_SETTLE_LOW, changeable here
+
+  // ISR(ADC_vect); true when the sample went into the sums
+  bool isr(uint16_t raw) {
+    if (acqSkip) {
+      acqSkip--;
+      return false;
+    }
+    int16_t c = (int16_t)raw - acqDc;
+    uint16_t mag = c < 0 ? -c : c;
+    if (mag > acqPeak) acqPeak = mag;
+    acqSum += c;
+    acqSumSq += (uint32_t)((int32_t)c * c);
+    acqCount++;
+    return true;
+  }
+
+  // acqTake() and acqMeanSquare()
+  bool take(uint32_t *msQ8, uint16_t *n) {
+    if (acqCount < LEVEL_CHUNK_SAMPLES) return false;
+    uint16_t samples = acqCount;
+    int32_t sum = acqSum;
+    uint32_t sumSquares = acqSumSq;
+    acqCount = 0;
+    acqSum = 0;
+    acqSumSq = 0;
+    acqChunkPeak = acqPeak;
+    acqPeak = 0;
+    *n = samples;
+    uint32_t rawQ8 = ((sumSquares / samples) << 8) + ((sumSquares % samples) << 8) / samples;
+    int32_t meanQ8 = (sum * 256L) / samples;
+    uint32_t dcQ8 = (uint32_t)(((int64_t)meanQ8 * meanQ8) >> 8);
+    acqDc += (int16_t)((meanQ8 + (meanQ8 < 0 ? -128 : 128)) / 256);
+    uint32_t ms = rawQ8 > dcQ8 ? rawQ8 - dcQ8 : 0;
+    if (adcRange == RANGE_LOW) ms = ((uint64_t)ms * rangeScaleQ16 + 0x8000) >> 16;
+    *msQ8 = ms;
+    return true;
+  }
+
+  void rangeSet(uint8_t range) {
+    if (range == adcRange) return;
+    rangeDc[adcRange] = acqDc;
+    adcRange = range;
+    acqDc = rangeDc[range];
+    acqSkip = range == RANGE_LOW ? settleLow : RANGE_SETTLE_HIGH;
+    acqCount = 0;
+    acqSum = 0;
+    acqSumSq = 0;
+    acqPeak = 0;
+    rangeQuiet = 0;
+    rangeSwitches++;
+  }
+
+  void rangeStep(uint16_t peak, uint16_t n) {
+    if (adcRange == RANGE_LOW) {
+      if (peak >= RANGE_UP_PEAK) rangeSet(RANGE_HIGH);
+    } else if (peak < RANGE_DOWN_PEAK) {
+      rangeQuiet += n;
+      if (rangeQuiet >= RANGE_HOLD_SAMPLES) rangeSet(RANGE_LOW);
+    } else {
+      rangeQuiet = 0;
+    }
+  }
+
+  void rangeSetTrim(int16_t trimCdb) {
+    float ratio = VREF_LOW_VOLTS / VREF_VOLTS;
+    rangeScaleQ16 = (uint32_t)(ratio * ratio * pow(10.0, trimCdb / 1000.0) * 65536.0 + 0.5);
+  }
+};
+
+double toDb(uint32_t msQ8) {
+  return log10Cdb<Scale>(msQ8) / 100.0;
+}
+
+struct Run {
+  uint16_t switches, clipped;
+  double worstChunk[2], worstFast[2];    // per input, largest |error|, dB
+  double jumpChunk, jumpFast;            // largest change of the error at a switch
+  double meanErr[2];
+};
+
+// Tone peak in volts at time t: a profile, or a swing around the switch levels
+double rampPeak(double t) {
+  const double LO = 0.015, HI = 1.5;
+  if (t < 3) return LO;
+  if (t < 13) return LO * pow(HI / LO, (t - 3) / 10);
+  if (t < 15) return HI;
+  if (t < 25) return HI * pow(LO / HI, (t - 15) / 10);
+  return LO;
+}
+double swingPeak(double t) {
+  if (t < 2) return 0.015;                                   // on A1 first
+  return 0.45 * pow(10.0, 0.15 * sin(2 * M_PI * 1.5 * t));   // +-3 dB around 0.45 V at 1.5 Hz
+}
+
+Run run(double (*peak)(double), double seconds, double vrefLowReal, int16_t trimCdb,
+        uint16_t settleLow = RANGE_SETTLE_LOW) {
+  Meter m;
+  m.rangeSetTrim(trimCdb);
+  m.settleLow = settleLow;
+  Run r = {};
+  uint32_t fastQ8 = 0;
+  double fastTrue = 0, lastErr = 0, lastFastErr = 0;
+  double trueSum = 0, trueSumSq = 0;     // the tone in A0 counts, the chunk's samples
+  uint32_t sinceSwitch = 0;
+  uint8_t lastRange = m.adcRange;
+  bool primed = false, have = false;
+  uint32_t total = (uint32_t)(seconds * SAMPLE_RATE);
+  uint32_t onRange[2] = { 0, 0 };
+  double errSum[2] = { 0, 0 };
+  for (uint32_t k = 0; k < total; k++) {
+    double t = (double)k / SAMPLE_RATE;
+    double s = peak(t) * sin(2 * M_PI * TONE_HZ * t) + MIC_NOISE * gauss();
+    double vref, v;
+    double dt = (double)sinceSwitch / SAMPLE_RATE;
+    if (m.adcRange == RANGE_LOW) {
+      vref = vrefLowReal + (VREF_VOLTS - vrefLowReal) * (m.rangeSwitches ? exp(-dt / TAU_DOWN) : 0);
+      v = BIAS_A1 + s;
+    } else {
+      vref = VREF_VOLTS - (VREF_VOLTS - vrefLowReal) * (m.rangeSwitches > 1 ? exp(-dt / TAU_UP) : 0);
+      v = BIAS_A0 + s;
+    }
+    long raw = lround(v * 1024 / vref + ADC_NOISE * gauss());
+    if (raw <= 0 || raw >= 1023) {
+      raw = raw <= 0 ? 0 : 1023;
+      if (m.adcRange == RANGE_LOW) r.clipped++;
+    }
+    sinceSwitch++;
+    if (m.isr(raw)) {
+      double c = s * 1024 / VREF_VOLTS;
+      trueSum += c;
+      trueSumSq += c * c;
+    }
+
+    uint32_t msQ8;
+    uint16_t n;
+    uint8_t range = m.adcRange;
+    if (!m.take(&msQ8, &n)) continue;
+    double trueMs = trueSumSq / n - (trueSum / n) * (trueSum / n);
+    trueSum = trueSumSq = 0;
+    m.rangeStep(m.acqChunkPeak, n);
+    if (m.adcRange != range) sinceSwitch = 0;
+
+    // Fast as levelsUpdate() does it, and the same integrator on the truth
+    if (!primed) {
+      fastQ8 = msQ8;
+      fastTrue = trueMs;
+      primed = true;
+    }
+    fastQ8 = levelStep(fastQ8, msQ8, decayFactor(FastDecay::data, n));
+    fastTrue = trueMs + (fastTrue - trueMs) * exp(-(double)n / (0.125 * SAMPLE_RATE));
+
+    if (t < 1.0) continue;              // A0 before the first switch down
+    double err = toDb(msQ8) - 10 * log10(256 * trueMs);
+    double fastErr = toDb(fastQ8) - 10 * log10(256 * fastTrue);
+    if (fabs(err) > r.worstChunk[range]) r.worstChunk[range] = fabs(err);
+    if (fabs(fastErr) > r.worstFast[range]) r.worstFast[range] = fabs(fastErr);
+    onRange[range]++;
+    errSum[range] += err;
+    if (have && range != lastRange) {
+      if (fabs(err - lastErr) > r.jumpChunk) r.jumpChunk = fabs(err - lastErr);
+      if (fabs(fastErr - lastFastErr) > r.jumpFast) r.jumpFast = fabs(fastErr - lastFastErr);
+    }
+    lastErr = err;
+    lastFastErr = fastErr;
+    lastRange = range;
+    have = true;
+  }
+  for (uint8_t i = 0; i < 2; i++) r.meanErr[i] = onRange[i] ? errSum[i] / onRange[i] : 0;
+  r.switches = m.rangeSwitches;
+  return r;
+}
+
+void show(const char *name, const Run &r) {
+  printf("%-28s %2u switches, chunk error A0 %.2f / A1 %.2f dB, Fast %.2f / %.2f dB, jump at a switch %.2f dB (Fast %.3f)\n",
+         name, r.switches, r.worstChunk[RANGE_HIGH], r.worstChunk[RANGE_LOW], r.worstFast[RANGE_HIGH],
+         r.worstFast[RANGE_LOW], r.jumpChunk, r.jumpFast);
+}
+
+int main() {
+  Run r = run(rampPeak, 28, 1.1, 0);
+  show("ramp", r);
+  expect("down, up, down", r.switches == 3);
+  expect("A1 never clipped", r.clipped == 0);
+  expect("chunk readings within 0.3 dB", r.worstChunk[0] < 0.3 && r.worstChunk[1] < 0.3);
+  expect("Fast within 0.2 dB", r.worstFast[0] < 0.2 && r.worstFast[1] < 0.2);
+  expect("no jump at a switch", r.jumpChunk < 0.15 && r.jumpFast < 0.1);
+
+  // settling: without the dropped samples the first A1 chunk reads low
+  Run early = run(rampPeak, 28, 1.1, 0, 1);
+  show("ramp, 1 sample dropped", early);
+  expect("the settle time matters", early.jumpChunk > 2 * r.jumpChunk);
+
+  // a reference at the bottom of its tolerance, before and after an A1 trim
+  Run off = run(rampPeak, 28, 1.0, 0);
+  show("ramp, 1.1 V ref is 1.0 V", off);
+  expect("the wrong reference shows as a jump", off.jumpChunk > 0.5);
+  // calibration on A1 only: trim = true level - A1 reading (handleLine()'s sum)
+  int16_t trimCdb = (int16_t)lround(-off.meanErr[RANGE_LOW] * 100);
+  Run trimmed = run(rampPeak, 28, 1.0, trimCdb);
+  printf("A1 trim from the calibration: %+.2f dB\n", trimCdb / 100.0);
+  show("ramp, 1.0 V ref, trimmed", trimmed);
+  expect("the trim takes the jump out", trimmed.jumpChunk < 0.15 && trimmed.jumpFast < 0.1);
+
+  Run swing = run(swingPeak, 20, 1.1, 0);
+  show("swing around the switch levels", swing);
+  expect("up once, then no flapping", swing.switches == 2);
+
+  printf(ok ? "autorange ok\n" : "autorange FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+/* CaptureDump.h - the Noise Meter's event captures out of a Serial log (PC only)
+
+     FILE *f = fopen("serial.txt", "r");
+     std::vector<Capture> caps = captureParse(f);    // other lines are skipped
+     caps[0].counts[caps[0].trigger]                  // the trigger sample, ADC counts
+     captureWav("cap1.wav", caps[0]);                 // 16-bit mono, +-512 counts = full scale
+
+   The frame is the one P2.2.1 sends (see the top of the sketch):
+
+     #CAP <n> <why T/B/A> <rate Hz> <samples> <trigger index>
+     #D <hex u-law bytes, oldest first>
+     #END <16-bit sum of all sample bytes>
+
+   A capture is complete when it has the header's number of bytes and
+   they add up to the #END sum; a #CAP before the #END, or a line that is
+   not hex, leaves the one before incomplete.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "Wav.h"
+
+struct Capture {
+  unsigned n, rate, samples, trigger;
+  char why;
+  std::vector<uint8_t> bytes;
+  std::vector<int> counts;       // decoded, oldest first
+  bool complete;
+};
+
+// G.711 u-law byte -> ADC counts (the sketch encodes counts x 16)
+inline int muDecode(uint8_t b) {
+  uint8_t u = ~b;
+  uint8_t e = (u >> 4) & 7, m = u & 15;
+  int v = ((((16 + m) << (e + 1)) + (1 << e)) - 33) / 16;
+  return (u & 0x80) ? -v : v;
+}
+
+inline int captureHex(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+inline std::vector<Capture> captureParse(FILE *f) {
+  std::vector<Capture> out;
+  bool open = false;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (!strncmp(line, "#CAP ", 5)) {
+      Capture c = {};
+      if (sscanf(line + 5, "%u %c %u %u %u", &c.n, &c.why, &c.rate, &c.samples, &c.trigger) != 5) {
+        open = false;
+        continue;
+      }
+      out.push_back(c);
+      open = true;
+    } else if (open && !strncmp(line, "#D ", 3)) {
+      Capture &c = out.back();
+      for (const char *p = line + 3; *p; p += 2) {
+        int hi = captureHex(p[0]), lo = p[1] ? captureHex(p[1]) : -1;
+        if (hi < 0 || lo < 0) {
+          open = false;
+          break;
+        }
+        c.bytes.push_back(hi << 4 | lo);
+      }
+    } else if (open && !strncmp(line, "#END ", 5)) {
+      Capture &c = out.back();
+      unsigned sum = 0;
+      for (uint8_t b : c.bytes) sum += b;
+      c.complete = c.bytes.size() == c.samples && (sum & 0xFFFF) == strtoul(line + 5, NULL, 10) && c.trigger < c.samples;
+      for (uint8_t b : c.bytes) c.counts.push_back(muDecode(b));
+      open = false;
+    }
+  }
+  return out;
+}
+
+inline bool captureWav(const char *path, const Capture &c) {
+  std::vector<double> s;
+  for (int v : c.counts) s.push_back(v / 512.0);
+  return wavWrite(path, c.rate, s);
+}
@@ -0,0 +1,224 @@
+/* CaptureDumpTest.cpp - Noise Meter event capture: dump, decode to WAV, trigger alignment
+
+     g++ -std=c++11 -I tests -I . tests/CaptureDumpTest.cpp -o capdump && ./capdump
+
+   The capture of P2.2.1 as its ADC ISR and capDumpStep() do it: the DC
+   follower, pairs of 6250 Hz samples averaged to 3125 Hz, G.711 u-law
+   into a 512-sample ring, a trigger at 300 counts from the bias or from
+   loop() (capTrigger), 128 samples more, then frozen until the #CAP / #D /
+   #END lines are out. The lines go into a log with CSV lines in between,
+   as on the Serial Monitor; CaptureDump.h (which tools/CaptureToWav.cpp
+   uses) reads them back. The mic, made up here:
+
+     0.0 s  room noise (3 counts RMS) and mains hum
+     1.0 s  a knock: jumps to 450 counts and rings down   -> 'T' capture
+     2.0 s  loop() calls capTrigger('B') on quiet sound   -> 'B' capture
+     3.0 s  another knock, and one #D line of its dump is lost
+
+   Checked: the two first captures are complete, 512 samples at 3125 Hz,
+   each decoded sample within a u-law step of what the ISR encoded, the
+   trigger 128 samples before the end (index 383), and the trigger sample
+   of the knock 0..3 ADC samples after its real start, counted back from
+   the end of the capture; the 'B' trigger is the pair that the next
+   sample after the call completes.
+   The WAV file of the knock read back (Wav.h) has the same samples and
+   the knock at the trigger index. The third capture reads as incomplete.
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include <string>
+#include "CaptureDump.h"
+
+const double RATE = 6250;                  // SAMPLE_RATE
+const uint8_t DC_SHIFT = 8;
+const uint16_t CAP_SAMPLES = 512;
+const uint16_t CAP_POST = 128;
+const int16_t CAP_TRIG_COUNTS = 300;
+const uint8_t CAP_LINE = 24;
+enum CapState { CAP_WARMING, CAP_ARMED, CAP_POST_TRIG, CAP_FROZEN };
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+double gauss() {
+  double s = 0;
+  for (int i = 0; i < 12; i++) s += (next() % 100000) / 100000.0;
+  return s - 6;
+}
+
+// as in the sketch
+uint8_t muEncode(int16_t c) {
+  uint8_t sign = 0;
+  if (c < 0) { c = -c; sign = 0x80; }
+  uint16_t v = c > 509 ? 8191 : (c << 4) + 33;
+  uint8_t seg = 0;
+  for (uint16_t t = v >> 6; t; t >>= 1) seg++;
+  return ~(sign | (seg << 4) | ((v >> (seg + 1)) & 0x0F));
+}
+
+struct Meter {
+  int32_t dcQ8 = 512L << DC_SHIFT;
+  uint8_t cap[CAP_SAMPLES];
+  int16_t plain[CAP_SAMPLES];     // the same samples before u-law (test only)
+  uint16_t capHead = 0, capCount = 0, capTrigAt = 0, capDumps = 0;
+  uint8_t capState = CAP_WARMING;
+  char capWhy = 0, capSoftTrig = 0;
+  int16_t capPair = 0;
+  bool capOdd = false;
+  uint32_t n = 0, lastAt = 0;      // ADC sample number, and that of the last capture sample
+
+  void isr(int16_t raw) {
+    n++;
+    dcQ8 += raw - (dcQ8 >> DC_SHIFT);
+    int16_t d = raw - (int16_t)(dcQ8 >> DC_SHIFT);
+    d = d < -512 ? -512 : d > 511 ? 511 : d;   // constrain()
+    if (capState == CAP_FROZEN) return;
+    capOdd = !capOdd;
+    if (capOdd) {
+      capPair = d;
+      return;
+    }
+    int16_t c = (capPair + d) >> 1;
+    cap[capHead] = muEncode(c);
+    plain[capHead] = c;
+    if (capState == CAP_WARMING) {
+      if (++capCount >= CAP_SAMPLES - CAP_POST) capState = CAP_ARMED;
+    } else if (capState == CAP_ARMED) {
+      if (capSoftTrig || c >= CAP_TRIG_COUNTS || c <= -CAP_TRIG_COUNTS) {
+        capWhy = capSoftTrig ? capSoftTrig : 'T';
+        capSoftTrig = 0;
+        capTrigAt = capHead;
+        capCount = 0;
+        capState = CAP_POST_TRIG;
+      }
+    } else if (++capCount >= CAP_POST) {
+      capState = CAP_FROZEN;
+      lastAt = n - 1;
+    }
+    if (++capHead == CAP_SAMPLES) capHead = 0;
+  }
+
+  void capTrigger(char why) {
+    if (capState == CAP_ARMED) capSoftTrig = why;
+  }
+
+  // capDumpStep() until the capture is out, a CSV line after each line
+  void dump(std::string &log, int dropLine) {
+    char buf[80];
+    snprintf(buf, sizeof(buf), "#CAP %u %c 3125 %u %u\n", ++capDumps, capWhy, CAP_SAMPLES,
+             (capTrigAt + CAP_SAMPLES - capHead) % CAP_SAMPLES);
+    log += buf;
+    uint16_t sum = 0;
+    uint16_t lines = (CAP_SAMPLES + CAP_LINE - 1) / CAP_LINE;
+    for (uint16_t l = 0; l < lines; l++) {
+      char *p = buf;
+      p += sprintf(p, "#D ");
+      for (uint8_t i = 0; i < CAP_LINE; i++) {
+        uint16_t k = l * CAP_LINE + i;
+        if (k >= CAP_SAMPLES) break;
+        uint8_t b = cap[(capHead + k) % CAP_SAMPLES];
+        sum += b;
+        p += sprintf(p, "%02X", b);
+      }
+      if (l != dropLine) log += std::string(buf) + "\n";
+      log += "812,3,40,1,5,0,0\n";
+    }
+    snprintf(buf, sizeof(buf), "#END %u\n", sum);
+    log += buf;
+    capCount = 0;
+    capState = CAP_WARMING;
+  }
+};
+
+int main() {
+  Meter m;
+  std::string log;
+  const uint32_t KNOCK[2] = { (uint32_t)(1.0 * RATE) + 3, (uint32_t)(3.0 * RATE) + 4 };
+  const uint32_t SOFT = (uint32_t)(2.0 * RATE) + 1;
+  uint8_t dumps = 0;
+  for (uint32_t n = 0; n < 4 * RATE; n++) {
+    double v = 3 * gauss() + 4 * sin(2 * M_PI * 50 * n / RATE);
+    for (uint32_t k : KNOCK) {
+      if (n >= k) v += 450 * exp(-(double)(n - k) / (0.01 * RATE)) * cos(2 * M_PI * 300 * (n - k) / RATE);
+    }
+    if (n == SOFT) {
+      m.capTrigger('B');
+    }
+    long raw = lround(512.3 + v);
+    m.isr(raw < 0 ? 0 : raw > 1023 ? 1023 : raw);
+    if (m.capState == CAP_FROZEN) {
+      uint32_t end = m.lastAt;
+      int16_t plain[CAP_SAMPLES];
+      for (uint16_t k = 0; k < CAP_SAMPLES; k++) plain[k] = m.plain[(m.capHead + k) % CAP_SAMPLES];
+      m.dump(log, dumps == 2 ? 5 : -1);
+      dumps++;
+
+      // check this dump as soon as it is out
+      FILE *f = tmpfile();
+      fputs(log.c_str(), f);
+      rewind(f);
+      std::vector<Capture> caps = captureParse(f);
+      fclose(f);
+      expect("one capture per dump", caps.size() == dumps);
+      const Capture &c = caps.back();
+      if (dumps == 3) {
+        expect("a lost line is found", !c.complete);
+        printf("capture %u %c: one #D line lost -> incomplete\n", c.n, c.why);
+        continue;
+      }
+      expect("capture complete", c.complete && c.samples == CAP_SAMPLES && c.rate == 3125);
+      if (!c.complete) continue;
+      int worst = 0;
+      for (uint16_t k = 0; k < CAP_SAMPLES; k++) {
+        int err = abs(c.counts[k] - plain[k]) - abs(plain[k]) / 16;
+        if (err > worst) worst = err;
+      }
+      expect("decoded within a u-law step", worst <= 1);
+      expect("trigger 128 samples before the end", c.trigger == CAP_SAMPLES - CAP_POST - 1);
+      uint32_t trigAdc = end - 2 * (CAP_SAMPLES - 1 - c.trigger);   // second sample of the pair
+      if (c.why == 'T') {
+        int32_t late = (int32_t)trigAdc - (int32_t)KNOCK[0];
+        printf("capture %u T: trigger at %u = %d counts, %d ADC samples after the knock started\n",
+               c.n, c.trigger, c.counts[c.trigger], late);
+        expect("knock at the trigger sample", late >= 0 && late <= 3);
+        bool before = true;
+        for (uint16_t k = 0; k < c.trigger; k++) before &= abs(c.counts[k]) < CAP_TRIG_COUNTS - 20;
+        expect("nothing over the trigger level before it", before);
+
+        const char *tmp = getenv("TMPDIR");
+        std::string path = std::string(tmp ? tmp : "/tmp") + "/capture_test.wav";
+        expect("WAV written", captureWav(path.c_str(), c));
+        std::vector<double> w = wavRead(path.c_str(), c.rate);
+        bool same = w.size() == c.counts.size();
+        for (size_t k = 0; same && k < w.size(); k++) same = lround(w[k] * 512) == c.counts[k];
+        expect("WAV holds the decoded samples", same);
+        size_t first = 0;
+        while (first < w.size() && fabs(w[first]) * 512 < CAP_TRIG_COUNTS) first++;
+        expect("knock at the trigger index in the WAV", first == c.trigger);
+      } else {
+        int32_t after = (int32_t)trigAdc - (int32_t)SOFT;
+        printf("capture %u %c: trigger at %u, %d ADC samples after capTrigger()\n", c.n, c.why, c.trigger, after);
+        expect("'B' capture", c.why == 'B');
+        expect("soft trigger at the pair of the next sample", after >= 0 && after <= 1);
+      }
+    }
+  }
+  expect("three captures", dumps == 3);
+
+  printf(ok ? "capdump ok\n" : "capdump FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+/* ClapCounterTest.cpp - every clap of a fast clapper is scored by ClapCounter.h
+
+     g++ -std=c++11 -I tests -I . tests/ClapCounterTest.cpp -o claps && ./claps
+
+   A 10 s Clap Sprint game is clapped at 15, 20 and 24 claps/s, with a
+   few ms of timing scatter per clap. Like the LM393 output, every clap
+   rings: 1..4 extra rising edges within 8 ms of the first one. The edge
+   times go to ClapCounter::edge() the way INT0 hands them over, starting
+   close to the wrap of micros() once.
+
+   Each game must score exactly the claps clapped (the starting clap does
+   not score), report a peak rate within one clap of the clapping rate,
+   and file every gap but the first into the right histogram bucket.
+*/
+
+#include <Arduino.h>
+#include <vector>
+#include "ClapCounter.h"
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// One game: the starting clap at start, then claps at rate for 10 s
+void game(unsigned long start, uint8_t rate, uint16_t scatterUs) {
+  ClapCounter claps = {};
+  std::vector<unsigned long> onsets;
+  unsigned long period = 1000000UL / rate;
+  for (unsigned long t = 0; t < 10000000UL; t += period) {
+    long jitter = (long)(next() % (2 * scatterUs + 1)) - scatterUs;
+    onsets.push_back(start + t + jitter + (t ? 0 : scatterUs));
+  }
+
+  uint32_t edges = 0;
+  for (size_t i = 0; i < onsets.size(); i++) {
+    claps.edge(onsets[i]);
+    edges++;
+    uint8_t ring = 1 + next() % 4;
+    for (uint8_t k = 0; k < ring; k++) {
+      claps.edge(onsets[i] + 300 + next() % 7700);
+      edges++;
+    }
+    if (i == 0) claps.reset();   // loop() starts the game on the first clap
+  }
+
+  uint16_t want[IOI_BUCKETS] = {};
+  for (size_t i = 2; i < onsets.size(); i++) {
+    unsigned long gapMs = (onsets[i] - onsets[i - 1]) / 1000UL;
+    uint8_t b = 0;
+    while (b < IOI_BUCKETS - 1 && gapMs >= IOI_EDGES_MS[b]) b++;
+    want[b]++;
+  }
+  bool histOk = true;
+  for (uint8_t b = 0; b < IOI_BUCKETS; b++) histOk &= claps.ioiHist[b] == want[b];
+
+  unsigned long scored = onsets.size() - 1;
+  printf("%2u claps/s from %10lu: %3lu edges, %3lu claps, scored %3lu, peak %2u/s\n",
+         rate, start, (unsigned long)edges, scored, (unsigned long)claps.count, claps.peakPerSec);
+  expect("every clap scored", claps.count == scored);
+  expect("peak rate", claps.peakPerSec + 1 >= rate && claps.peakPerSec <= rate + 1);
+  expect("interval histogram", histOk);
+}
+
+int main() {
+  game(5000000UL, 15, 10000);
+  game(5000000UL, 20, 4000);
+  game(5000000UL, 24, 600);     // gaps stay above CLAP_REFRACTORY_US
+  game(0xFFFFFFFFUL - 4000000UL, 20, 4000);   // micros() wraps during the game
+
+  printf(ok ? "claps ok\n" : "claps FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+/* ClapDuelTest.cpp - Clap Duel edge timing, ties and false starts through ClapDuel.h
+
+     g++ -std=c++11 -I tests -I . tests/ClapDuelTest.cpp -o duel && ./duel
+
+   The two sensor edges of a round are given as times in Timer1 ticks
+   (0.5 us) and handed to DuelRound::edge() the way the AVR would: an
+   edge sets its INTx flag, the ISR starts ENTRY ticks after the flag (or
+   after the ISR still running), reads the timer first, looks at the
+   other flag CHECK ticks later and returns BODY ticks after it started.
+   INT0 goes first when both flags are up. Each clap rings: 0..3 more
+   edges within 5 ms.
+
+   Cases: clear wins either way, claps 1 tick .. 40 us apart, the same
+   instant, one player or nobody, a false start seen by the wait loop, an
+   edge stamped after the wait loop last looked but before the cue, and
+   a round across the 32-bit tick wrap; duelTicks() with the overflow
+   flag up. Then 20000 random rounds: the verdict may be a tie only when
+   the second clap came before the first ISR looked at its flag, and is
+   never the wrong player. The first clap's reaction time is exact, the
+   second one's is late by at most one ISR when it had to wait for it.
+*/
+
+#include <Arduino.h>
+#include <vector>
+#include <algorithm>
+#include "ClapDuel.h"
+
+const uint32_t ENTRY = 8;        // 4 us from the flag to reading the timer (attachInterrupt dispatch)
+const uint32_t CHECK = 6;        // then the EIFR read
+const uint32_t BODY = 24;        // 12 us for the whole ISR
+const uint32_t MS = 2000;        // ticks
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+struct Edge {
+  uint32_t at;                   // ticks from the start of the round
+  uint8_t player;
+};
+
+// The edges' ISRs in the order and at the times the AVR runs them.
+// Times are offsets from base, so the round can sit across the wrap.
+void runIsrs(DuelRound &d, std::vector<Edge> edges, uint32_t base) {
+  std::stable_sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) { return a.at < b.at; });
+  std::vector<bool> done(edges.size(), false);
+  uint32_t free = 0;             // the CPU is in an ISR until then
+  for (;;) {
+    // next flag up: the earliest edge not served; INT0 first on a draw
+    int pick = -1;
+    for (size_t i = 0; i < edges.size(); i++) {
+      if (done[i]) continue;
+      if (pick < 0) { pick = i; continue; }
+      uint32_t ready = std::max(edges[i].at, free), best = std::max(edges[pick].at, free);
+      if (ready < best || (ready == best && edges[i].player < edges[pick].player)) pick = i;
+    }
+    if (pick < 0) return;
+    uint8_t p = edges[pick].player;
+    // a flag stays up once: all of this player's edges so far are served by this ISR
+    uint32_t start = std::max(edges[pick].at, free) + ENTRY;
+    for (size_t i = 0; i < edges.size(); i++) {
+      if (!done[i] && edges[i].player == p && edges[i].at <= start) done[i] = true;
+    }
+    bool otherPending = false;
+    for (size_t i = 0; i < edges.size(); i++) {
+      if (!done[i] && edges[i].player != p && edges[i].at <= start + CHECK) otherPending = true;
+    }
+    d.edge(p, base + start, otherPending);
+    free = start - ENTRY + BODY;
+  }
+}
+
+// A clap and its ringing
+void clap(std::vector<Edge> &edges, uint8_t p, uint32_t at) {
+  edges.push_back({ at, p });
+  uint8_t rings = next() % 4;
+  for (uint8_t k = 0; k < rings; k++) edges.push_back({ at + 40 + next() % (5 * MS), p });
+}
+
+const char *name(Outcome o) {
+  return o == P1_WINS ? "P1" : o == P2_WINS ? "P2" : o == TIE ? "tie" : "nobody";
+}
+
+const int64_t NO_CLAP = -1000000000;
+
+// A cued round: claps at a0 / a1 ticks from the cue
+DuelVerdict cued(int64_t a0, int64_t a1, uint32_t base = 1000000) {
+  const uint32_t CUE = 3000 * MS;
+  DuelRound d;
+  d.arm();
+  std::vector<Edge> edges;
+  if (a0 != NO_CLAP) clap(edges, 0, CUE + a0);
+  if (a1 != NO_CLAP) clap(edges, 1, CUE + a1);
+  runIsrs(d, edges, base);
+  d.stop();
+  return d.judge(base + CUE);
+}
+
+int main() {
+  DuelVerdict v = cued(300 * MS, 360 * MS);
+  expect("P1 first", v.outcome == P1_WINS && v.ticks[0] == 300 * MS + ENTRY && v.ticks[1] == 360 * MS + ENTRY);
+  v = cued(250 * MS, 200 * MS);
+  expect("P2 first", v.outcome == P2_WINS && v.ticks[1] == 200 * MS + ENTRY);
+  v = cued(NO_CLAP, 400 * MS);
+  expect("only P2", v.outcome == P2_WINS && v.ticks[0] == 0);
+  v = cued(NO_CLAP, NO_CLAP);
+  expect("nobody", v.outcome == NOBODY && v.falseStart < 0);
+  v = cued(300 * MS, 300 * MS);
+  expect("same instant is a tie", v.outcome == TIE);
+
+  printf("gap (us)   P1 first   P2 first\n");
+  uint32_t tieUpTo = 0;
+  for (uint32_t gap = 1; gap <= 80; gap += gap < 20 ? 1 : 10) {
+    DuelVerdict a = cued(300 * MS, 300 * MS + gap), b = cued(300 * MS + gap, 300 * MS);
+    if (gap % 4 == 0 || gap > 20) printf("%6.1f     %-8s   %-8s\n", gap / 2.0, name(a.outcome), name(b.outcome));
+    expect("never the wrong player", a.outcome != P2_WINS && b.outcome != P1_WINS);
+    if (a.outcome == TIE || b.outcome == TIE) tieUpTo = gap;
+  }
+  printf("ties up to %.1f us apart (ISR entry + flag check %.1f us)\n", tieUpTo / 2.0, (ENTRY + CHECK) / 2.0);
+  expect("ties only within the ISR latency", tieUpTo <= ENTRY + CHECK);
+
+  // false start seen by the wait loop
+  {
+    DuelRound d;
+    d.arm();
+    std::vector<Edge> edges;
+    clap(edges, 1, 1500 * MS);
+    runIsrs(d, edges, 0);
+    expect("P2 false start seen", d.falseStart() == 1);
+    d.arm();
+    edges.clear();
+    clap(edges, 0, 1500 * MS);
+    clap(edges, 1, 1500 * MS + 3);
+    runIsrs(d, edges, 0);
+    expect("both false start", d.falseStart() == 2);
+  }
+  // stamped after the wait loop last looked, a few us before the cue
+  v = cued(-10, 300 * MS);
+  expect("edge just before the cue is a false start", v.falseStart == 0 && v.outcome == P2_WINS);
+  v = cued(-40, -20);
+  expect("both just before the cue", v.falseStart == 2 && v.outcome == NOBODY);
+  v = cued(-20, -12);   // P2's ISR waits for P1's and stamps after the cue
+  expect("same instant, one stamp before the cue", v.falseStart == 2 && v.outcome == NOBODY);
+
+  // the round across the wrap of the 32-bit tick count (every 36 min)
+  v = cued(300 * MS, 301 * MS, 0xFFFFFFFFUL - 3000 * MS - 100 * MS);
+  expect("across the wrap", v.outcome == P1_WINS && v.ticks[0] == 300 * MS + ENTRY);
+
+  expect("duelTicks plain", duelTicks(0x1234, 7, false) == 0x71234UL);
+  expect("duelTicks wrapped, overflow ISR not run", duelTicks(0x0003, 7, true) == 0x80003UL);
+  expect("duelTicks read before the wrap", duelTicks(0xFFFE, 7, true) == 0x7FFFEUL);
+
+  uint32_t rounds = 20000, ties = 0, wrong = 0, badTie = 0, badTime = 0;
+  for (uint32_t k = 0; k < rounds; k++) {
+    int64_t a0 = 200 * MS + next() % (200 * MS), a1 = next() % 3 ? a0 + (int32_t)(next() % 400) - 200 : 200 * MS + next() % (200 * MS);
+    DuelVerdict r = cued(a0, a1, next());
+    Outcome want = a0 < a1 ? P1_WINS : a1 < a0 ? P2_WINS : TIE;
+    if (r.outcome == TIE) {
+      ties++;
+      if (llabs(a0 - a1) > ENTRY + CHECK) badTie++;
+    } else if (r.outcome != want) {
+      wrong++;
+    }
+    // the first ISR stamps exactly, the other one may wait for it
+    bool first0 = a0 <= a1;
+    if (r.ticks[first0 ? 0 : 1] != (first0 ? a0 : a1) + ENTRY) badTime++;
+    int64_t late = first0 ? r.ticks[1] - (a1 + ENTRY) : r.ticks[0] - (a0 + ENTRY);
+    if (late < 0 || late > BODY) badTime++;
+  }
+  printf("%u random rounds: %u ties, %u wrong winner, %u ties of claps more than %.0f us apart, %u wrong times\n",
+         rounds, ties, wrong, badTie, (ENTRY + CHECK) / 2.0, badTime);
+  expect("random rounds", wrong == 0 && badTie == 0 && badTime == 0);
+
+  printf(ok ? "clapduel ok\n" : "clapduel FAIL\n");
+  return ok ? 0 : 1;
+}
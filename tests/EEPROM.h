@@ -0,0 +1,29 @@
+/* EEPROM.h - the Uno's 1 KB EEPROM as a byte array, for host tests
+
+   Starts erased (0xFF) like a new chip; a test can look at or change
+   EEPROM.bytes[] directly, e.g. erase it between runs.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+struct EEPROMClass {
+  uint8_t bytes[E2END + 1];
+
+  EEPROMClass() { memset(bytes, 0xFF, sizeof(bytes)); }
+  uint8_t read(int a) { return bytes[a]; }
+  void write(int a, uint8_t v) { bytes[a] = v; }
+  void update(int a, uint8_t v) { bytes[a] = v; }
+  uint16_t length() { return sizeof(bytes); }
+  template<class T> T &get(int a, T &t) {
+    memcpy((void *)&t, bytes + a, sizeof(T));
+    return t;
+  }
+  template<class T> const T &put(int a, const T &t) {
+    memcpy(bytes + a, (const void *)&t, sizeof(T));
+    return t;
+  }
+};
+
+static EEPROMClass EEPROM;
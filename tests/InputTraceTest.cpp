@@ -0,0 +1,812 @@
+/* InputTraceTest.cpp - InputTrace.h: record and replay thousands of runs of the Target Game and the lock
+
+     g++ -std=c++11 -O2 -I tests -I . tests/InputTraceTest.cpp -o inputtrace && ./inputtrace
+     ./inputtrace target trace.txt    (or lock) replay what a board printed for 'D'
+
+   The sketches' loop() code with InputTrace calls, as in P2.1.1 and P2.3
+   (the OLED as the text printed where, the buzzer and servo left out),
+   runs on a made-up board: a clock, the LM393 (a level the Target Game
+   polls, rising edges that run the lock's INT0 handler at their own
+   microsecond, also during delay()) and a keypad that reports a key once
+   if it is still held at a scan. Passes cost 40..600 us, drawing 23 ms
+   (Target Game) or 30 ms (the lock's pages), so the recorded run has the
+   timing of the board, not that of the replay.
+
+   Each made-up run is booted, sent 'R' (the watchdog reset is an
+   exception here), recorded live, sent 'P' and replayed twice. The Target
+   Game gets 3..35 claps, each 1..4 short D0 pulses; the lock gets PINs
+   right and wrong, '*' and keys during the beep, rhythms enrolled with
+   'A' and clapped (each clap rings 0..3 more edges, sometimes one past
+   the 80 ms refractory time), 'B' and stray claps.
+
+   Checked per run: the two replays print the same bytes, end, and give
+   the recorded run's state lines (#S names and values, up to where the
+   recording stopped) and its screen at that time, as drawn. No event is lost while
+   recording. Runs longer than the EEPROM holds are counted, not
+   compared. Printed: how many runs took which path, and how much faster
+   than the board the replays ran.
+*/
+
+#include <Arduino.h>
+#include <time.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "InputTrace.h"
+#include "Rhythm.h"
+
+const int RUNS = 1000;                         // per sketch
+const uint32_t MS = 1000;                      // us
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+uint32_t between(uint32_t lo, uint32_t hi) {
+  return lo + next() % (hi - lo + 1);
+}
+
+// random() / randomSeed() as the sketches use them (not avr-libc's numbers)
+uint32_t sketchRandom = 1;
+void randomSeed(uint32_t s) {
+  sketchRandom = s ? s : 1;
+}
+long random(long lo, long hi) {
+  sketchRandom = sketchRandom * 1103515245UL + 12345;
+  return lo + (long)((sketchRandom >> 8) % (uint32_t)(hi - lo));
+}
+
+void noInterrupts() {}
+void interrupts() {}
+
+// ---------- The board ----------
+
+struct Press {
+  uint32_t us, holdUs;
+  char key;
+};
+
+struct Inputs {
+  std::vector<uint32_t> flips;   // D0 changes, LOW before the first (the Target Game polls D0)
+  std::vector<uint32_t> edges;   // D0 rising edges on INT0 (the lock)
+  std::vector<Press> keys;
+  uint32_t endUs;
+};
+
+Inputs *live = nullptr;          // the inputs of the run being recorded
+size_t nextEdge = 0, nextKey = 0;
+void (*int0)() = nullptr;        // attachInterrupt()
+
+// hostWait(): the INT0 handler for every edge until then, at its own time
+void runInterrupts(unsigned long until) {
+  while (live && nextEdge < live->edges.size() && live->edges[nextEdge] <= until) {
+    uint32_t t = live->edges[nextEdge++];
+    if (!int0) continue;
+    if ((long)(t - 1 - hostClock()) > 0) hostClock() = t - 1;   // micros() in the handler reads t
+    int0();
+  }
+}
+
+// The CPU busy for a while (a pass, drawing); interrupts come in meanwhile
+void busy(unsigned long us) {
+  unsigned long until = hostClock() + us;
+  runInterrupts(until);
+  if ((long)(until - hostClock()) > 0) hostClock() = until;
+}
+
+uint8_t digitalReadD0() {
+  if (!live) return LOW;
+  size_t n = std::upper_bound(live->flips.begin(), live->flips.end(), (uint32_t)hostClock()) - live->flips.begin();
+  return n & 1 ? HIGH : LOW;
+}
+
+// Keypad::getKey(): a key pressed since the last scan and still held, once
+char getKey() {
+  if (!live) return 0;
+  uint32_t now = hostClock();
+  while (nextKey < live->keys.size() && live->keys[nextKey].us + live->keys[nextKey].holdUs <= now) nextKey++;
+  if (nextKey < live->keys.size() && live->keys[nextKey].us <= now) return live->keys[nextKey++].key;
+  return 0;
+}
+
+// The OLED as text: what is printed where. display() (or the end of a
+// paged draw) puts it on the panel, which takes costUs of I2C.
+struct Screen {
+  struct Item {
+    int x, y;
+    std::string text;
+  };
+  std::vector<Item> items;
+  int x = 0, y = 0, size = 1;
+  unsigned long costUs = 0;
+  std::string shown;
+  InputTrace *clock = nullptr;
+  std::vector<std::pair<uint32_t, uint16_t> > history;   // trace time, CRC of what is shown
+
+  void clearDisplay() { items.clear(); }
+  void setTextSize(int s) { size = s; }
+  void setTextColor(int) {}
+  void setCursor(int cx, int cy) { x = cx; y = cy; }
+  void fillRect(int, int ry, int, int h, int) {
+    items.erase(std::remove_if(items.begin(), items.end(),
+                               [&](const Item &i) { return i.y >= ry && i.y < ry + h; }), items.end());
+  }
+  template<class T> void print(T v) {
+    Print p;
+    p.print(v);
+    items.push_back({ x, y, p.text });
+    x += 6 * size * p.text.size();
+  }
+  template<class T> void println(T v) {
+    print(v);
+    x = 0;
+    y += 8 * size;
+  }
+  void display() {
+    shown.clear();
+    for (const Item &i : items) shown += std::to_string(i.x) + "," + std::to_string(i.y) + ":" + i.text + "\n";
+    history.push_back({ (uint32_t)clock->micros(), crc() });   // when the sketch drew it
+    busy(costUs);
+  }
+  void firstPage() { items.clear(); }
+  bool nextPage() {
+    display();
+    return false;
+  }
+  uint16_t crc() const { return traceCrc((const uint8_t *)shown.data(), shown.size()); }
+};
+
+// ---------- P2.1.1 Target Game ----------
+
+const int SOUND_PIN = 2;
+
+struct TargetGame {
+  static const int TRACE_ADDR = 0;
+  InputTrace trace{ TRACE_ADDR };
+  Screen display;
+  unsigned long clapCount = 0;
+  int lastState = LOW;
+  unsigned long startTime = 0;
+  const unsigned long gameDuration = 5000;
+  bool gameRunning = false;
+  int target = 0;
+  bool over = false;             // replay finished
+
+  void setup(uint32_t seed) {
+    display.clock = &trace;
+    display.costUs = 23 * MS;
+    randomSeed(trace.begin(seed));
+    display.clearDisplay();
+    display.setTextSize(2);
+    display.setCursor(0, 0);
+    display.print(F("!!!START!!!"));
+    display.display();
+    trace.sync();
+    newGame();
+  }
+
+  void loop() {
+    if (trace.poll()) {
+      Serial.print(F("#FRAME "));
+      Serial.println(display.crc());
+      over = true;
+    }
+    busy(between(40, 160));
+    int s = trace.level(0, digitalReadD0());
+    if (!gameRunning) return;
+    if (s == HIGH && lastState == LOW) {
+      clapCount++;
+      updateDisplay();
+      trace.delay(150);
+    }
+    lastState = s;
+    if (trace.millis() - startTime >= gameDuration) {
+      gameRunning = false;
+      showResult();
+      trace.delay(2000);
+      newGame();
+    }
+  }
+
+  void newGame() {
+    target = random(3, 9);
+    clapCount = 0;
+    gameRunning = true;
+    startTime = trace.millis();
+    trace.state(F("target"), target);
+    display.clearDisplay();
+    display.setTextSize(1);
+    display.setCursor(0, 0);
+    display.println(F("Target Game!"));
+    display.setTextSize(2);
+    display.setCursor(0, 20);
+    display.print(F("Target:"));
+    display.setCursor(80, 20);
+    display.print(target);
+    display.setTextSize(1);
+    display.setCursor(0, 50);
+    display.println(F("Clap exactly the number!"));
+    display.display();
+  }
+
+  void updateDisplay() {
+    display.fillRect(0, 40, 128, 20, 0);
+    display.setTextSize(2);
+    display.setCursor(0, 40);
+    display.print(F("You:"));
+    display.setCursor(60, 40);
+    display.print(clapCount);
+    display.display();
+  }
+
+  void showResult() {
+    trace.state(F("claps"), clapCount);
+    display.clearDisplay();
+    display.setTextSize(2);
+    display.setCursor(0, 10);
+    if (clapCount == (unsigned long)target) display.println(F("You Win!"));
+    else if (clapCount < (unsigned long)target) display.println(F("Too few!"));
+    else display.println(F("Too many!"));
+    display.setTextSize(1);
+    display.setCursor(0, 50);
+    display.print(F("Target:"));
+    display.print(target);
+    display.print(F(" You:"));
+    display.print(clapCount);
+    display.display();
+  }
+};
+
+// ---------- P2.3 Digital Lock ----------
+
+const unsigned long CLAP_REFRACTORY_US = 80000UL;
+const unsigned long RHYTHM_END_MS = 1500;
+const unsigned long RHYTHM_WAIT_MS = 8000;
+const int RHYTHM_EEPROM_ADDR = 0;
+const uint8_t RHYTHM_MAGIC = 0xC7;
+const unsigned long STATUS_SHOW_MS = 1200;
+const std::string CORRECT_PIN = "1234";
+enum LockMode { MODE_PIN, MODE_RHYTHM, MODE_ENROLL };
+
+struct Lock;
+Lock *lock = nullptr;
+void lockOnClap();
+
+struct Lock {
+  static const int TRACE_ADDR = RHYTHM_EEPROM_ADDR + sizeof(RhythmRecord);
+  InputTrace trace{ TRACE_ADDR };
+  Screen display;
+  RhythmRecord enrolled;
+  bool rhythmEnrolled = false;
+  volatile unsigned long onsetUs[RHYTHM_MAX];
+  volatile uint8_t onsetCount = 0;
+  volatile unsigned long lastOnsetUs = 0;
+  LockMode mode = MODE_PIN;
+  bool unlocked = false;
+  unsigned long modeStartMs = 0;
+  uint8_t shownClaps = 0;
+  std::string inputBuf;
+  char lastKey = 0;
+  bool over = false;
+
+  void setup(uint32_t) {
+    lock = this;
+    display.clock = &trace;
+    display.costUs = 30 * MS;
+    trace.begin(0);
+    if (trace.replaying()) trace.onEdge(0, lockOnClap);
+    else int0 = lockOnClap;
+    loadRhythm();
+    display.firstPage();
+    do {
+      display.setTextSize(1);
+      display.setCursor(0, 0);
+      display.println(F("Digital Safe"));
+      display.setCursor(0, 12);
+      display.println(F("Enter PIN and press #"));
+    } while (display.nextPage());
+    trace.delay(900);
+    showStatus();
+  }
+
+  void loop() {
+    if (trace.poll()) {
+      Serial.print(F("#FRAME "));
+      Serial.println(display.crc());
+      over = true;
+    }
+    busy(between(150, 600));     // keypad scan
+    char k = trace.key(getKey());
+
+    if (mode != MODE_PIN && k != '*') {
+      handleRhythm();
+      return;
+    }
+    if (!k) return;
+    lastKey = k;
+    Serial.print(F("Key: "));
+    Serial.println(k);
+    beep();
+    if (k == '*') {
+      inputBuf = "";
+      mode = MODE_PIN;
+      unlocked = false;
+      showTemporaryMessage(F("Locked"), STATUS_SHOW_MS);
+      showStatus();
+      return;
+    }
+    if (unlocked && k == 'A') {
+      startRhythm(MODE_ENROLL);
+      return;
+    }
+    if (unlocked && k == 'B') {
+      rhythmEnrolled = false;
+      if (trace.live()) EEPROM.update(RHYTHM_EEPROM_ADDR, 0xFF);
+      showTemporaryMessage(F("Rhythm off"), STATUS_SHOW_MS);
+      showStatus();
+      return;
+    }
+    if (k == '#') {
+      if (inputBuf == CORRECT_PIN && rhythmEnrolled) {
+        inputBuf = "";
+        startRhythm(MODE_RHYTHM);
+        return;
+      } else if (inputBuf == CORRECT_PIN) {
+        openLock();
+      } else {
+        showTemporaryMessage(F("Wrong PIN"), STATUS_SHOW_MS);
+      }
+      inputBuf = "";
+      showStatus();
+      return;
+    }
+    if (k == 'D') {
+      if (inputBuf.length() > 0) inputBuf.erase(inputBuf.length() - 1);
+      showStatus();
+      return;
+    }
+    if ((k >= '0' && k <= '9') || (k >= 'A' && k <= 'D')) {
+      if (inputBuf.length() < 8) inputBuf += k;
+      showStatus();
+    }
+  }
+
+  void openLock() {
+    unlocked = true;
+    showTemporaryMessage(F("Unlocked!"), STATUS_SHOW_MS);
+  }
+
+  void onClap() {
+    unsigned long now = trace.micros();
+    if (now - lastOnsetUs < CLAP_REFRACTORY_US) return;
+    trace.edge(0, now);
+    lastOnsetUs = now;
+    if (onsetCount < RHYTHM_MAX) onsetUs[onsetCount++] = now;
+  }
+
+  void startRhythm(LockMode m) {
+    noInterrupts();
+    onsetCount = 0;
+    interrupts();
+    mode = m;
+    modeStartMs = trace.millis();
+    shownClaps = 0;
+    trace.state(m == MODE_ENROLL ? F("Enrol rhythm") : F("Clap rhythm"));
+    showRhythmPrompt();
+  }
+
+  void handleRhythm() {
+    noInterrupts();
+    uint8_t n = onsetCount;
+    unsigned long last = lastOnsetUs;
+    interrupts();
+    if (n != shownClaps) {
+      shownClaps = n;
+      showRhythmPrompt();
+    }
+    bool ended = n > 0 && (n == RHYTHM_MAX || trace.micros() - last > RHYTHM_END_MS * 1000UL);
+    if (!ended) {
+      if (n == 0 && trace.millis() - modeStartMs > RHYTHM_WAIT_MS) {
+        mode = MODE_PIN;
+        showTemporaryMessage(F("Timed out"), STATUS_SHOW_MS);
+        showStatus();
+      }
+      return;
+    }
+    uint16_t ioi[RHYTHM_MAX - 1];
+    rhythmNormalise(onsetUs, n, ioi);
+    if (mode == MODE_ENROLL) {
+      if (n < RHYTHM_MIN) {
+        showTemporaryMessage(F("Too short"), STATUS_SHOW_MS);
+      } else {
+        enrolled.magic = RHYTHM_MAGIC;
+        enrolled.claps = n;
+        for (uint8_t i = 0; i < n - 1; i++) enrolled.ioi[i] = ioi[i];
+        if (trace.live()) EEPROM.put(RHYTHM_EEPROM_ADDR, enrolled);
+        rhythmEnrolled = true;
+        showTemporaryMessage(F("Rhythm set"), STATUS_SHOW_MS);
+      }
+      mode = MODE_PIN;
+      showStatus();
+      return;
+    }
+    mode = MODE_PIN;
+    if (rhythmMatches(enrolled, n, ioi)) openLock();
+    else showTemporaryMessage(F("Wrong beat"), STATUS_SHOW_MS);
+    showStatus();
+  }
+
+  void loadRhythm() {
+    EEPROM.get(RHYTHM_EEPROM_ADDR, enrolled);
+    rhythmEnrolled = enrolled.magic == RHYTHM_MAGIC && enrolled.claps >= RHYTHM_MIN && enrolled.claps <= RHYTHM_MAX;
+  }
+
+  void showRhythmPrompt() {
+    display.firstPage();
+    do {
+      display.setTextSize(1);
+      display.setCursor(0, 0);
+      display.println(mode == MODE_ENROLL ? F("New rhythm") : F("Clap your rhythm"));
+      display.setCursor(0, 12);
+      display.println(F("* to cancel"));
+      display.setTextSize(2);
+      display.setCursor(0, 34);
+      display.print(F("Claps: "));
+      display.print(shownClaps);
+    } while (display.nextPage());
+  }
+
+  void beep() {
+    trace.delay(140);
+  }
+
+  void showStatus() {
+    char keyText[2] = { lastKey != 0 ? lastKey : '-', '\0' };
+    char masked[9];
+    uint8_t n = inputBuf.length() < 8 ? inputBuf.length() : 8;
+    for (uint8_t i = 0; i < n; i++) masked[i] = '*';
+    masked[n] = '\0';
+    if (n == 0) strcpy(masked, "--");
+    display.firstPage();
+    do {
+      display.setTextSize(1);
+      display.setCursor(0, 0);
+      display.println(F("Digital Safe"));
+      display.setCursor(0, 14);
+      display.print(F("Last Key: "));
+      display.print(keyText);
+      display.setTextSize(2);
+      display.setCursor(0, 34);
+      display.print(masked);
+    } while (display.nextPage());
+  }
+
+  void showTemporaryMessage(const __FlashStringHelper *msg, unsigned long ms) {
+    trace.state(msg);
+    display.firstPage();
+    do {
+      display.setTextSize(2);
+      display.setCursor(0, 18);
+      display.println(msg);
+    } while (display.nextPage());
+    trace.delay(ms);
+  }
+};
+
+void lockOnClap() {
+  lock->onClap();
+}
+
+// ---------- Made-up runs ----------
+
+const uint32_t TAIL_US = TRACE_TAIL_MS * MS;
+
+// A clap on the LM393: D0 high 1..4 times for 0.1..3 ms, within ~10 ms
+void clapPulses(Inputs &r, uint32_t at) {
+  for (uint32_t p = between(1, 4); p > 0; p--) {
+    r.flips.push_back(at);
+    at += between(100, 3000);
+    r.flips.push_back(at);
+    at += between(100, 2000);
+  }
+}
+
+Inputs targetRun() {
+  Inputs r;
+  uint32_t t = between(300, 1500) * MS;
+  for (uint32_t c = between(3, 35); c > 0; c--) {
+    t += next() % 10 < 7 ? between(150, 700) * MS : between(700, 4000) * MS;
+    clapPulses(r, t);
+    t = r.flips.back();
+  }
+  r.endUs = t + TAIL_US + 3000 * MS;
+  return r;
+}
+
+// A clap on INT0: the onset and 0..3 ringing edges, now and then one past the refractory time
+void clapEdges(Inputs &r, uint32_t at) {
+  r.edges.push_back(at);
+  for (uint32_t k = between(0, 3); k > 0; k--) r.edges.push_back(at + between(1, 60) * MS);
+  if (next() % 20 == 0) r.edges.push_back(at + between(85, 110) * MS);
+}
+
+const uint8_t PATTERNS[4][6] = { { 0, 2, 3, 4, 6, 255 }, { 0, 1, 2, 4, 255 }, { 0, 2, 4, 5, 6, 8 }, { 0, 3, 4, 6, 7, 255 } };
+
+uint32_t clapPattern(Inputs &r, uint32_t t, uint8_t p) {
+  uint32_t eighth = between(110, 200) * MS, at = t;
+  for (uint8_t i = 0; i < 6 && PATTERNS[p][i] != 255; i++) {
+    at = t + PATTERNS[p][i] * eighth + between(0, 40) * MS;
+    clapEdges(r, at);
+  }
+  return at;
+}
+
+uint32_t type(Inputs &r, uint32_t t, const char *keys) {
+  for (const char *k = keys; *k; k++) {
+    t += next() % 100 < 15 ? between(20, 130) * MS : between(180, 700) * MS;   // sometimes during the beep
+    r.keys.push_back({ t, between(60, 250) * MS, *k });
+  }
+  return t;
+}
+
+Inputs lockRun() {
+  Inputs r;
+  uint32_t t = between(1000, 1400) * MS;
+  uint8_t owner = next() % 4;
+  for (uint32_t a = between(3, 10); a > 0; a--) {
+    uint32_t kind = next() % 100;
+    char wrong[6] = { 0 };
+    if (kind < 30) {
+      t = type(r, t, "1234#");
+    } else if (kind < 40) {
+      for (uint32_t i = 0, n = between(3, 5); i < n; i++) wrong[i] = '0' + next() % 10;
+      t = type(r, t, wrong);
+      t = type(r, t, "#");
+    } else if (kind < 55) {
+      t = type(r, t, "A");
+      t = clapPattern(r, t + between(300, 1200) * MS, owner);
+    } else if (kind < 70) {
+      t = clapPattern(r, t + between(300, 1500) * MS, next() % 10 < 7 ? owner : next() % 4);
+    } else if (kind < 78) {
+      t = type(r, t, "B");
+    } else if (kind < 86) {
+      t = type(r, t, "*");
+    } else if (kind < 93) {
+      for (uint32_t c = between(1, 3); c > 0; c--) {
+        t += between(100, 900) * MS;
+        clapEdges(r, t);
+      }
+    } else {
+      char key[2] = { "123A456B789C*0#D"[next() % 16], 0 };
+      t = type(r, t, key);
+    }
+    t += between(200, 2500) * MS;
+  }
+  std::sort(r.edges.begin(), r.edges.end());
+  std::sort(r.keys.begin(), r.keys.end(), [](const Press &a, const Press &b) { return a.us < b.us; });
+  r.endUs = t + TAIL_US + RHYTHM_WAIT_MS * MS;
+  return r;
+}
+
+// ---------- Record, replay, compare ----------
+
+struct Log {
+  std::string out;                             // all Serial output of the boot
+  std::vector<std::pair<uint32_t, std::string> > states;   // #S time, name [value]
+  uint32_t endUs = 0;                          // #END
+  bool ended = false, lost = false, full = false;
+  uint16_t frame = 0;
+  uint32_t events = 0;                         // #E lines
+};
+
+Log parse(const std::string &out) {
+  Log g;
+  g.out = out;
+  size_t at = 0;
+  while (at < out.size()) {
+    size_t eol = out.find("\r\n", at);
+    if (eol == std::string::npos) eol = out.size();
+    std::string line = out.substr(at, eol - at);
+    at = eol + 2;
+    if (!line.compare(0, 3, "#S ")) {
+      size_t sp = line.find(' ', 3);
+      g.states.push_back({ (uint32_t)strtoul(line.c_str() + 3, NULL, 10), line.substr(sp + 1) });
+    } else if (!line.compare(0, 3, "#E ")) {
+      g.events++;
+    } else if (!line.compare(0, 5, "#END ")) {
+      g.endUs = strtoul(line.c_str() + 5, NULL, 10);
+      g.ended = true;
+    } else if (!line.compare(0, 7, "#FRAME ")) {
+      g.frame = strtoul(line.c_str() + 7, NULL, 10);
+    } else if (!line.compare(0, 5, "#LOST")) {
+      g.lost = true;
+    } else if (!line.compare(0, 5, "#FULL")) {
+      g.full = true;
+    }
+  }
+  return g;
+}
+
+// Boot, send c: the watchdog reset ends the boot
+template<class S> void resetWith(char c) {
+  hostClock() = 0;
+  S s;
+  s.setup(0);
+  try {
+    s.trace.command(c);
+  } catch (WatchdogReset &) {
+  }
+}
+
+typedef std::vector<std::pair<uint32_t, uint16_t> > Screens;   // (trace time, crc) per display()
+
+uint16_t screenAt(const Screens &s, uint32_t us) {
+  uint16_t crc = 0;
+  for (auto &d : s) if (d.first <= us) crc = d.second;
+  return crc;
+}
+
+template<class S> Log replay(uint32_t *passes, Screens *screens = nullptr) {
+  hostClock() = 0;
+  Serial.text.clear();
+  S s;
+  s.setup(0);
+  uint32_t n = 0;
+  while (!s.over && n < 2000000) {
+    s.loop();
+    n++;
+  }
+  *passes += n;
+  if (screens) *screens = s.display.history;
+  return parse(Serial.text);
+}
+
+struct Tally {
+  uint32_t runs = 0, full = 0, lost = 0, notEnded = 0, notSame = 0, otherStates = 0, otherScreen = 0;
+  uint32_t states = 0, events = 0, passes = 0;
+  double boardSeconds = 0, cpuSeconds = 0;
+};
+
+template<class S> void check(Inputs &in, uint32_t seed, Tally &t, bool show) {
+  memset(EEPROM.bytes, 0xFF, sizeof(EEPROM.bytes));
+  resetWith<S>('R');
+
+  // recorded live on the made-up board
+  hostClock() = 0;
+  Serial.text.clear();
+  live = &in;
+  nextEdge = nextKey = 0;
+  int0 = nullptr;
+  hostWait() = runInterrupts;
+  S rec;
+  rec.setup(seed);
+  while (hostClock() < in.endUs) rec.loop();
+  rec.trace.poll();              // the last events out
+  Log r = parse(Serial.text);
+  Screens screens = rec.display.history;
+  live = nullptr;
+  hostWait() = nullptr;
+  t.runs++;
+  t.events += r.events;
+  if (r.full) {
+    t.full++;
+    return;
+  }
+  if (r.lost) t.lost++;
+
+  resetWith<S>('P');
+  clock_t c0 = clock();
+  Screens replayed;
+  Log a = replay<S>(&t.passes, &replayed);
+  t.cpuSeconds += (double)(clock() - c0) / CLOCKS_PER_SEC;
+  t.boardSeconds += a.endUs / 1e6;
+  resetWith<S>('P');
+  Log b = replay<S>(&t.passes);
+
+  if (!a.ended) t.notEnded++;
+  if (a.out != b.out) t.notSame++;
+  // the recording stopped at in.endUs, the replay goes on to its #END
+  uint32_t upTo = std::min(a.endUs, in.endUs);
+  std::vector<std::string> want, got;
+  for (auto &s : r.states) if (s.first <= upTo) want.push_back(s.second);
+  for (auto &s : a.states) if (s.first <= upTo) got.push_back(s.second);
+  t.states += got.size();
+  uint16_t screen = screenAt(screens, upTo), frame = screenAt(replayed, upTo);
+  expect("#FRAME is the last screen", a.frame == screenAt(replayed, a.endUs));
+  bool sameStates = want == got, sameScreen = screen == frame;
+  if (!sameStates) t.otherStates++;
+  if (!sameScreen) t.otherScreen++;
+  if (show && (!sameStates || !sameScreen)) {
+    printf("  run %u: recorded %zu states, replayed %zu; screen %u / %u\n", t.runs, want.size(), got.size(), screen, frame);
+    for (size_t i = 0; i < std::max(want.size(), got.size()); i++) {
+      printf("    %-16s %s\n", i < want.size() ? want[i].c_str() : "-", i < got.size() ? got[i].c_str() : "-");
+    }
+  }
+}
+
+void report(const char *name, const Tally &t) {
+  printf("%-12s %u runs: %u too long for the EEPROM, %u lost events, %u not ended, %u replays differ from each other,\n"
+         "             %u with other states, %u with another screen than the recording\n",
+         name, t.runs, t.full, t.lost, t.notEnded, t.notSame, t.otherStates, t.otherScreen);
+  printf("             %.1f events and %.1f states per run, %.0f s of board time in %.2f s of CPU (%.0fx), %.1f loop passes per board second\n",
+         (double)t.events / t.runs, (double)t.states / (t.runs - t.full), t.boardSeconds, t.cpuSeconds, t.boardSeconds / t.cpuSeconds, t.passes / 2 / t.boardSeconds);
+  expect(name, t.lost == 0 && t.notEnded == 0 && t.notSame == 0 && t.otherStates == 0 && t.otherScreen == 0);
+  expect("most runs fit", t.full < t.runs / 20);
+}
+
+// A board's 'D' dump into this EEPROM as a recording, then the replay
+template<class S> int replayFile(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    printf("cannot read %s\n", path);
+    return 2;
+  }
+  // the EEPROM as InputTrace keeps it: header, then 8-byte events
+  struct {
+    uint8_t magic, arm;
+    uint16_t count;
+    uint32_t seed;
+  } h = { TRACE_MAGIC, InputTrace::REPLAY, 0, 0 };
+  char line[128];
+  bool begun = false;
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long seed, us;
+    unsigned id, value;
+    char kind;
+    if (!begun && sscanf(line, "#TRACE seed=%lu", &seed) == 1) {
+      h.seed = seed;
+      begun = true;
+    } else if (begun && sscanf(line, "#E %lu %c %u %u", &us, &kind, &id, &value) == 4) {
+      TraceEvent e = { (uint32_t)us, (uint8_t)kind, (uint8_t)id, (uint16_t)value };
+      EEPROM.put(S::TRACE_ADDR + sizeof(h) + h.count * sizeof(e), e);
+      h.count++;
+    }
+  }
+  fclose(f);
+  if (!begun) {
+    printf("no #TRACE line in %s\n", path);
+    return 2;
+  }
+  EEPROM.put(S::TRACE_ADDR, h);
+  uint32_t events = h.count, passes = 0;
+  Log g = replay<S>(&passes);
+  fputs(g.out.c_str(), stdout);
+  printf("%u events, %u loop passes, %s\n", events, passes, g.ended ? "ended" : "did not end");
+  return g.ended ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  if (argc == 3) {
+    if (!strcmp(argv[1], "target")) return replayFile<TargetGame>(argv[2]);
+    if (!strcmp(argv[1], "lock")) return replayFile<Lock>(argv[2]);
+    printf("usage: inputtrace [target|lock trace.txt]\n");
+    return 2;
+  }
+
+  Tally game, safe;
+  for (int i = 0; i < RUNS; i++) {
+    Inputs in = targetRun();
+    check<TargetGame>(in, next(), game, game.otherStates + game.otherScreen < 2);
+  }
+  report("Target Game", game);
+  for (int i = 0; i < RUNS; i++) {
+    Inputs in = lockRun();
+    check<Lock>(in, 0, safe, safe.otherStates + safe.otherScreen < 2);
+  }
+  report("lock", safe);
+
+  printf(ok ? "inputtrace ok\n" : "inputtrace FAIL\n");
+  return ok ? 0 : 1;
+}
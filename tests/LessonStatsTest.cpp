@@ -0,0 +1,201 @@
+/* LessonStatsTest.cpp - lesson histogram percentiles against an exact sort
+
+     g++ -std=c++11 -I tests -I . tests/LessonStatsTest.cpp -o lesson && ./lesson [levels.txt]
+
+   Recordings of one level a second (centi-dB, as the Decibel Meter feeds
+   LessonStats), made up here with a fixed seed:
+
+     lesson  45 minutes: teacher talking (62 dB), group work (72 dB),
+             quiet work (45 dB) and a few single loud seconds (85 dB)
+     day     six hours of lessons and breaks without 'z'
+     empty   three hours of an empty room at 35 dB with a loud second
+             (80 dB) every 10 minutes
+     hum     22 hours of a fan at 40 dB, 1 s in 20 at 75 dB: one bin
+             passes 65535 and the 16-bit totals are halved
+
+   With an argument the levels (dB, one per line) are read from that file
+   instead, e.g. the SPL column of a logged session.
+
+   The sketch's LessonStats is fed with a flush() every 5 minutes, into
+   16-bit totals kept in an array here (EEPROM on the board). L10, L50,
+   L90 and the seconds at 70 dB or more are compared with the same
+   numbers from all the levels sorted. Also shown: the 8-bit bins the
+   sketch had before, all halved (x >> 1) when one was full. Each halving
+   made the seconds after it count double and dropped the bins holding a
+   single count. Checked: each Lx within one bin (0.5 dB) of the exact
+   value, the loud time within 10% or 60 s, and no second lost.
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "LessonStats.h"
+
+const int16_t LOUD_CDB = 7000;             // Scale::loudDb
+const uint16_t SAVE_SECONDS = 300;         // STATS_SAVE_MS
+
+struct SavedBins {
+  uint16_t count[STATS_BINS];
+  uint16_t get(uint8_t bin) const { return count[bin]; }
+  void set(uint8_t bin, uint16_t n) { count[bin] = n; }
+};
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+double uniform(double a, double b) { return a + (b - a) * (next() % 100000) / 100000.0; }
+double gauss() {
+  double s = 0;
+  for (int i = 0; i < 12; i++) s += (next() % 100000) / 100000.0;
+  return s - 6;
+}
+
+void push(std::vector<int16_t> &rec, double db) { rec.push_back((int16_t)lround(db * 100)); }
+
+// Activities of 2..8 minutes, each a mean level with its own spread
+void lesson(std::vector<int16_t> &rec, uint32_t seconds) {
+  const double MEAN[3] = { 62, 72, 45 }, SPREAD[3] = { 4, 3, 2 };
+  uint32_t end = rec.size() + seconds;
+  while (rec.size() < end) {
+    uint8_t a = next() % 3;
+    uint32_t len = 120 + next() % 361;
+    for (uint32_t i = 0; i < len && rec.size() < end; i++) {
+      push(rec, next() % 200 == 0 ? uniform(82, 88) : MEAN[a] + SPREAD[a] * gauss());
+    }
+  }
+}
+
+struct Levels {
+  double l10, l50, l90;
+  uint32_t loud;
+};
+
+Levels exact(std::vector<int16_t> rec) {
+  std::sort(rec.begin(), rec.end(), [](int16_t a, int16_t b) { return a > b; });
+  size_t n = rec.size();
+  Levels r;
+  r.l10 = rec[(n * 10 + 99) / 100 - 1] / 100.0;
+  r.l50 = rec[(n * 50 + 99) / 100 - 1] / 100.0;
+  r.l90 = rec[(n * 90 + 99) / 100 - 1] / 100.0;
+  r.loud = std::count_if(rec.begin(), rec.end(), [](int16_t v) { return v >= LOUD_CDB; });
+  return r;
+}
+
+Levels fromStats(const LessonStats<SavedBins> &s) {
+  Levels r = { s.level(10) / 100.0, s.level(50) / 100.0, s.level(90) / 100.0, s.secondsFrom(LOUD_CDB) };
+  return r;
+}
+
+// The 8-bit histogram the sketch had before: a full bin halved all of them
+struct OldStats {
+  uint32_t seconds;
+  uint8_t bins[STATS_BINS];
+
+  void add(int16_t cdb) {
+    uint8_t b = LessonStats<SavedBins>::binOf(cdb);
+    if (bins[b] == 0xFF) {
+      for (uint8_t i = 0; i < STATS_BINS; i++) bins[i] >>= 1;
+    }
+    bins[b]++;
+    seconds++;
+  }
+
+  // as a LessonStats, for the same percentile code
+  LessonStats<SavedBins> asNew() const {
+    LessonStats<SavedBins> s;
+    s.clear();
+    for (uint8_t i = 0; i < STATS_BINS; i++) s.saved.count[i] = bins[i];
+    s.seconds = seconds;
+    return s;
+  }
+};
+
+void print(const char *what, const Levels &l) {
+  printf("  %-10s L10 %5.2f  L50 %5.2f  L90 %5.2f  >= 70 dB %5u s\n", what, l.l10, l.l50, l.l90, l.loud);
+}
+
+void check(const char *name, const std::vector<int16_t> &rec) {
+  LessonStats<SavedBins> s;
+  OldStats t = {};
+  s.clear();
+  uint32_t flushes = 0, halvings = 0;
+  for (int16_t v : rec) {
+    if (t.bins[LessonStats<SavedBins>::binOf(v)] == 0xFF) halvings++;
+    t.add(v);
+    if (s.add(v) || s.seconds % SAVE_SECONDS == 0) {
+      s.flush();
+      flushes++;
+    }
+  }
+  Levels want = exact(rec), got = fromStats(s), old = fromStats(t.asNew());
+  printf("%s: %zu s, %u flushes, %u counts in the 16-bit totals, %u halvings of the old 8-bit bins\n",
+         name, rec.size(), flushes, s.count(0), halvings);
+  print("sorted", want);
+  print("histogram", got);
+  print("old 8-bit", old);
+
+  char what[64];
+  double bin = STATS_BIN_CDB / 100.0;
+  snprintf(what, sizeof(what), "%s: L10/L50/L90 within a bin", name);
+  expect(what, fabs(got.l10 - want.l10) <= bin && fabs(got.l50 - want.l50) <= bin && fabs(got.l90 - want.l90) <= bin);
+  snprintf(what, sizeof(what), "%s: loud time", name);
+  double off = fabs((double)got.loud - want.loud);
+  expect(what, off <= 60 || off <= 0.1 * want.loud);
+  snprintf(what, sizeof(what), "%s: seconds counted", name);
+  expect(what, s.seconds == rec.size());
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    FILE *f = fopen(argv[1], "r");
+    if (!f) {
+      printf("cannot read %s\n", argv[1]);
+      return 2;
+    }
+    std::vector<int16_t> rec;
+    double db;
+    while (fscanf(f, "%lf", &db) == 1) push(rec, db);
+    fclose(f);
+    if (rec.empty()) {
+      printf("no levels in %s\n", argv[1]);
+      return 2;
+    }
+    check(argv[1], rec);
+  } else {
+    std::vector<int16_t> rec;
+    lesson(rec, 45 * 60);
+    check("lesson", rec);
+
+    rec.clear();
+    for (uint8_t k = 0; k < 6; k++) {
+      lesson(rec, 45 * 60);
+      for (uint32_t i = 0; i < 15 * 60; i++) push(rec, 55 + 6 * gauss());   // break
+    }
+    check("day", rec);
+
+    rec.clear();
+    for (uint32_t i = 0; i < 3 * 3600; i++) push(rec, i % 600 == 300 ? 80 : 35 + 0.2 * gauss());
+    check("empty", rec);
+
+    rec.clear();
+    for (uint32_t i = 0; i < 22 * 3600UL; i++) push(rec, next() % 20 == 0 ? 75 : 40.2 + 0.05 * gauss());
+    check("hum", rec);
+  }
+
+  printf(ok ? "lessonstats ok\n" : "lessonstats FAIL\n");
+  return ok ? 0 : 1;
+}
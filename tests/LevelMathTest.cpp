@@ -0,0 +1,123 @@
+/* LevelMathTest.cpp - LevelMath.h tables against log10(), exp() and sqrt()
+
+     g++ -std=c++11 -I tests -I . tests/LevelMathTest.cpp -o lm && ./lm
+
+   log10Cdb() has to stay within 0.1 dB of 10*log10() over the whole 32-bit
+   range, isqrt32() has to be exact, decayFactor() has to give the time
+   constant within 1% for chunks of 50 samples and more (the meter takes
+   100), and the Fast/Slow/Impulse integrators of the Decibel Meter fed
+   with random chunks have to follow a double-precision exp() reference
+   within 0.05 dB. The worst errors are printed.
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include "LevelMath.h"
+
+typedef MeterScale<6, 30, 120, 116, 70> Scale;   // as in the Decibel Meter
+const uint32_t RATE = 5000;
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+double dbError(uint32_t v) {
+  return fabs(log10Cdb<Scale>(v) / 100.0 - 10.0 * log10((double)(v ? v : 1)));
+}
+
+template<class T>
+void decay(const char *name, uint16_t tauMs) {
+  double worst = 0;
+  for (uint16_t n = 50; n < 20000; n++) {
+    double want = exp(-(double)n * 1000.0 / ((double)tauMs * RATE));
+    double got = decayFactor(T::data, n) / 65536.0;
+    if (want < 0.01) break;            // tau from a factor near 0 means nothing
+    double tau = -(double)n * 1000.0 / (RATE * log(got));
+    double err = fabs(tau / tauMs - 1);
+    if (err > worst) worst = err;
+  }
+  printf("decay %-8s tau %4u ms: worst tau error %.3f%%\n", name, tauMs, 100 * worst);
+  expect(name, worst < 0.01);
+}
+
+int main() {
+  // every value up to 2^20, then random and edge values up to 2^32 - 1
+  double worst = 0;
+  uint32_t worstAt = 0;
+  for (uint32_t v = 1; v < (1UL << 20); v++) {
+    double e = dbError(v);
+    if (e > worst) { worst = e; worstAt = v; }
+  }
+  for (int k = 0; k < 1000000; k++) {
+    uint32_t v = next();
+    double e = dbError(v);
+    if (e > worst) { worst = e; worstAt = v; }
+  }
+  for (uint8_t b = 0; b < 32; b++) {
+    uint32_t v = 1UL << b;
+    for (uint32_t w : { v - 1, v, v + 1, v | (v >> 1) }) {
+      double e = dbError(w);
+      if (e > worst) { worst = e; worstAt = w; }
+    }
+  }
+  printf("log10Cdb: worst error %.3f dB at %lu\n", worst, (unsigned long)worstAt);
+  expect("log10Cdb within 0.1 dB", worst <= 0.1);
+
+  bool exact = isqrt32(0) == 0 && isqrt32(0xFFFFFFFFUL) == 65535;
+  for (uint32_t r = 1; r < 65536; r++) {
+    uint32_t sq = r * r;
+    exact &= isqrt32(sq) == r && isqrt32(sq - 1) == r - 1;
+  }
+  for (int k = 0; k < 1000000; k++) {
+    uint32_t v = next();
+    uint32_t r = isqrt32(v);
+    exact &= (uint64_t)r * r <= v && (uint64_t)(r + 1) * (r + 1) > v;
+  }
+  expect("isqrt32 exact", exact);
+
+  decay<DecayTable<RATE, 125> >("fast", 125);
+  decay<DecayTable<RATE, 1000> >("slow", 1000);
+  decay<DecayTable<RATE, 35> >("impulse", 35);
+  decay<DecayTable<RATE, 1500> >("fall", 1500);
+
+  // the three integrators against a double reference, random chunks of
+  // 100..160 samples, levels jumping between quiet and full scale
+  const uint16_t *table[4] = { DecayTable<RATE, 125>::data, DecayTable<RATE, 1000>::data,
+                               DecayTable<RATE, 35>::data, DecayTable<RATE, 1500>::data };
+  const double tau[4] = { 0.125, 1.0, 0.035, 1.5 };
+  uint32_t y[3];
+  double ref[3];
+  worst = 0;
+  uint32_t x = 1000;
+  for (uint8_t w = 0; w < 3; w++) { y[w] = x; ref[w] = x; }
+  for (int chunk = 0; chunk < 200000; chunk++) {
+    if (chunk % 50 == 0) x = (next() % 4 == 0) ? next() % 268000000UL : next() % 20000 + 256;
+    uint16_t n = 100 + next() % 61;
+    for (uint8_t w = 0; w < 3; w++) {
+      uint8_t t = (w == 2 && x < y[w]) ? 3 : w;         // Impulse falls slowly
+      uint8_t rt = (w == 2 && x < ref[w]) ? 3 : w;
+      y[w] = levelStep(y[w], x, decayFactor(table[t], n));
+      ref[w] = x + (ref[w] - x) * exp(-n / (tau[rt] * RATE));
+      double e = fabs(10 * log10((y[w] + 1.0) / (ref[w] + 1.0)));
+      if (e > worst) worst = e;
+    }
+  }
+  printf("integrators: worst error %.4f dB against exp()\n", worst);
+  expect("integrators within 0.05 dB", worst < 0.05);
+
+  printf(ok ? "levelmath ok\n" : "levelmath FAIL\n");
+  return ok ? 0 : 1;
+}
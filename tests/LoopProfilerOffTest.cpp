@@ -0,0 +1,29 @@
+/* LoopProfilerOffTest.cpp - with PROFILE_ENABLED 0 the macros are nothing
+
+     g++ -std=c++11 -I tests -I . tests/LoopProfilerOffTest.cpp -o proff && ./proff
+
+   There is no profiler object and the stage names below do not exist, so
+   this only compiles if the macros expand to nothing. micros() counts its
+   calls here: a pass full of macros must not read the clock either.
+*/
+
+#include <Arduino.h>
+
+#define PROFILE_ENABLED 0
+#include "LoopProfiler.h"
+
+void pass() {
+  PROF_PERIOD(NO_SUCH_LOOP);
+  PROF_FOLD();
+  PROF_BEGIN(NO_SUCH_STAGE);
+  PROF_END(NO_SUCH_STAGE);
+}
+
+int main() {
+  unsigned long before = micros();
+  for (int i = 0; i < 1000; i++) pass();
+  bool ok = micros() == before + 1;
+  if (!ok) printf("FAIL: the macros read the clock\n");
+  printf(ok ? "profiler off ok\n" : "profiler off FAIL\n");
+  return ok ? 0 : 1;
+}
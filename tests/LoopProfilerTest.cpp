@@ -0,0 +1,116 @@
+/* LoopProfilerTest.cpp - LoopProfiler.h buckets, fold and report on a PC
+
+     g++ -std=c++11 -I tests -I . tests/LoopProfilerTest.cpp -o prof && ./prof
+
+   Durations go in through record() (what PROF_END does) and come out of
+   fold() in the right log2 bucket, with min/max/n; a stage that was not
+   recorded in a pass is left alone by fold(), a full bucket halves them
+   all, and the 't' report of a known set of durations is compared line by
+   line. Last, the macros run in a pretend loop() (micros() counts calls
+   here, so only the counts mean anything).
+*/
+
+#include <Arduino.h>
+
+#define PROFILE_ENABLED 1
+#include "LoopProfiler.h"
+
+enum ProfStage { PROF_SAMPLE, PROF_DRAW, PROF_LOOP, PROF_COUNT };
+const char PROF_NAMES[PROF_COUNT][7] PROGMEM = { "sample", "draw", "loop" };
+LoopProfiler<PROF_COUNT> profiler;
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+// bucket of one duration: record, fold, find the only non-empty bucket
+int bucketOf(uint16_t ticks) {
+  profiler.reset();
+  profiler.record(PROF_DRAW, ticks);
+  profiler.fold();
+  const ProfStats &st = profiler.stats[PROF_DRAW];
+  int found = -1;
+  for (uint8_t b = 0; b < PROF_BUCKETS; b++) {
+    if (st.hist[b] == 1 && found < 0) found = b;
+    else if (st.hist[b] != 0) return -2;
+  }
+  return found;
+}
+
+int main() {
+  // bucket b holds 2^b .. 2^(b+1)-1 ticks (0 goes with 1)
+  expect("0 ticks", bucketOf(0) == 0);
+  bool edges = true;
+  for (uint8_t b = 0; b < PROF_BUCKETS; b++) {
+    uint16_t lo = 1U << b;
+    uint16_t hi = (uint16_t)((2UL << b) - 1);
+    edges &= bucketOf(lo) == b && bucketOf(hi) == b;
+  }
+  expect("bucket edges", edges);
+
+  profiler.reset();
+  for (uint16_t t : { 30, 10, 500 }) {
+    profiler.record(PROF_SAMPLE, t);
+    profiler.fold();
+  }
+  profiler.fold();   // nothing recorded: no change
+  const ProfStats &s = profiler.stats[PROF_SAMPLE];
+  expect("min/max/n", s.n == 3 && s.minT == 10 && s.maxT == 500);
+  expect("other stages untouched", profiler.stats[PROF_DRAW].n == 0 && profiler.stats[PROF_LOOP].n == 0);
+
+  // the second record of a stage in one pass replaces the first
+  profiler.reset();
+  profiler.record(PROF_SAMPLE, 7);
+  profiler.record(PROF_SAMPLE, 9);
+  profiler.fold();
+  expect("one per pass", s.n == 1 && s.minT == 9);
+
+  // bucket 3 full: all halve, the new one still counts
+  profiler.reset();
+  for (int i = 0; i < 255; i++) { profiler.record(PROF_SAMPLE, 8); profiler.fold(); }
+  profiler.record(PROF_SAMPLE, 2);
+  profiler.fold();
+  profiler.record(PROF_SAMPLE, 8);
+  profiler.fold();
+  expect("halving", s.hist[3] == 128 && s.hist[1] == 0 && s.n == 257);
+
+  // report: 99 short loops and 1 long one, p99 is the edge of the short bucket
+  profiler.reset();
+  for (int i = 0; i < 99; i++) { profiler.record(PROF_LOOP, 300); profiler.fold(); }
+  profiler.record(PROF_LOOP, 5000);
+  profiler.record(PROF_SAMPLE, 25);
+  Print out;
+  profiler.dump(out, PROF_NAMES[0], sizeof(PROF_NAMES[0]));   // folds first
+  const char *want =
+      "\nstage  n\tmin\tp99\tmax (us)\r\n"
+      "sample 1\t100\t124\t100\r\n"
+      "    <128:1\r\n"
+      "draw   0\t0\t4\t0\r\n"
+      "   \r\n"
+      "loop   100\t1200\t2044\t20000\r\n"
+      "    <2048:99 <32768:1\r\n";
+  if (out.text != want) {
+    printf("FAIL report:\n%s\nwant:\n%s\n", out.text.c_str(), want);
+    ok = false;
+  }
+
+  // the macros in a pretend loop(): 1000 passes, one sample stage each
+  profiler.reset();
+  for (int pass = 0; pass < 1000; pass++) {
+    PROF_PERIOD(LOOP);
+    PROF_FOLD();
+    PROF_BEGIN(SAMPLE);
+    micros();
+    PROF_END(SAMPLE);
+  }
+  profiler.fold();
+  expect("macros", profiler.stats[PROF_SAMPLE].n == 1000 && profiler.stats[PROF_LOOP].n == 1000);
+
+  printf(ok ? "profiler ok\n" : "profiler FAIL\n");
+  return ok ? 0 : 1;
+}
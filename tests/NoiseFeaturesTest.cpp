@@ -0,0 +1,100 @@
+/* NoiseFeaturesTest.cpp - NoiseFeatures.h on quiet and full-scale windows
+
+     g++ -std=c++11 -I tests -I . tests/NoiseFeaturesTest.cpp -o nf && ./nf
+
+   Every window is also worked out with 64-bit arithmetic; the sketch's
+   integer code has to give the same numbers. The full-scale cases are the
+   ones a 16-bit square (|d| >= 256) used to get wrong: a clipped square
+   wave, a sine over the whole ADC range and a single full-scale click.
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include "NoiseFeatures.h"
+
+const uint8_t N = 50;   // WINDOW_SAMPLES in the Noise Meter
+const int8_t HYST = 2;  // ZCR_HYST
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+// 64-bit reference of energy and peak
+void reference(const int16_t *s, uint8_t n, uint64_t &energy, uint64_t &peakSq) {
+  long sum = 0;
+  for (uint8_t i = 0; i < n; i++) sum += s[i];
+  long mean = sum / n;
+  uint64_t sumSq = 0;
+  peakSq = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    int64_t d = s[i] - mean;
+    uint64_t sq = (uint64_t)(d * d);
+    sumSq += sq;
+    if (sq > peakSq) peakSq = sq;
+  }
+  energy = sumSq / n;
+}
+
+WindowFeatures check(const char *name, const int16_t *s) {
+  WindowFeatures w;
+  windowFeatures(s, N, HYST, w);
+  uint64_t energy, peakSq;
+  reference(s, N, energy, peakSq);
+  uint32_t crest = w.energy ? w.peakSq * 16 / w.energy : 0;
+  printf("%-12s energy %7lu  peakSq %7lu  crest %4lu  zcr %2u\n", name,
+         (unsigned long)w.energy, (unsigned long)w.peakSq, (unsigned long)crest, w.crossings);
+  expect(name, w.energy == energy && w.peakSq == peakSq);
+  return w;
+}
+
+int main() {
+  int16_t s[N];
+
+  for (uint8_t i = 0; i < N; i++) s[i] = (i & 1) ? 3 : -3;
+  WindowFeatures quiet = check("quiet", s);
+  expect("quiet crossings", quiet.crossings == N - 1);
+
+  for (uint8_t i = 0; i < N; i++) s[i] = (i & 1) ? 511 : -512;
+  WindowFeatures square = check("square", s);
+  expect("square energy", square.energy > 260000);
+  expect("square crest 1", square.peakSq * 16 / square.energy == 16);
+  expect("square crossings", square.crossings == N - 1);
+
+  for (uint8_t i = 0; i < N; i++) s[i] = (int16_t)lround(511 * cos(2 * M_PI * i / 10));
+  WindowFeatures sine = check("sine", s);
+  uint32_t crest = sine.peakSq * 16 / sine.energy;
+  expect("sine crest 2", crest >= 30 && crest <= 34);
+  expect("sine crossings", sine.crossings == 10);
+
+  for (uint8_t i = 0; i < N; i++) s[i] = -512;
+  s[N / 2] = 511;
+  WindowFeatures click = check("click", s);
+  expect("click peak", click.peakSq > 1000000);
+  expect("click crest", click.peakSq * 16 / click.energy > 700);
+
+  uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+  for (int k = 0; k < 1000; k++) {
+    for (uint8_t i = 0; i < N; i++) {
+      rng ^= rng << 13;
+      rng ^= rng >> 17;
+      rng ^= rng << 5;
+      s[i] = (int16_t)(rng % 1024) - 512;
+    }
+    WindowFeatures w;
+    windowFeatures(s, N, HYST, w);
+    uint64_t energy, peakSq;
+    reference(s, N, energy, peakSq);
+    if (w.energy != energy || w.peakSq != peakSq) {
+      expect("random window", false);
+      break;
+    }
+  }
+
+  printf(ok ? "features ok\n" : "features FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+/* NoiseMeterRmsTest.cpp - Noise Meter level: sliding RMS against the old 50-sample average
+
+     g++ -std=c++11 -I tests -I . tests/NoiseMeterRmsTest.cpp -o rms && ./rms
+
+   new  the P2.2.1 ADC ISR at 6250 Hz: DC follower (DC_SHIFT 8), the last
+        128 DC-free samples (20.5 ms) in a ring with a running sum of
+        squares, windowRms() read for a frame every 40 ms
+   old  the sketch as it was: 50 analogRead() with delayMicroseconds(50)
+        between them (about 162 us apart, 8.1 ms in all), their mean shown,
+        then a frame (about 23 ms for the SSD1306 at 400 kHz, 2 ms more
+        when angry) and delay(200): one reading every 235 ms or so. The
+        loop times are estimates, not measured on a board.
+
+   The mic is a bias of 512.3 counts plus the sound plus 1 count RMS of
+   noise, rounded and clipped to 0..1023. Reported:
+
+     tones    level shown for 60 count tones of 100 Hz .. 2 kHz and for
+              broadband noise, mean and spread over the frames, against the
+              true RMS
+     silence  the level in a quiet room, and if the face would be angry
+              (level >= QUIET_THRESHOLD 25)
+     step     time from the sound starting until the shown level has moved
+              from the quiet level by 90% of the new RMS
+     bursts   share of 10 ms and 30 ms bursts (80 counts RMS of noise, at
+              random times) that move the shown level by 25 or more
+
+   Checked: the sliding RMS is within 5% of the true RMS for every tone
+   and the noise and below the threshold in silence, steps show within
+   two frames, and it sees more bursts than the old averaging, which
+   shows the bias (about 512) whatever the sound and so is always angry.
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include <vector>
+
+const double RATE = 6250;                  // SAMPLE_RATE
+const uint8_t RING = 128;                  // RING_SAMPLES
+const uint8_t DC_SHIFT = 8;
+const double FRAME = 0.040;                // FRAME_MS
+const double OLD_SAMPLE = 162e-6;          // analogRead() + delayMicroseconds(50)
+const double OLD_LOOP = 50 * OLD_SAMPLE + 0.023 + 0.200;
+const int QUIET_THRESHOLD = 25;
+const double BIAS = 512.3, MIC_NOISE = 1;
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+double uniform(double a, double b) { return a + (b - a) * (next() % 100000) / 100000.0; }
+double gauss() {
+  double s = 0;
+  for (int i = 0; i < 12; i++) s += (next() % 100000) / 100000.0;
+  return s - 6;
+}
+
+// The sound at t seconds, in ADC counts around the bias
+struct Sound {
+  double tone, hz, noise;            // steady part
+  double start;                      // silent before this
+  std::vector<double> bursts;        // burst start times
+  double burstLen, burstRms;
+
+  double at(double t) const {
+    double v = 0;
+    if (t >= start) v = tone * sin(2 * M_PI * hz * t) + noise * gauss();
+    for (double b : bursts) {
+      if (t >= b && t < b + burstLen) v += burstRms * gauss();
+    }
+    return v;
+  }
+};
+
+int16_t adc(const Sound &s, double t) {
+  long raw = lround(BIAS + s.at(t) + MIC_NOISE * gauss());
+  return raw < 0 ? 0 : raw > 1023 ? 1023 : raw;
+}
+
+struct Reading {
+  double t;                          // when it is shown
+  int level;
+};
+
+// The ISR and windowRms() of the sketch, a reading per frame
+std::vector<Reading> sliding(const Sound &s, double seconds) {
+  std::vector<Reading> out;
+  int16_t ring[RING] = {};
+  uint32_t sumSq = 0;
+  int32_t dcQ8 = 512L << DC_SHIFT;
+  uint8_t head = 0;
+  double nextFrame = FRAME;
+  for (uint32_t n = 0; n < seconds * RATE; n++) {
+    double t = n / RATE;
+    int16_t raw = adc(s, t);
+    dcQ8 += raw - (dcQ8 >> DC_SHIFT);
+    int16_t d = raw - (int16_t)(dcQ8 >> DC_SHIFT);
+    d = d < -512 ? -512 : d > 511 ? 511 : d;   // constrain()
+    sumSq += (uint32_t)((int32_t)d * d) - (uint32_t)((int32_t)ring[head] * ring[head]);
+    ring[head] = d;
+    head = (head + 1) & (RING - 1);
+    if (t >= nextFrame) {
+      nextFrame += FRAME;
+      Reading r = { t, (int)sqrt(sumSq / RING) };
+      out.push_back(r);
+    }
+  }
+  return out;
+}
+
+// The old loop(): average of 50 readings, then the frame and delay(200)
+std::vector<Reading> averaged(const Sound &s, double seconds) {
+  std::vector<Reading> out;
+  for (double t = 0; t + OLD_LOOP < seconds; t += OLD_LOOP) {
+    long sum = 0;
+    for (int i = 0; i < 50; i++) sum += adc(s, t + i * OLD_SAMPLE);
+    Reading r = { t + 50 * OLD_SAMPLE, (int)(sum / 50) };
+    out.push_back(r);
+  }
+  return out;
+}
+
+struct Stats {
+  double mean, spread;
+};
+
+Stats stats(const std::vector<Reading> &rs, double from) {
+  double n = 0, s1 = 0, s2 = 0;
+  for (const Reading &r : rs) {
+    if (r.t < from) continue;
+    n++;
+    s1 += r.level;
+    s2 += (double)r.level * r.level;
+  }
+  Stats st = { s1 / n, sqrt(fmax(0, s2 / n - (s1 / n) * (s1 / n))) };
+  return st;
+}
+
+// Seconds from the start of the sound until a reading is 90% of rms away from the quiet level
+double delay90(const std::vector<Reading> &rs, double start, double rms, int quiet) {
+  for (const Reading &r : rs) {
+    if (r.t >= start && abs(r.level - quiet) >= 0.9 * rms) return r.t - start;
+  }
+  return INFINITY;
+}
+
+// Share of the bursts that move a reading by QUIET_THRESHOLD or more from the quiet level
+double seen(const std::vector<Reading> &rs, const Sound &s, int quiet) {
+  uint32_t n = 0;
+  for (double b : s.bursts) {
+    for (const Reading &r : rs) {
+      if (r.t >= b && r.t < b + s.burstLen + 0.3 && abs(r.level - quiet) >= QUIET_THRESHOLD) { n++; break; }
+    }
+  }
+  return (double)n / s.bursts.size();
+}
+
+int main() {
+  const double HZ[5] = { 100, 250, 500, 1000, 2000 };
+  printf("60-count tone    sliding RMS (true 42.4)   old average\n");
+  for (double hz : HZ) {
+    Sound s = { 60, hz, 0, 0, {}, 0, 0 };
+    Stats a = stats(sliding(s, 10), 1), b = stats(averaged(s, 10), 1);
+    printf("%6.0f Hz        %6.1f +- %4.1f            %6.1f +- %4.1f\n", hz, a.mean, a.spread, b.mean, b.spread);
+    char what[48];
+    snprintf(what, sizeof(what), "sliding RMS of a %.0f Hz tone", hz);
+    double want = sqrt(60 * 60 / 2.0 + MIC_NOISE * MIC_NOISE);
+    expect(what, fabs(a.mean / want - 1) <= 0.05);
+  }
+  {
+    Sound s = { 0, 0, 40, 0, {}, 0, 0 };
+    Stats a = stats(sliding(s, 10), 1), b = stats(averaged(s, 10), 1);
+    printf("noise 40 RMS     %6.1f +- %4.1f            %6.1f +- %4.1f\n", a.mean, a.spread, b.mean, b.spread);
+    expect("sliding RMS of noise", fabs(a.mean / sqrt(40 * 40 + 1) - 1) <= 0.05);
+    expect("old average shows the bias, not the sound", fabs(b.mean - BIAS) < 3);
+  }
+
+  Sound quiet = { 0, 0, 0, 0, {}, 0, 0 };
+  Stats qa = stats(sliding(quiet, 10), 1), qb = stats(averaged(quiet, 10), 1);
+  printf("silence          %6.1f (%s)               %6.1f (%s)\n", qa.mean, qa.mean < QUIET_THRESHOLD ? "quiet" : "angry",
+         qb.mean, qb.mean < QUIET_THRESHOLD ? "quiet" : "angry");
+  expect("sliding RMS quiet in silence", qa.mean + 3 * qa.spread < QUIET_THRESHOLD);
+  expect("old average angry in silence", qb.mean >= QUIET_THRESHOLD);
+
+  Sound step = { 0, 0, 60, 5.0, {}, 0, 0 };
+  double da = delay90(sliding(step, 8), 5.0, 60, (int)qa.mean), db = delay90(averaged(step, 8), 5.0, 60, (int)qb.mean);
+  printf("step to 60 RMS   %4.0f ms                   %s\n", da * 1000, isinf(db) ? "never" : "shown");
+  expect("step shown within two frames", da <= 2 * FRAME + 0.001);
+
+  for (double len : { 0.010, 0.030 }) {
+    Sound b = { 0, 0, 0, 0, {}, len, 80 };
+    double t = 1;
+    while (t < 100) {
+      b.bursts.push_back(t);
+      t += uniform(0.5, 1.5);
+    }
+    double sa = seen(sliding(b, 101), b, (int)qa.mean), sb = seen(averaged(b, 101), b, (int)qb.mean);
+    printf("%2.0f ms bursts     %3.0f%% seen                %3.0f%% seen (%zu bursts)\n", len * 1000, sa * 100, sb * 100, b.bursts.size());
+    char what[48];
+    snprintf(what, sizeof(what), "sliding RMS sees more %.0f ms bursts", len * 1000);
+    expect(what, sa > sb);
+    if (len > 0.02) expect("sliding RMS sees 30 ms bursts", sa >= 0.95);
+  }
+
+  printf(ok ? "noisemeterrms ok\n" : "noisemeterrms FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+/* NoiseReplay.h - the Noise Meter's sampling and window loop over a recording (PC only)
+
+     noiseWindows(counts, [&](double seconds, const uint16_t *feat) { ... });
+
+   counts are mic samples in ADC counts around the bias at the sketch's
+   6250 Hz. As on the board: the ISR's DC follower and clipping, then
+   every 50 ms the newest 50 samples through windowFeatures() and
+   NoiseHistory (NoiseFeatures.h). Used by tests/NoiseTreeTest.cpp and
+   tools/NoiseTreeTrainer.cpp.
+*/
+
+#pragma once
+
+#include <math.h>
+#include <vector>
+#include "NoiseFeatures.h"
+
+const double NOISE_RATE = 6250;          // SAMPLE_RATE
+const uint8_t NOISE_WINDOW_SAMPLES = 50; // WINDOW_SAMPLES
+const int8_t NOISE_ZCR_HYST = 2;         // ZCR_HYST
+const uint32_t NOISE_QUIET_ENERGY = 625; // QUIET_THRESHOLD 25, squared
+
+template<class F>
+void noiseWindows(const std::vector<double> &counts, F onWindow, uint32_t quietEnergy = NOISE_QUIET_ENERGY) {
+  const uint8_t DC_SHIFT = 8;
+  int32_t dcQ8 = 512L << DC_SHIFT;
+  std::vector<int16_t> d;
+  NoiseHistory history = {};
+  uint16_t feat[F_COUNT];
+  double nextWindow = 0.05 * NOISE_RATE;
+  for (size_t i = 0; i < counts.size(); i++) {
+    long raw = lround(512 + counts[i]);
+    if (raw < 0) raw = 0;
+    if (raw > 1023) raw = 1023;
+    dcQ8 += raw - (dcQ8 >> DC_SHIFT);
+    int16_t v = raw - (int16_t)(dcQ8 >> DC_SHIFT);
+    d.push_back(v < -512 ? -512 : v > 511 ? 511 : v);
+    if (i + 1 < nextWindow) continue;
+    nextWindow += 0.05 * NOISE_RATE;
+
+    WindowFeatures w;
+    windowFeatures(&d[d.size() - NOISE_WINDOW_SAMPLES], NOISE_WINDOW_SAMPLES, NOISE_ZCR_HYST, w);
+    history.update(w, quietEnergy, feat);
+    onWindow(i / NOISE_RATE, (const uint16_t *)feat);
+  }
+}
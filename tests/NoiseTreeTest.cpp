@@ -0,0 +1,237 @@
+/* NoiseTreeTest.cpp - Noise Meter classifier on synthetic speech, bangs and hum
+
+     g++ -std=c++11 -I tests -I . tests/NoiseTreeTest.cpp -o tree && ./tree
+
+   The sketch's whole path is modelled (NoiseReplay.h): 6250 Hz ADC
+   samples around mid scale, the ISR's DC follower, a window of the newest
+   50 samples every 50 ms, NoiseHistory and noiseClassify(). Clips, made
+   up here with a fixed seed:
+
+     quiet   room noise and mains hum, 20 s
+     fan     steady loud broadband noise, 20 s
+     speech  phrases of 2..8 syllables (voiced, pitch 100..250 Hz, two
+             formants; one in five starts with a short fricative), pauses
+             of 0.4..1.5 s between phrases, 90 s
+     bangs   40 book drops / knocks (a decaying noise burst with a
+             resonance) 1..3 s apart in room noise
+
+   Per clip the windows of each class, the 'B' captures (a bang window
+   after a window that was no bang) and the angry-face windows are
+   counted, for NOISE_TREE and for the tree the sketch had before, whose
+   node 1 (loud < 10 -> bang) called the start of every phrase a bang.
+   NOISE_TREE has to keep 'B' captures in speech rare, still catch the
+   bangs a window sees, never turn the face angry on bangs, quiet or
+   fan, and turn it angry during speech (at least half as many windows
+   as it calls talk; the pauses between phrases hold it back).
+
+   With an argument the clips are also written as WAV files into that
+   directory (speech.wav, bangs.wav, quiet.wav, fan.wav) to try
+   tools/NoiseTreeTrainer.cpp on.
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "NoiseTree.h"
+#include "NoiseReplay.h"
+#include "Wav.h"
+
+const double RATE = NOISE_RATE;
+const uint8_t SPEECH_VOTES = 12;        // as in the sketch
+
+const TreeNode OLD_TREE[] = {
+  { F_ENERGY, 625, LEAF | C_SILENCE, 1 },
+  { F_LOUD,   10,  LEAF | C_IMPACT,  2 },
+  { F_CREST,  400, 3, LEAF | C_IMPACT },
+  { F_ONSETS, 2,   LEAF | C_SILENCE, 4 },
+  { F_ZCR,    18,  LEAF | C_SPEECH, LEAF | C_IMPACT },
+};
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+double uniform(double a, double b) { return a + (b - a) * (next() % 100000) / 100000.0; }
+double gauss() {
+  double s = 0;
+  for (int i = 0; i < 12; i++) s += (next() % 100000) / 100000.0;
+  return s - 6;
+}
+
+// Clips in ADC counts around the mic bias
+std::vector<double> room(double seconds) {
+  std::vector<double> s;
+  for (uint32_t i = 0; i < seconds * RATE; i++) s.push_back(3 * gauss() + 4 * sin(2 * M_PI * 50 * i / RATE));
+  return s;
+}
+
+std::vector<double> fan(double seconds) {
+  std::vector<double> s;
+  double lp = 0;
+  for (uint32_t i = 0; i < seconds * RATE; i++) {
+    lp += 0.3 * (gauss() - lp);
+    s.push_back(90 * lp);
+  }
+  return s;
+}
+
+// Two-pole resonator gain for a formant at f Hz
+double formant(double h, double f, double bw) {
+  double x = (h - f) / bw;
+  return 1 / sqrt(1 + x * x);
+}
+
+std::vector<double> speech(double seconds, std::vector<double> *phraseStarts) {
+  std::vector<double> s = room(seconds);
+  double t = 0.5;
+  while (t < seconds - 3) {
+    phraseStarts->push_back(t);
+    double pitch = uniform(100, 250);
+    double level = uniform(80, 250);
+    double f1 = uniform(400, 800), f2 = uniform(1100, 2000);
+    int syllables = 2 + next() % 7;
+    for (int k = 0; k < syllables; k++) {
+      double len = uniform(0.12, 0.3);
+      if (next() % 5 == 0) {   // fricative: quiet high hiss before the vowel
+        double flen = uniform(0.04, 0.08), prev = 0;
+        for (uint32_t i = 0; i < flen * RATE; i++) {
+          double n = gauss(), hp = n - prev;
+          prev = n;
+          size_t at = (size_t)(t * RATE) + i;
+          if (at < s.size()) s[at] += 0.15 * level * hp;
+        }
+        t += flen;
+      }
+      double phase = 0;
+      for (uint32_t i = 0; i < len * RATE; i++) {
+        double env = sin(M_PI * i / (len * RATE));
+        double f0 = pitch * (1 + 0.05 * sin(2 * M_PI * 3 * i / RATE));
+        phase += 2 * M_PI * f0 / RATE;
+        double v = 0, norm = 0;
+        for (int h = 1; h * f0 < RATE / 2; h++) {
+          double g = (formant(h * f0, f1, 120) + 0.6 * formant(h * f0, f2, 180)) / sqrt(h);
+          v += g * sin(h * phase);
+          norm += g * g;
+        }
+        size_t at = (size_t)(t * RATE) + i;
+        if (at < s.size()) s[at] += level * env * v / sqrt(2 * norm);
+      }
+      t += len + uniform(0.02, 0.08);
+    }
+    t += uniform(0.4, 1.5);
+  }
+  return s;
+}
+
+std::vector<double> bangs(int count, std::vector<double> *onsets) {
+  std::vector<double> s = room(count * 2.0 + 2);
+  double t = 1;
+  for (int k = 0; k < count; k++) {
+    onsets->push_back(t);
+    double amp = uniform(300, 500), tau = uniform(0.004, 0.015);
+    double ring = uniform(150, 900), ringTau = uniform(0.01, 0.04);
+    for (uint32_t i = 0; i < 0.25 * RATE; i++) {
+      double x = i / RATE;
+      size_t at = (size_t)(t * RATE) + i;
+      if (at >= s.size()) break;
+      s[at] += amp * exp(-x / tau) * gauss() / 2 + 0.4 * amp * exp(-x / ringTau) * sin(2 * M_PI * ring * x);
+    }
+    t += uniform(1, 3);
+  }
+  return s;
+}
+
+struct Result {
+  uint32_t windows, cls[C_COUNT], captures, angry;
+  std::vector<double> captureAt;   // seconds
+};
+
+// The sketch's window loop over a clip, classified with tree
+Result run(const std::vector<double> &clip, const TreeNode *tree) {
+  Result r = {};
+  uint32_t speechBits = 0;
+  uint8_t lastClass = C_SILENCE;
+  noiseWindows(clip, [&](double t, const uint16_t *feat) {
+    uint8_t prev = lastClass;
+    lastClass = noiseClassify(tree, feat);
+    speechBits = ((speechBits << 1) | (lastClass == C_SPEECH)) & ((1UL << NOISE_HISTORY) - 1);
+    r.windows++;
+    r.cls[lastClass]++;
+    if (lastClass == C_IMPACT && prev != C_IMPACT) {
+      r.captures++;
+      r.captureAt.push_back(t);
+    }
+    r.angry += countBits(speechBits) >= SPEECH_VOTES;
+  });
+  return r;
+}
+
+void print(const char *clip, const char *tree, const Result &r) {
+  printf("%-7s %-4s %4u windows: quiet %4u talk %4u bang %4u | 'B' captures %3u | angry %4u\n",
+         clip, tree, r.windows, r.cls[C_SILENCE], r.cls[C_SPEECH], r.cls[C_IMPACT], r.captures, r.angry);
+}
+
+// Events with a capture within 0.2 s after them
+uint32_t caught(const std::vector<double> &events, const Result &r) {
+  uint32_t n = 0;
+  for (double e : events) {
+    for (double c : r.captureAt) {
+      if (c >= e && c < e + 0.2) { n++; break; }
+    }
+  }
+  return n;
+}
+
+int main(int argc, char **argv) {
+  std::vector<double> phrases, knocks;
+  std::vector<double> quietClip = room(20), fanClip = fan(20);
+  std::vector<double> speechClip = speech(90, &phrases), bangClip = bangs(40, &knocks);
+
+  if (argc > 1) {
+    const std::vector<double> *clips[4] = { &speechClip, &bangClip, &quietClip, &fanClip };
+    const char *names[4] = { "speech", "bangs", "quiet", "fan" };
+    for (uint8_t k = 0; k < 4; k++) {
+      std::vector<double> s;
+      for (double v : *clips[k]) s.push_back(v / 512);
+      std::string path = std::string(argv[1]) + "/" + names[k] + ".wav";
+      if (!wavWrite(path.c_str(), (uint32_t)RATE, s)) printf("cannot write %s\n", path.c_str());
+    }
+  }
+
+  Result res[4][2];
+  const std::vector<double> *clips[4] = { &quietClip, &fanClip, &speechClip, &bangClip };
+  const char *names[4] = { "quiet", "fan", "speech", "bangs" };
+  for (uint8_t k = 0; k < 4; k++) {
+    res[k][0] = run(*clips[k], OLD_TREE);
+    res[k][1] = run(*clips[k], NOISE_TREE);
+    print(names[k], "old", res[k][0]);
+    print(names[k], "new", res[k][1]);
+  }
+  const Result &talkOld = res[2][0], &talk = res[2][1], &bangOld = res[3][0], &bang = res[3][1];
+  uint32_t phraseCapsOld = caught(phrases, talkOld), phraseCaps = caught(phrases, talk);
+  printf("%zu phrases: 'B' at the start of %u (old tree) / %u (NOISE_TREE)\n", phrases.size(), phraseCapsOld, phraseCaps);
+  printf("%zu bangs: caught %u (old tree) / %u (NOISE_TREE)\n", knocks.size(), caught(knocks, bangOld), caught(knocks, bang));
+
+  expect("'B' captures in speech rare", talk.captures * 10 <= phrases.size());
+  expect("speech windows not bangs", talk.cls[C_IMPACT] * 50 <= talk.cls[C_SPEECH]);
+  expect("bangs caught as before", caught(knocks, bang) >= caught(knocks, bangOld));
+  expect("angry during speech", talk.angry * 2 >= talk.cls[C_SPEECH] && talk.angry > 2 * talkOld.angry);
+  for (uint8_t k : { 0, 1, 3 }) expect("never angry without speech", res[k][1].angry == 0);
+  expect("quiet and fan never a bang", res[0][1].captures == 0 && res[1][1].captures == 0);
+
+  printf(ok ? "noisetree ok\n" : "noisetree FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+/* Packed10Test.cpp - Packed10.h round trips on a PC
+
+     g++ -std=c++11 -I tests -I . tests/Packed10Test.cpp -o p10 && ./p10
+
+   Runs the sketch-side check() (every 10-bit value through set/get,
+   Writer and unpack) for a few ring sizes, then what check() does not
+   cover: set() leaves the other 3 samples of its group alone, a Reader
+   or unpack() that starts in the middle wraps at N, and unpack() takes
+   the offset off. The cycle counts check() prints are meaningless here
+   (micros() just counts calls); only "ok" matters.
+*/
+
+#include <Arduino.h>
+#include "Packed10.h"
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+template<uint16_t N>
+void roundTrip(const char *name) {
+  Print out;
+  expect(name, Packed10<N>::check(out));
+  expect("check() prints ok", out.text.compare(0, 13, "# packed10 ok") == 0);
+}
+
+int main() {
+  roundTrip<4>("check N=4");
+  roundTrip<16>("check N=16");
+  roundTrip<128>("check N=128");
+  expect("128 samples in 160 bytes", Packed10<128>::BYTES == 160 && sizeof(Packed10<128>) == 160);
+
+  // neighbours: write one sample, the rest of the group keeps its value
+  Packed10<16> p;
+  for (uint16_t i = 0; i < 16; i++) p.set(i, 1023);
+  bool alone = true;
+  for (uint16_t i = 0; i < 16; i++) {
+    p.set(i, 0);
+    for (uint16_t j = 0; j < 16; j++) alone &= p.get(j) == (j == i ? 0 : 1023);
+    p.set(i, 1023);
+  }
+  expect("set() leaves the neighbours alone", alone);
+
+  // wrap: ring with the oldest sample at index 13, as in the Noise Meter
+  Packed10<16>::Writer w(p, 13);
+  for (uint16_t k = 0; k < 16; k++) w.put(100 + 50 * k);   // 13, 14, 15, 0, 1, ...
+  Packed10<16>::Reader r(p, 13);
+  bool inOrder = true;
+  for (uint16_t k = 0; k < 32; k++) inOrder &= r.next() == 100 + 50 * (k % 16);
+  expect("Reader wraps at N", inOrder);
+
+  int16_t s[10];
+  p.unpack(13 + 16 + 16, 10, s, 512);   // first index is taken modulo N
+  bool unpacked = true;
+  for (uint16_t k = 0; k < 10; k++) unpacked &= s[k] == 100 + 50 * (int16_t)k - 512;
+  expect("unpack() wraps and takes the offset off", unpacked);
+
+  printf(ok ? "packed10 ok\n" : "packed10 FAIL\n");
+  return ok ? 0 : 1;
+}
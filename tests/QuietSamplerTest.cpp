@@ -0,0 +1,208 @@
+/* QuietSamplerTest.cpp - quietWindow() against a model of the sleep modes
+
+     g++ -std=c++11 -I tests -I . tests/QuietSamplerTest.cpp -o quiet && ./quiet
+
+   The model counts CPU cycles. Timer1 only advances while the I/O clock
+   runs; ADC Noise Reduction sleep stops that clock for a conversion (1664
+   cycles) unless a pin change on RX wakes the CPU first (WAKE cycles after
+   the start bit). Serial lines arrive at 115200 baud at random times; a
+   byte is lost when the I/O clock was stopped for more than a quarter bit
+   during its frame (the USART samples each bit in its middle).
+
+   The Decibel Meter's quiet mode (windows of 600 samples at 5 kHz, a
+   couple of ms awake between windows) is run twice over the same input:
+   without the RX wake, as the sketches had it, and with it. With the wake
+   no byte may be lost, every window must get its samples, the duty cycle
+   must add up to the time spent, and sample intervals other than the
+   nominal 3200 cycles may only show up around a switch of the timing.
+*/
+
+#include <Arduino.h>
+#include <vector>
+#include "QuietSampler.h"
+
+const uint16_t PERIOD = 3200;             // ACQ_TIMER_TOP + 1 at 5 kHz
+const uint16_t CONV = 13 * 128;           // ACQ_CONV_TICKS
+const uint16_t NR_PERIOD = PERIOD - CONV; // ACQ_NR_TOP + 1
+const uint16_t AUTO_CONV = 1728;          // auto-triggered conversion: 13.5 ADC clocks
+const uint16_t WORK = 180;                // ISR + loop code per sample
+const uint16_t WAKE = 8;                  // pin change -> clock running again
+const double FRAME = 10 * 16e6 / 115200;  // start + 8 data + stop bits, in cycles
+const double TOLERANCE = FRAME / 40;      // a quarter bit
+const uint16_t WINDOW = 600;              // SAMPLE_WINDOW_MS 120 at 5 kHz
+const uint32_t GAP = 40000;               // awake between windows (2.5 ms)
+
+struct Interval { double from, to; };
+
+struct Model {
+  bool rxWake;                 // pin change wake + hold (the fix)
+  std::vector<double> frames;  // start bit times, sorted
+  size_t nextFrame = 0;        // first frame not reported by rxSeen() yet
+
+  double now = 0;
+  uint32_t count = 0;          // Timer1 ticks since the last trigger
+  uint16_t period = PERIOD;
+  bool pending = false;
+  double lastTrigger = 0;
+  uint16_t samples = 0;
+  std::vector<Interval> stopped;
+  std::vector<double> starts;  // conversion start times
+  uint32_t switches = 0;
+
+  // clock running: Timer1 counts and triggers
+  void run(double cycles) {
+    while (cycles > 0) {
+      double toTrigger = period - count;
+      if (cycles < toTrigger) {
+        count += (uint32_t)cycles;
+        now += cycles;
+        return;
+      }
+      now += toTrigger;
+      cycles -= toTrigger;
+      count = 0;
+      pending = true;
+      lastTrigger = now;
+    }
+  }
+
+  bool done() { return samples >= WINDOW; }
+  uint16_t sinceTrigger() {
+    run(WORK);
+    return count;
+  }
+  void idleUntilTrigger() {
+    if (!pending) run(period - count);
+  }
+  void convertAsleep() {
+    starts.push_back(now);
+    double end = now + CONV;
+    double wake = end;
+    if (rxWake && nextFrame < frames.size() && frames[nextFrame] <= now) {
+      run(CONV);       // pin change flag already set: converts with the clock on
+      pending = false;
+      samples++;
+      return;
+    }
+    if (rxWake) {
+      for (size_t f = nextFrame; f < frames.size() && frames[f] < end; f++) {
+        if (frames[f] >= now) { wake = frames[f] + WAKE < end ? frames[f] + WAKE : end; break; }
+      }
+    }
+    stopped.push_back({ now, wake });
+    now = wake;
+    run(end - wake);   // woken early: Timer1 runs for the rest of the conversion
+    pending = false;
+    samples++;
+  }
+  void convertAwake() {
+    starts.push_back(lastTrigger);
+    double end = lastTrigger + AUTO_CONV;
+    if (end > now) run(end - now);
+    pending = false;
+    samples++;
+  }
+  void nrTiming(bool nr) {
+    period = nr ? NR_PERIOD : PERIOD;
+    count = 0;
+    pending = false;
+    switches++;
+  }
+  bool rxSeen() {
+    bool seen = false;
+    while (nextFrame < frames.size() && frames[nextFrame] <= now) {
+      nextFrame++;
+      seen = true;
+    }
+    return rxWake && seen;
+  }
+};
+
+struct Result {
+  uint32_t lost, irregular, windows;
+  QuietStats st;
+  double spent;
+  uint32_t switches;
+};
+
+Result simulate(bool rxWake, const std::vector<double> &frames, uint32_t windows) {
+  Model m;
+  m.rxWake = rxWake;
+  m.frames = frames;
+  QuietStats st = {};
+  Result r = {};
+  for (uint32_t w = 0; w < windows; w++) {
+    m.samples = 0;
+    quietWindow(m, st, NR_PERIOD, PERIOD, CONV);
+    if (m.samples == WINDOW) r.windows++;
+    m.now += GAP;   // drawing and logging between windows, clock running
+  }
+
+  // bytes with the clock stopped for more than the tolerance during their frame
+  size_t k = 0;
+  for (double f : frames) {
+    while (k < m.stopped.size() && m.stopped[k].to <= f) k++;
+    double off = 0;
+    for (size_t j = k; j < m.stopped.size() && m.stopped[j].from < f + FRAME; j++) {
+      double a = m.stopped[j].from > f ? m.stopped[j].from : f;
+      double b = m.stopped[j].to < f + FRAME ? m.stopped[j].to : f + FRAME;
+      if (b > a) off += b - a;
+    }
+    if (off > TOLERANCE) r.lost++;
+  }
+
+  // sample intervals inside a window that are not the nominal period
+  for (size_t i = 1; i < m.starts.size(); i++) {
+    if (i % WINDOW == 0) continue;   // gap between windows
+    double d = m.starts[i] - m.starts[i - 1];
+    if (d < PERIOD - 1 || d > PERIOD + 1) r.irregular++;
+  }
+  r.st = st;
+  r.switches = m.switches;
+  r.spent = (double)windows * WINDOW * PERIOD;
+  return r;
+}
+
+int main() {
+  // serial input: lines of 2..7 bytes ("c\r\n", "94.5\r\n"), bytes back to
+  // back, 10..200 ms between lines; 200 windows of quiet sampling is ~24 s
+  const uint32_t WINDOWS = 200;
+  std::vector<double> frames;
+  uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+  auto next = [&rng]() { rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return rng; };
+  double t = 1e5;
+  double end = WINDOWS * (WINDOW * (double)PERIOD + GAP);
+  while (t < end) {
+    uint8_t len = 2 + next() % 6;
+    for (uint8_t b = 0; b < len; b++) frames.push_back(t + b * FRAME);
+    t += len * FRAME + 16e6 * (0.010 + (next() % 1900) / 10000.0);
+  }
+  while (!frames.empty() && frames.back() > end - 1e5) frames.pop_back();
+
+  bool ok = true;
+  Result before = simulate(false, frames, WINDOWS);
+  Result after = simulate(true, frames, WINDOWS);
+  for (const Result *r : { &before, &after }) {
+    double total = (double)r->st.awakeTicks + r->st.idleTicks + r->st.sleepTicks;
+    printf("%-10s lost %4u of %zu bytes, NR sleep %4.1f%%, awake samples %5u, timing switches %3u, irregular intervals %3u\n",
+           r == &before ? "no wake" : "RX wake", r->lost, frames.size(), 100.0 * r->st.sleepTicks / total,
+           r->st.rxSamples, r->switches - WINDOWS, r->irregular);
+  }
+
+  if (after.lost != 0) { printf("FAIL: bytes lost with the RX wake\n"); ok = false; }
+  if (before.lost < frames.size() / 2) { printf("FAIL: the model does not lose bytes without the wake\n"); ok = false; }
+  if (after.windows != WINDOWS || before.windows != WINDOWS) { printf("FAIL: short window\n"); ok = false; }
+  double total = (double)after.st.awakeTicks + after.st.idleTicks + after.st.sleepTicks;
+  if (total < 0.98 * after.spent || total > 1.02 * after.spent) {
+    printf("FAIL: duty cycle adds up to %.0f of %.0f ticks\n", total, after.spent);
+    ok = false;
+  }
+  if (after.irregular > 2 * (after.switches - WINDOWS) + 2 * WINDOWS / 100) {
+    printf("FAIL: %u irregular intervals for %u switches\n", after.irregular, after.switches - WINDOWS);
+    ok = false;
+  }
+  if (before.irregular != 0) { printf("FAIL: irregular intervals without RX wake\n"); ok = false; }
+
+  printf(ok ? "quiet ok\n" : "quiet FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+/* RhythmTest.cpp - false-accept and false-reject rates of Rhythm.h
+
+     g++ -std=c++11 -I tests -I . tests/RhythmTest.cpp -o rhythm && ./rhythm
+
+   Each test rhythm is a list of onsets in eighth notes. One clapped copy
+   is enrolled, then the test claps it again (genuine attempts) and claps
+   other rhythms against it (impostors):
+
+     FRR        genuine attempts rejected
+     FAR same   another rhythm from the list with the same clap count
+     FAR guess  random rhythm of whole eighths (1..4), same clap count
+     FAR random random intervals of 100..600 ms, same clap count
+
+   Impostors always get the clap count right: that is the best case for
+   an attacker who watched the owner clap without catching the rhythm.
+
+   Clapping is modelled, not recorded: each attempt has its own tempo
+   (eighth = 110..200 ms) and every onset gets Gaussian timing noise of
+   SIGMA ms (people clap with 10..30 ms of scatter; the LM393 adds well
+   under 1 ms). Onsets closer than the sketch's 80 ms refractory time
+   merge into one clap, as on the board. The random generator has a fixed
+   seed, so every run prints the same numbers.
+
+   Exit code 1 if the rates at 20 ms scatter get worse than the limits
+   below (a retuned tolerance that breaks the lock fails here). The limits
+   are what the tolerances in Rhythm.h reach now plus a little margin, not
+   a security rating: a 4-clap rhythm has few distinct versions, and for
+   an even one up to a third of the random guesses pass.
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include "Rhythm.h"
+
+const unsigned long REFRACTORY_US = 80000UL;   // CLAP_REFRACTORY_US in the sketch
+const int ATTEMPTS = 2000;                     // per rhythm and kind of attempt
+const double FRR_LIMIT = 0.12;                 // at SIGMA = 20 ms
+const double FAR_LIMIT = 0.09;
+
+struct Pattern {
+  const char *name;
+  uint8_t n;
+  uint8_t eighth[RHYTHM_MAX];
+};
+
+const Pattern PATTERNS[] = {
+  { "shave-haircut", 7, { 0, 2, 3, 4, 6, 10, 12 } },
+  { "gallop-7",      7, { 0, 1, 2, 4, 5, 6, 8 } },
+  { "steady-4",      4, { 0, 2, 4, 6 } },
+  { "short-long-4",  4, { 0, 1, 3, 4 } },
+  { "clave-5",       5, { 0, 3, 6, 10, 12 } },
+  { "knock-5",       5, { 0, 1, 2, 6, 7 } },
+  { "triplet-6",     6, { 0, 1, 2, 4, 5, 6 } },
+  { "syncope-6",     6, { 0, 3, 4, 7, 8, 10 } },
+  { "long-10",      10, { 0, 2, 3, 4, 6, 8, 9, 10, 12, 16 } },
+};
+const int PATTERN_COUNT = sizeof(PATTERNS) / sizeof(PATTERNS[0]);
+
+// xorshift32 with a fixed seed: the same attempts every run
+uint32_t rng = 2463534242UL;
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+double uniform() { return (next() + 0.5) / 4294967296.0; }
+double gaussian() { return sqrt(-2.0 * log(uniform())) * cos(2 * M_PI * uniform()); }
+
+// Onsets as the INT0 handler would store them; returns the clap count
+uint8_t clap(const double *ideal, uint8_t n, double sigmaMs, unsigned long *onsetUs) {
+  unsigned long start = 1000000UL + (next() & 0xFFFFF);   // any point in time
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    double t = ideal[i] + gaussian() * sigmaMs * 1000.0;
+    if (t < 0) t = 0;
+    unsigned long us = start + (unsigned long)t;
+    if (count > 0 && us < onsetUs[count - 1] + REFRACTORY_US) continue;   // merged
+    onsetUs[count++] = us;
+  }
+  return count;
+}
+
+// Pattern at a random tempo, in microseconds
+void play(const Pattern &p, double *ideal) {
+  double eighthUs = 110000.0 + uniform() * 90000.0;
+  for (uint8_t i = 0; i < p.n; i++) ideal[i] = p.eighth[i] * eighthUs;
+}
+
+bool attempt(const RhythmRecord &rec, const double *ideal, uint8_t n, double sigmaMs) {
+  unsigned long onsetUs[RHYTHM_MAX];
+  uint16_t ioi[RHYTHM_MAX - 1];
+  uint8_t got = clap(ideal, n, sigmaMs, onsetUs);
+  rhythmNormalise(onsetUs, got, ioi);
+  return rhythmMatches(rec, got, ioi);
+}
+
+struct Rate {
+  long hits = 0, tries = 0;
+  double pct() const { return tries ? 100.0 * hits / tries : 0.0; }
+};
+
+int main() {
+  const double SIGMAS[] = { 10, 20, 30, 40 };
+  bool ok = true;
+  printf("tolerance: sum %u, worst %u per mille; %d attempts per rhythm and kind\n",
+         RHYTHM_SUM_TOL, RHYTHM_WORST_TOL, ATTEMPTS);
+  printf("sigma    FRR   FAR same  FAR guess  FAR random\n");
+
+  for (double sigma : SIGMAS) {
+    Rate frr, farSame, farGuess, farRandom;
+    for (int e = 0; e < PATTERN_COUNT; e++) {
+      const Pattern &p = PATTERNS[e];
+      double ideal[RHYTHM_MAX];
+
+      // enrolment: one clapped copy, as with 'A' on the lock
+      RhythmRecord rec;
+      unsigned long onsetUs[RHYTHM_MAX];
+      do {
+        play(p, ideal);
+        rec.claps = clap(ideal, p.n, sigma, onsetUs);
+      } while (rec.claps != p.n);
+      rhythmNormalise(onsetUs, rec.claps, rec.ioi);
+
+      for (int a = 0; a < ATTEMPTS; a++) {
+        play(p, ideal);
+        frr.tries++;
+        frr.hits += !attempt(rec, ideal, p.n, sigma);
+
+        for (int o = 0; o < PATTERN_COUNT; o++) {
+          if (o == e || PATTERNS[o].n != p.n) continue;
+          play(PATTERNS[o], ideal);
+          farSame.tries++;
+          farSame.hits += attempt(rec, ideal, p.n, sigma);
+        }
+
+        double eighthUs = 110000.0 + uniform() * 90000.0;
+        ideal[0] = 0;
+        for (uint8_t i = 1; i < p.n; i++) ideal[i] = ideal[i - 1] + (1 + next() % 4) * eighthUs;
+        farGuess.tries++;
+        farGuess.hits += attempt(rec, ideal, p.n, sigma);
+
+        for (uint8_t i = 1; i < p.n; i++) ideal[i] = ideal[i - 1] + 100000.0 + uniform() * 500000.0;
+        farRandom.tries++;
+        farRandom.hits += attempt(rec, ideal, p.n, sigma);
+      }
+    }
+    printf("%3.0f ms  %5.2f%%  %6.2f%%  %7.2f%%  %8.2f%%\n", sigma,
+           frr.pct(), farSame.pct(), farGuess.pct(), farRandom.pct());
+    if (sigma == 20) {
+      ok &= frr.pct() <= FRR_LIMIT * 100;
+      ok &= farSame.pct() <= FAR_LIMIT * 100 && farGuess.pct() <= FAR_LIMIT * 100 &&
+            farRandom.pct() <= FAR_LIMIT * 100;
+    }
+  }
+  printf(ok ? "rhythm ok\n" : "rhythm FAIL: rates at 20 ms over the limits\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+/* SerialCalibrationTest.cpp - calibration over a pseudo-serial line, meter running
+
+     g++ -std=c++11 -I tests -I . tests/SerialCalibrationTest.cpp -o cal && ./cal
+
+   A model of the Decibel Meter's loop(): a pass every millisecond feeds
+   the bytes that arrived to the LineReader, takes a 100-sample chunk
+   every 20 ms into the Fast integrator (LevelMath.h) and the calibration,
+   and draws a frame every 100 ms. The pseudo-serial line delivers each
+   byte at the time it was "typed".
+
+   Session: 'c' at 1 s, 'w' (refused while measuring) and 'm' during the
+   measurement, a line that is too long, then the prompt is left waiting
+   for 30 s while the sound level steps up and down, and "94.5" is typed
+   a key every 250 ms. Every frame must come on time, the meter must
+   follow the level steps during the prompt, and the offset must come out
+   of the measured level. A second session cancels with "skip", after
+   which 'w' works again.
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include <deque>
+#include "LevelMath.h"
+#include "SerialCalibration.h"
+
+typedef MeterScale<6, 30, 120, 116, 70> Scale;
+typedef DecayTable<5000, 125> Fast;
+const uint32_t CAL_SAMPLES = 6000;   // 1.2 s at 5 kHz, as in the sketch
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// Bytes with the millisecond they arrive at
+struct PseudoSerial {
+  std::deque<std::pair<unsigned long, char> > q;
+  unsigned long now = 0;
+
+  void type(unsigned long t, const char *s, unsigned long keyMs = 0) {
+    for (; *s; s++, t += keyMs) q.push_back(std::make_pair(t, *s));
+  }
+  bool available() { return !q.empty() && q.front().first <= now; }
+  char read() {
+    char c = q.front().second;
+    q.pop_front();
+    return c;
+  }
+};
+
+struct Meter {
+  PseudoSerial serial;
+  LineReader<16> line = {};
+  Calibration cal = {};
+  uint32_t level = 0;
+  bool wfOn = false;
+  uint8_t weighting = 0;
+  uint16_t refused = 0, tooLong = 0, answers = 0;
+  float offset = NAN;
+  unsigned long lastFrame = 0, worstGap = 0;
+  uint32_t frames = 0;
+
+  void handleLine(const char *s) {
+    uint8_t route = cal.route(s);
+    if (route == CAL_ROUTE_ANSWER) {
+      cal.state = CAL_IDLE;
+      float spl;
+      answers++;
+      if (strcasecmp_P(s, PSTR("skip")) && calParseSpl(s, &spl)) offset = spl - log10Cdb<Scale>(cal.meanQ8()) / 100.0f;
+    } else if (route == CAL_ROUTE_CANCEL) {
+      cal.state = CAL_IDLE;
+    } else if (route == CAL_ROUTE_BUSY) {
+      refused++;
+    } else if (!strcmp(s, "c")) {
+      cal.start(CAL_SAMPLES);
+    } else if (!strcmp(s, "w")) {
+      wfOn = !wfOn;
+    } else if (!strcmp(s, "m")) {
+      weighting++;
+    }
+  }
+
+  // one loop() pass at time t; amplitude in ADC counts (sine)
+  void pass(unsigned long t, double amplitude) {
+    serial.now = t;
+    while (serial.available()) {
+      uint8_t r = line.feed(serial.read());
+      if (r == LINE_TOO_LONG) tooLong++;
+      if (r == LINE_READY) {
+        handleLine(line.buf);
+        break;
+      }
+    }
+    if (wfOn) return;   // the waterfall replaces the meter
+    if (t % 20 == 0) {
+      double ms = amplitude * amplitude / 2 * (0.95 + (next() % 1000) / 10000.0);
+      uint32_t msQ8 = (uint32_t)(ms * 256);
+      level = level ? levelStep(level, msQ8, decayFactor(Fast::data, 100)) : msQ8;
+      cal.feed(msQ8, 100, 0);
+    }
+    if (t - lastFrame >= 100) {
+      if (frames && t - lastFrame > worstGap) worstGap = t - lastFrame;
+      lastFrame = t;
+      frames++;
+    }
+  }
+
+  double db() const { return log10Cdb<Scale>(level) / 100.0; }
+};
+
+int main() {
+  Meter m;
+  m.serial.type(1000, "c\r\n");
+  m.serial.type(1500, "w\r\n");
+  m.serial.type(1600, "m\n");
+  m.serial.type(1800, "this line is far too long\r\n");
+  m.serial.type(32200, "94.5", 250);
+  m.serial.type(33200, "\r\n");
+
+  double db10 = 0, db20 = 0, db30 = 0;
+  unsigned long prompt = 0;
+  for (unsigned long t = 0; t < 36000; t++) {
+    double amplitude = t < 10000 ? 50 : t < 20000 ? 200 : 20;
+    m.pass(t, amplitude);
+    if (!prompt && m.cal.state == CAL_WAIT_SPL) prompt = t;
+    if (t == 9999) db10 = m.db();
+    if (t == 19999) db20 = m.db();
+    if (t == 29999) db30 = m.db();
+  }
+  double want = 94.5 - 10 * log10(50.0 * 50 / 2 * 256);
+  printf("prompt after %lu ms, %u frames in 36 s, worst frame gap %lu ms\n", prompt - 1000, m.frames, m.worstGap);
+  printf("level during the prompt: %.2f / %.2f / %.2f dB (input %.2f / %.2f / %.2f)\n",
+         db10, db20, db30, 10 * log10(50.0 * 50 * 128), 10 * log10(200.0 * 200 * 128), 10 * log10(20.0 * 20 * 128));
+  printf("offset %.2f dB (from the input %.2f), %u refused, %u too long\n", m.offset, want, m.refused, m.tooLong);
+
+  expect("prompt after the 1.2 s measurement", prompt - 1000 >= 1180 && prompt - 1000 <= 1220);
+  expect("a frame every 100 ms", m.frames >= 359 && m.worstGap <= 100);
+  expect("meter follows the level during the prompt",
+         fabs(db20 - 10 * log10(200.0 * 200 * 128)) < 0.5 && fabs(db30 - 10 * log10(20.0 * 20 * 128)) < 0.5);
+  expect("offset from the measured level", fabs(m.offset - want) < 0.3);
+  expect("'w' refused while measuring", m.refused == 1 && !m.wfOn);
+  expect("'m' still works while measuring", m.weighting == 1);
+  expect("too long line rejected", m.tooLong == 1);
+  expect("one answer", m.answers == 1 && m.cal.state == CAL_IDLE);
+
+  // "skip" cancels; the waterfall is allowed again afterwards
+  Meter s;
+  s.serial.type(500, " c \r\n");
+  s.serial.type(700, "SKIP\r\n");
+  s.serial.type(900, "w\r\n");
+  for (unsigned long t = 0; t < 3000; t++) s.pass(t, 50);
+  expect("skip cancels", s.cal.state == CAL_IDLE && s.answers == 0 && s.refused == 0 && isnan(s.offset));
+  expect("'w' after skip", s.wfOn);
+
+  printf(ok ? "calibration ok\n" : "calibration FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/* TelemetryTest.cpp - Telemetry.h number format, line format and pump()
+
+     g++ -std=c++11 -I tests -I . tests/TelemetryTest.cpp -o tlm && ./tlm
+
+   Checks the fixed-point text of telemetryFixed() (signs, leading zeros,
+   the 32-bit limits, TELEMETRY_NONE), whole log lines with and without
+   state names, times past 24.8 days, the " drop=N" note after a full
+   ring, and that pump() never hands Print more bytes than
+   availableForWrite() reported: the output pumped through a nearly full
+   transmit buffer must be the same text as through an empty one.
+*/
+
+#include <Arduino.h>
+#include "Telemetry.h"
+
+bool ok = true;
+
+void expect(const char *what, const std::string &got, const char *want) {
+  if (got != want) {
+    printf("FAIL %s: got \"%s\", want \"%s\"\n", what, got.c_str(), want);
+    ok = false;
+  }
+}
+
+std::string fixed(int32_t v, uint8_t dec) {
+  char buf[24];
+  char *end = telemetryFixed(buf, v, dec);
+  if (end != buf + strlen(buf)) {
+    printf("FAIL telemetryFixed(%ld, %u) returned the wrong end\n", (long)v, dec);
+    ok = false;
+  }
+  return buf;
+}
+
+const TelemetryField FIELDS[] PROGMEM = { { "vrms", 3 }, { "dbfs", 2 } };
+const char STATES[2][6] PROGMEM = { "quiet", "loud" };
+
+// Pump until the ring is empty, at most room bytes per call
+std::string drain(Telemetry<2, 4> &tlm, int room) {
+  Print out;
+  for (int pass = 0; pass < 1000; pass++) {
+    out.room = room;
+    tlm.pump(out);
+    if (out.room < 0) {
+      printf("FAIL pump() wrote %d bytes with room for %d\n", room - out.room, room);
+      ok = false;
+    }
+  }
+  return out.text;
+}
+
+int main() {
+  expect("zero", fixed(0, 0), "0");
+  expect("zero 3", fixed(0, 3), "0.000");
+  expect("small", fixed(5, 3), "0.005");
+  expect("small negative", fixed(-5, 3), "-0.005");
+  expect("vrms", fixed(12345, 3), "12.345");
+  expect("dbfs", fixed(-3012, 2), "-30.12");
+  expect("round", fixed(100, 2), "1.00");
+  expect("integer", fixed(7, 0), "7");
+  expect("max", fixed(INT32_MAX, 0), "2147483647");
+  expect("min + 1", fixed(INT32_MIN + 1, 3), "-2147483.647");
+  expect("none", fixed(TELEMETRY_NONE, 2), "-");
+
+  int32_t v[2] = { 123, -3012 };
+  Telemetry<2, 4> plain(FIELDS);
+  plain.push(12345, 1, v);
+  expect("line", drain(plain, 64), "t=12.345 vrms=0.123 dbfs=-30.12 st=1\r\n");
+
+  Telemetry<2, 4> named(FIELDS, STATES[0], sizeof(STATES[0]));
+  v[1] = TELEMETRY_NONE;
+  named.push(5, 0, v);
+  named.push(6, 1, v);
+  expect("names", drain(named, 64),
+         "t=0.005 vrms=0.123 dbfs=- st=quiet\r\n"
+         "t=0.006 vrms=0.123 dbfs=- st=loud\r\n");
+
+  // ring of 4 holds 3 records: the 4th and 5th are dropped
+  Telemetry<2, 4> full(FIELDS);
+  bool pushed = true;
+  for (int32_t i = 0; i < 5; i++) {
+    v[0] = i;
+    v[1] = -i;
+    pushed = full.push(1000 * i, 0, v);
+  }
+  if (pushed || full.lost() != 2) {
+    printf("FAIL full ring: push() %s, lost() = %u\n", pushed ? "accepted" : "refused", full.lost());
+    ok = false;
+  }
+  expect("drop", drain(full, 64),
+         "t=0.000 vrms=0.000 dbfs=0.00 st=0 drop=2\r\n"
+         "t=1.000 vrms=0.001 dbfs=-0.01 st=0\r\n"
+         "t=2.000 vrms=0.002 dbfs=-0.02 st=0\r\n");
+
+  // the same record through a full transmit buffer, then 1, 3 and 64 bytes at a time
+  const int ROOMS[] = { 1, 3, 64 };
+  for (int room : ROOMS) {
+    Telemetry<2, 4> t(FIELDS);
+    v[0] = INT32_MIN + 1;
+    v[1] = INT32_MAX;
+    t.push(4294967295UL, 255, v);
+    Print blocked;
+    blocked.room = 0;
+    t.pump(blocked);
+    expect("room 0", blocked.text, "");
+    expect("small room", drain(t, room),
+           "t=4294967.295 vrms=-2147483.647 dbfs=21474836.47 st=255\r\n");
+  }
+
+  printf(ok ? "telemetry ok\n" : "telemetry FAIL\n");
+  return ok ? 0 : 1;
+}
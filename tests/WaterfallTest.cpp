@@ -0,0 +1,206 @@
+/* WaterfallTest.cpp - WAV replay through Waterfall.h, screens dumped as images
+
+     g++ -std=c++11 -I tests -I . tests/WaterfallTest.cpp -o wf && ./wf [file.wav]
+
+   Without an argument a test recording is written first
+   ($TMPDIR/waterfall.wav, 16-bit mono at 5 kHz, 8 s): 625 Hz, 1875 Hz,
+   white noise, silence, 2 s each. Any 8/16-bit PCM WAV can be given
+   instead; it is resampled to the sketch's 5 kHz (linear) and the first
+   channel turned into 8-bit ADC samples around mid scale, as the ADC ISR
+   feeds the ring.
+
+   Blocks of 32 samples go to WfSpectrum::block(), and a row is added
+   whenever 100 ms of audio have passed since the last one, like wfStep()
+   does with millis(). A model of the panel RAM receives sendPageBuffer()
+   and startLine(). After every row the screen as the panel shows it is
+   written to $TMPDIR/waterfall/frame_NNNN.pbm.
+
+   Reported: rows per second of audio (the sustained row rate, has to be
+   10), blocks per row, and the host time per block, rows included (the
+   board's time is what 't' prints). Checked on the test recording: each
+   tone is brightest in its own bin (the dither lights about level/16 of
+   the pixels, the window leaks into the next bin on each side), the
+   noise lights all bins, the silence none, and every screen is the
+   previous one moved down a row with the new row on top.
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "Waterfall.h"
+#include "Wav.h"
+
+const uint32_t RATE = 5000;      // SAMPLE_RATE in the sketch
+const uint32_t ROW_SAMPLES = RATE / 10;   // WF_ROW_MS 100
+
+bool ok = true;
+
+void expect(const char *what, bool good) {
+  if (!good) {
+    printf("FAIL: %s\n", what);
+    ok = false;
+  }
+}
+
+uint32_t rng = 2463534242UL;   // xorshift32, fixed seed
+uint32_t next() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+void writeTestWav(const char *path) {
+  std::vector<double> s;
+  for (uint32_t i = 0; i < 8 * RATE; i++) {
+    double t = (double)i / RATE, v = 0;
+    if (i < 2 * RATE) v = 0.3 * sin(2 * M_PI * 625 * t);
+    else if (i < 4 * RATE) v = 0.3 * sin(2 * M_PI * 1875 * t);
+    else if (i < 6 * RATE) v = 0.3 * ((next() % 2001) / 1000.0 - 1);
+    s.push_back(v);
+  }
+  wavWrite(path, RATE, s);
+}
+
+// Panel RAM and start line, as the SSD1306 keeps them
+struct Panel {
+  uint8_t ram[8][128] = {};
+  uint8_t start = 0;
+
+  void sendPageBuffer(uint8_t page, const uint8_t *buf) { memcpy(ram[page], buf, 128); }
+  bool pixel(uint8_t x, uint8_t row) const {
+    uint8_t line = (start + row) % WF_LINES;
+    return ram[line >> 3][x] >> (line & 7) & 1;
+  }
+  void dump(const std::string &path) const {
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) return;
+    fprintf(f, "P4\n128 64\n");
+    for (uint8_t y = 0; y < 64; y++) {
+      for (uint8_t x = 0; x < 128; x += 8) {
+        uint8_t b = 0;
+        for (uint8_t k = 0; k < 8; k++) b |= pixel(x + k, y) << (7 - k);
+        fputc(b, f);
+      }
+    }
+    fclose(f);
+  }
+};
+
+// Lit pixels of the newest rows per bin
+void binDensity(const Panel &p, uint8_t rows, double *density) {
+  for (uint8_t b = 0; b < WF_BINS; b++) {
+    uint16_t lit = 0;
+    for (uint8_t y = 0; y < rows; y++) {
+      for (uint8_t x = 0; x < WF_BIN_PX; x++) lit += p.pixel(b * WF_BIN_PX + x, y);
+    }
+    density[b] = lit / (double)(rows * WF_BIN_PX);
+  }
+}
+
+int main(int argc, char **argv) {
+  std::string dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+  std::string wav = argc > 1 ? argv[1] : dir + "/waterfall.wav";
+  if (argc < 2) writeTestWav(wav.c_str());
+  std::vector<double> audio = wavRead(wav.c_str(), RATE);
+  if (audio.size() < ROW_SAMPLES) {
+    printf("cannot read %s\nwaterfall FAIL\n", wav.c_str());
+    return 1;
+  }
+  std::string frames = dir + "/waterfall";
+  mkdir(frames.c_str(), 0755);
+
+  WfSpectrum spectrum = {};
+  WfScroll scroll;
+  scroll.reset();
+  Panel panel;
+  uint8_t page[128] = {};
+  std::vector<std::vector<uint8_t> > tops;   // each row as drawn, for the scroll check
+  double density[4][WF_BINS];
+  uint32_t blocks = 0, badScroll = 0;
+  std::vector<uint8_t> samples;              // every block, for the timing below
+
+  uint8_t block[WF_N];
+  for (size_t i = 0; i < audio.size(); i++) {
+    long raw = lround(512 + audio[i] * 511);       // 10-bit ADC count
+    if (raw < 0) raw = 0;
+    if (raw > 1023) raw = 1023;
+    block[i % WF_N] = raw >> 2;
+    samples.push_back(raw >> 2);
+    if (i % WF_N == WF_N - 1) {
+      spectrum.block(block);
+      blocks++;
+    }
+    if ((i + 1) % ROW_SAMPLES == 0 && spectrum.blocks) {
+      uint8_t pg = scroll.add(spectrum, page);
+      panel.sendPageBuffer(pg, page);
+      panel.start = scroll.line;
+
+      std::vector<uint8_t> top(128);
+      for (uint8_t x = 0; x < 128; x++) top[x] = panel.pixel(x, 0);
+      tops.push_back(top);
+      for (size_t r = 1; r < tops.size() && r < 57; r++) {   // 57+: page being refilled
+        for (uint8_t x = 0; x < 128; x++) badScroll += panel.pixel(x, r) != tops[tops.size() - 1 - r][x];
+      }
+      char name[32];
+      snprintf(name, sizeof(name), "/frame_%04u.pbm", scroll.rows);
+      panel.dump(frames + name);
+      if (scroll.rows % 20 == 0 && scroll.rows <= 80) binDensity(panel, 15, density[scroll.rows / 20 - 1]);
+    }
+  }
+
+  double seconds = (double)audio.size() / RATE;
+  printf("%s: %.1f s, %u rows = %.2f rows/s, %.1f blocks per row, %u screens in %s/\n",
+         wav.c_str(), seconds, scroll.rows, scroll.rows / seconds, (double)blocks / scroll.rows,
+         scroll.rows, frames.c_str());
+
+  // host time: the whole recording again, 20 times, without images
+  clock_t c = clock();
+  WfScroll timed;
+  timed.reset();
+  for (uint8_t rep = 0; rep < 20; rep++) {
+    for (size_t i = 0; i + WF_N <= samples.size(); i += WF_N) {
+      spectrum.block(&samples[i]);
+      if (spectrum.blocks == 16) timed.add(spectrum, page);
+    }
+  }
+  double us = 1e6 * (clock() - c) / CLOCKS_PER_SEC;
+  printf("host: %.2f us per block with the rows, %.0fx real time\n",
+         us / (20.0 * blocks), 20 * seconds * 1e6 / us);
+  expect("10 rows per second of audio", fabs(scroll.rows / seconds - 10) < 0.2);
+  expect("every screen is the last one moved down a row", badScroll == 0);
+
+  if (argc < 2) {
+    const char *part[4] = { "625 Hz", "1875 Hz", "noise", "silence" };
+    for (uint8_t k = 0; k < 4; k++) {
+      printf("%-8s", part[k]);
+      for (uint8_t b = 0; b < WF_BINS; b++) printf(" %3.0f", 100 * density[k][b]);
+      printf("  (%% lit per bin, newest 15 rows)\n");
+    }
+    // a tone peaks in its bin; the Hann window spreads it over the next
+    // bin on each side, further away stays dark
+    bool tone[2] = { true, true };
+    const uint8_t toneBin[2] = { 3, 11 };
+    for (uint8_t k = 0; k < 2; k++) {
+      for (uint8_t b = 0; b < WF_BINS; b++) {
+        if (b == toneBin[k]) tone[k] &= density[k][b] > 0.6;
+        else if (abs(b - toneBin[k]) == 1) tone[k] &= density[k][b] < density[k][toneBin[k]];
+        else tone[k] &= density[k][b] < 0.15;
+      }
+    }
+    uint8_t lit[4] = {};
+    for (uint8_t k = 0; k < 4; k++) {
+      for (uint8_t b = 0; b < WF_BINS; b++) lit[k] += density[k][b] > 0.2;
+    }
+    expect("625 Hz in bin 4", tone[0]);
+    expect("1875 Hz in bin 12", tone[1]);
+    expect("noise in every bin", lit[2] == WF_BINS);
+    expect("silence is black", lit[3] == 0);
+  }
+
+  printf(ok ? "waterfall ok\n" : "waterfall FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+/* Wav.h - read and write PCM WAV files for the host tests and tools (PC only)
+
+     std::vector<double> s = wavRead("in.wav", 5000);   // first channel, -1..1, at 5 kHz
+     wavWrite("out.wav", 5000, s);                       // 16-bit mono
+
+   wavRead() takes 8- and 16-bit PCM at any rate and resamples linearly;
+   it returns nothing if the file is not such a WAV.
+*/
+
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+inline uint32_t wavGet(const uint8_t *p, uint8_t n) {
+  uint32_t v = 0;
+  for (uint8_t i = 0; i < n; i++) v |= (uint32_t)p[i] << (8 * i);
+  return v;
+}
+
+inline std::vector<double> wavRead(const char *path, uint32_t rateOut) {
+  std::vector<double> out;
+  FILE *f = fopen(path, "rb");
+  if (!f) return out;
+  std::vector<uint8_t> d;
+  int c;
+  while ((c = fgetc(f)) != EOF) d.push_back(c);
+  fclose(f);
+  if (d.size() < 12 || memcmp(&d[0], "RIFF", 4) || memcmp(&d[8], "WAVE", 4)) return out;
+
+  uint16_t channels = 0, bits = 0;
+  uint32_t rate = 0;
+  std::vector<double> in;
+  for (size_t p = 12; p + 8 <= d.size();) {
+    uint32_t len = wavGet(&d[p + 4], 4);
+    const uint8_t *body = &d[p + 8];
+    if (!memcmp(&d[p], "fmt ", 4) && len >= 16) {
+      if (wavGet(body, 2) != 1) return out;   // PCM only
+      channels = wavGet(body + 2, 2);
+      rate = wavGet(body + 4, 4);
+      bits = wavGet(body + 14, 2);
+    } else if (!memcmp(&d[p], "data", 4) && channels && (bits == 8 || bits == 16)) {
+      uint32_t frame = channels * bits / 8;
+      if (p + 8 + len > d.size()) len = d.size() - p - 8;
+      for (uint32_t i = 0; i + frame <= len; i += frame) {
+        if (bits == 8) in.push_back((body[i] - 128) / 128.0);
+        else in.push_back((int16_t)wavGet(body + i, 2) / 32768.0);
+      }
+    }
+    p += 8 + len + (len & 1);
+  }
+  if (!rate) return out;
+  for (double t = 0; t < in.size(); t += (double)rate / rateOut) {
+    size_t i = (size_t)t;
+    out.push_back(i + 1 < in.size() ? in[i] + (in[i + 1] - in[i]) * (t - i) : in[i]);
+  }
+  return out;
+}
+
+inline void wavPut(FILE *f, uint32_t v, uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) fputc((v >> (8 * i)) & 0xFF, f);
+}
+
+// 16-bit mono; samples clipped to -1..1. false if the file cannot be written.
+inline bool wavWrite(const char *path, uint32_t rate, const std::vector<double> &s) {
+  FILE *f = fopen(path, "wb");
+  if (!f) return false;
+  fwrite("RIFF", 1, 4, f);
+  wavPut(f, 36 + 2 * s.size(), 4);
+  fwrite("WAVEfmt ", 1, 8, f);
+  wavPut(f, 16, 4);
+  wavPut(f, 1, 2);          // PCM
+  wavPut(f, 1, 2);          // mono
+  wavPut(f, rate, 4);
+  wavPut(f, rate * 2, 4);
+  wavPut(f, 2, 2);
+  wavPut(f, 16, 2);
+  fwrite("data", 1, 4, f);
+  wavPut(f, 2 * s.size(), 4);
+  for (double v : s) {
+    if (v > 1) v = 1;
+    if (v < -1) v = -1;
+    wavPut(f, (uint16_t)(int16_t)lround(v * 32767), 2);
+  }
+  fclose(f);
+  return true;
+}
@@ -0,0 +1,24 @@
+/* avr/wdt.h - the watchdog for host tests
+
+   wdt_enable() throws WatchdogReset: the reset it leads to ends the run,
+   and the test boots the sketch again. hostWdtOn() tells whether the
+   watchdog is still on (as after a watchdog reset, until wdt_disable()).
+*/
+
+#pragma once
+
+#define WDTO_15MS 0
+
+struct WatchdogReset {};
+
+inline bool &hostWdtOn() {
+  static bool on = false;
+  return on;
+}
+
+inline void wdt_disable() { hostWdtOn() = false; }
+
+inline void wdt_enable(int) {
+  hostWdtOn() = true;
+  throw WatchdogReset();
+}
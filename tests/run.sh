@@ -0,0 +1,12 @@
+#!/bin/sh
+# Build and run the host tests of the header-only helpers (no board needed).
+# Run from the repository root:  sh tests/run.sh
+# -O2: InputTraceTest plays hours of board time loop pass by loop pass.
+set -e
+out=${TMPDIR:-/tmp}
+for t in tests/*Test.cpp; do
+  name=$(basename "$t" .cpp)
+  g++ -std=c++11 -O2 -Wall -Wextra -I tests -I . "$t" -o "$out/$name"
+  echo "== $name"
+  "$out/$name"
+done
@@ -0,0 +1,52 @@
+/* CaptureToWav.cpp - Noise Meter event captures from a Serial log to WAV files
+
+     g++ -std=c++11 -O2 -I tests -I . tools/CaptureToWav.cpp -o cap2wav
+     ./cap2wav serial.txt [directory]
+
+   serial.txt is what the Serial Monitor (or any terminal log) got from
+   P2.2.1: CSV lines with the #CAP / #D / #END frames in between. Each
+   complete capture is written as cap<n><why>.wav (e.g. cap3B.wav: the
+   third capture, set off by a bang), 16-bit mono at the capture rate,
+   +-512 ADC counts = full scale. Printed per capture: why, length, where
+   the trigger is (sample and ms from the start, so a WAV editor can jump
+   there) and the loudest sample; incomplete captures (a line lost or
+   garbled) are listed and skipped.
+*/
+
+#include <string>
+#include "CaptureDump.h"
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    printf("usage: cap2wav serial.txt [directory]\n");
+    return 2;
+  }
+  FILE *f = fopen(argv[1], "r");
+  if (!f) {
+    printf("cannot read %s\n", argv[1]);
+    return 2;
+  }
+  std::vector<Capture> caps = captureParse(f);
+  fclose(f);
+  std::string dir = argc > 2 ? std::string(argv[2]) + "/" : "";
+
+  unsigned written = 0;
+  for (const Capture &c : caps) {
+    if (!c.complete) {
+      printf("#%u %c: incomplete (%zu of %u bytes or wrong sum), skipped\n", c.n, c.why, c.bytes.size(), c.samples);
+      continue;
+    }
+    int peak = 0;
+    for (int v : c.counts) if (abs(v) > abs(peak)) peak = v;
+    std::string path = dir + "cap" + std::to_string(c.n) + c.why + ".wav";
+    if (!captureWav(path.c_str(), c)) {
+      printf("cannot write %s\n", path.c_str());
+      return 1;
+    }
+    written++;
+    printf("#%u %c: %u samples at %u Hz, trigger at %u (%.1f ms), peak %d counts -> %s\n", c.n, c.why,
+           c.samples, c.rate, c.trigger, 1000.0 * c.trigger / c.rate, peak, path.c_str());
+  }
+  printf("%u of %zu captures written\n", written, caps.size());
+  return 0;
+}
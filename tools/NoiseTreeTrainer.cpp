@@ -0,0 +1,250 @@
+/* NoiseTreeTrainer.cpp - grow the Noise Meter's decision tree from labelled recordings
+
+     g++ -std=c++11 -O2 -I tests -I . tools/NoiseTreeTrainer.cpp -o train
+     ./train [-d depth] [-g gain] talk=lesson.wav bang=books.wav quiet=empty.wav talk=log.csv ...
+
+   Each argument is a class (quiet, talk or bang, as the sketch names
+   them) and a recording of only that kind of noise:
+
+     .wav  any 8/16-bit PCM WAV; resampled to 6250 Hz and replayed through
+           the sketch's sampling and window code (tests/NoiseReplay.h),
+           full scale = +-512 ADC counts times the gain (-g, default 1)
+     .csv  lines the sketch printed on Serial (features, then its class;
+           the class column is ignored)
+
+   Windows below the quiet energy are labelled quiet whatever the file
+   says (the pauses in a speech recording are not speech), except a
+   window right after a bang (burst feature set). In a bang recording
+   only those burst windows are bangs; the loud window before them is
+   left out, since on its own it looks like the first window of a word.
+
+   The tree is grown greedily (CART, Gini impurity, classes weighted so
+   each counts the same however many windows it has, integer thresholds
+   halfway between neighbouring values, at most -d levels, default 4),
+   then nodes whose two sides give the same class are merged. Printed:
+   the confusion matrix on the training windows and the table for
+   NoiseTree.h, each node with its windows per class in a comment.
+*/
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "NoiseTree.h"
+#include "NoiseReplay.h"
+#include "Wav.h"
+
+const char *const CLASS_NAMES[C_COUNT] = { "quiet", "talk", "bang" };
+const char *const FEATURE_NAMES[F_COUNT] = { "F_ENERGY", "F_ZCR", "F_CREST", "F_ONSETS", "F_LOUD", "F_BURST" };
+
+struct Sample {
+  uint16_t f[F_COUNT];
+  uint8_t cls;
+};
+
+struct Node {
+  bool leaf;
+  uint8_t cls, feature;
+  uint16_t threshold;
+  int below, above;
+  double count[C_COUNT];
+};
+
+std::vector<Sample> samples;
+std::vector<Node> nodes;
+double weight[C_COUNT];
+uint8_t maxDepth = 4;
+const double MIN_LEAF = 3;      // weighted windows on each side of a split
+
+void add(const uint16_t *feat, uint8_t cls) {
+  Sample s;
+  memcpy(s.f, feat, sizeof(s.f));
+  s.cls = cls;
+  if (feat[F_ENERGY] < NOISE_QUIET_ENERGY && !feat[F_BURST]) s.cls = C_SILENCE;
+  else if (cls == C_IMPACT && !feat[F_BURST]) return;   // the loud window itself: could be a word starting
+  samples.push_back(s);
+}
+
+bool load(const char *arg, double gain) {
+  const char *eq = strchr(arg, '=');
+  if (!eq) return false;
+  std::string label(arg, eq - arg), path(eq + 1);
+  uint8_t cls = C_COUNT;
+  for (uint8_t c = 0; c < C_COUNT; c++) if (label == CLASS_NAMES[c]) cls = c;
+  if (cls == C_COUNT) return false;
+
+  size_t before = samples.size();
+  if (path.size() > 4 && path.compare(path.size() - 4, 4, ".csv") == 0) {
+    FILE *f = fopen(path.c_str(), "r");
+    if (!f) return false;
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+      uint16_t feat[F_COUNT];
+      char *p = line;
+      uint8_t k = 0;
+      for (; k < F_COUNT; k++) {
+        char *end;
+        long v = strtol(p, &end, 10);
+        if (end == p || *end != ',') break;
+        feat[k] = (uint16_t)v;
+        p = end + 1;
+      }
+      if (k == F_COUNT) add(feat, cls);   // other Serial lines (#CAP ...) are skipped
+    }
+    fclose(f);
+  } else {
+    std::vector<double> s = wavRead(path.c_str(), (uint32_t)NOISE_RATE);
+    if (s.empty()) return false;
+    for (double &v : s) v *= 512 * gain;
+    noiseWindows(s, [&](double, const uint16_t *feat) { add(feat, cls); });
+  }
+  printf("// %-5s %s: %zu windows\n", CLASS_NAMES[cls], path.c_str(), samples.size() - before);
+  return true;
+}
+
+double gini(const double *c) {
+  double n = 0, sq = 0;
+  for (uint8_t k = 0; k < C_COUNT; k++) n += c[k];
+  if (n <= 0) return 0;
+  for (uint8_t k = 0; k < C_COUNT; k++) sq += (c[k] / n) * (c[k] / n);
+  return n * (1 - sq);
+}
+
+uint8_t majority(const double *c) {
+  uint8_t best = 0;
+  for (uint8_t k = 1; k < C_COUNT; k++) if (c[k] > c[best]) best = k;
+  return best;
+}
+
+int grow(std::vector<int> &idx, uint8_t depth) {
+  Node n = {};
+  for (int i : idx) n.count[samples[i].cls] += weight[samples[i].cls];
+  n.leaf = true;
+  n.cls = majority(n.count);
+  int me = nodes.size();
+  nodes.push_back(n);
+
+  double impurity = gini(n.count), best = impurity - 1e-9;
+  uint8_t bestF = 0;
+  uint16_t bestT = 0;
+  if (depth < maxDepth && impurity > 0) {
+    for (uint8_t f = 0; f < F_COUNT; f++) {
+      std::sort(idx.begin(), idx.end(), [f](int a, int b) { return samples[a].f[f] < samples[b].f[f]; });
+      double below[C_COUNT] = {}, above[C_COUNT];
+      memcpy(above, n.count, sizeof(above));
+      for (size_t j = 0; j + 1 < idx.size(); j++) {
+        const Sample &s = samples[idx[j]];
+        below[s.cls] += weight[s.cls];
+        above[s.cls] -= weight[s.cls];
+        uint16_t v = s.f[f], w = samples[idx[j + 1]].f[f];
+        if (v == w) continue;
+        double nb = 0, na = 0;
+        for (uint8_t k = 0; k < C_COUNT; k++) { nb += below[k]; na += above[k]; }
+        if (nb < MIN_LEAF || na < MIN_LEAF) continue;
+        double g = gini(below) + gini(above);
+        if (g < best) {
+          best = g;
+          bestF = f;
+          bestT = v + (w - v + 1) / 2;   // v < t <= w
+        }
+      }
+    }
+  }
+  if (best >= impurity - 1e-9) return me;
+
+  std::vector<int> lo, hi;
+  for (int i : idx) (samples[i].f[bestF] < bestT ? lo : hi).push_back(i);
+  int b = grow(lo, depth + 1);
+  int a = grow(hi, depth + 1);
+  Node &m = nodes[me];
+  if (nodes[b].leaf && nodes[a].leaf && nodes[b].cls == nodes[a].cls) return me;   // same answer both ways
+  m.leaf = false;
+  m.feature = bestF;
+  m.threshold = bestT;
+  m.below = b;
+  m.above = a;
+  return me;
+}
+
+uint8_t predict(const Sample &s) {
+  int n = 0;
+  while (!nodes[n].leaf) n = s.f[nodes[n].feature] < nodes[n].threshold ? nodes[n].below : nodes[n].above;
+  return nodes[n].cls;
+}
+
+// Inner nodes get table rows in pre-order; leaves become LEAF | class
+void number(int n, std::vector<int> &order) {
+  if (nodes[n].leaf) return;
+  order.push_back(n);
+  number(nodes[n].below, order);
+  number(nodes[n].above, order);
+}
+
+std::string ref(int n, const std::vector<int> &order) {
+  if (nodes[n].leaf) return std::string("LEAF | ") + (nodes[n].cls == C_SILENCE ? "C_SILENCE" : nodes[n].cls == C_SPEECH ? "C_SPEECH" : "C_IMPACT");
+  return std::to_string(std::find(order.begin(), order.end(), n) - order.begin());
+}
+
+int main(int argc, char **argv) {
+  double gain = 1;
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i += 2) {
+    if (i + 1 >= argc) break;
+    if (!strcmp(argv[i], "-d")) maxDepth = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "-g")) gain = atof(argv[i + 1]);
+  }
+  if (i >= argc) {
+    printf("usage: train [-d depth] [-g gain] quiet|talk|bang=file.wav|file.csv ...\n");
+    return 2;
+  }
+  for (; i < argc; i++) {
+    if (!load(argv[i], gain)) {
+      printf("cannot use %s (class=file.wav or class=file.csv)\n", argv[i]);
+      return 2;
+    }
+  }
+
+  double per[C_COUNT] = {};
+  for (const Sample &s : samples) per[s.cls]++;
+  uint8_t present = 0;
+  for (uint8_t k = 0; k < C_COUNT; k++) present += per[k] > 0;
+  for (uint8_t k = 0; k < C_COUNT; k++) weight[k] = per[k] ? samples.size() / (present * per[k]) : 0;
+
+  std::vector<int> idx(samples.size());
+  for (size_t j = 0; j < idx.size(); j++) idx[j] = j;
+  grow(idx, 0);
+
+  uint32_t confusion[C_COUNT][C_COUNT] = {}, right = 0;
+  for (const Sample &s : samples) {
+    uint8_t p = predict(s);
+    confusion[s.cls][p]++;
+    right += p == s.cls;
+  }
+  printf("// %zu windows, %.1f%% right. Rows: labelled, columns: classified\n",
+         samples.size(), 100.0 * right / samples.size());
+  for (uint8_t k = 0; k < C_COUNT; k++) {
+    printf("//   %-5s", CLASS_NAMES[k]);
+    for (uint8_t c = 0; c < C_COUNT; c++) printf(" %7u", confusion[k][c]);
+    printf("\n");
+  }
+
+  std::vector<int> order;
+  number(0, order);
+  if (order.empty()) {
+    printf("// one class everywhere: %s\n", CLASS_NAMES[nodes[0].cls]);
+    return 0;
+  }
+  printf("const TreeNode NOISE_TREE[] PROGMEM = {\n");
+  for (size_t k = 0; k < order.size(); k++) {
+    const Node &n = nodes[order[k]];
+    char row[96];
+    snprintf(row, sizeof(row), "  { %s, %u, %s, %s },", FEATURE_NAMES[n.feature], n.threshold,
+             ref(n.below, order).c_str(), ref(n.above, order).c_str());
+    double raw[C_COUNT];
+    for (uint8_t c = 0; c < C_COUNT; c++) raw[c] = weight[c] ? n.count[c] / weight[c] : 0;
+    printf("%-62s // %zu: quiet/talk/bang %.0f/%.0f/%.0f\n", row, k, raw[0], raw[1], raw[2]);
+  }
+  printf("};\n");
+  return 0;
+}
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""ram_report.py - static RAM of a sketch by symbol, and strings left in RAM
+
+    python3 tools/ram_report.py sketch.ino.elf [--top 20] [--strict]
+
+The .elf is in the build folder of a verbose compile (File > Preferences >
+Show verbose output, the path is in the last lines). Uses avr-nm, avr-objdump
+and avr-objcopy from the PATH (they come with the Arduino AVR core, in
+hardware/tools/avr/bin); --prefix picks other binutils, e.g. --prefix ''
+for an ELF built on the PC.
+
+Printed:
+  - .data and .bss size and what is left of the 2048 bytes for heap
+    (SSD1306 framebuffer, String) and stack
+  - the largest .data/.bss symbols
+  - text found in .data: every string literal there is copied from flash
+    into RAM at start-up. Print it with F("..."), keep tables in PROGMEM.
+
+With --strict the exit status is 1 when .data holds any such text, so a
+build script can stop on it.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+SRAM = 2048
+MIN_TEXT = 4          # printable characters before the NUL
+
+
+def run(cmd):
+    return subprocess.run(cmd, check=True, stdout=subprocess.PIPE,
+                          universal_newlines=True).stdout
+
+
+def sections(prefix, elf):
+    """{name: (address, size)} from objdump -h"""
+    out = {}
+    for line in run([prefix + "objdump", "-h", elf]).splitlines():
+        f = line.split()
+        if len(f) >= 4 and f[0].isdigit() and f[1] in (".data", ".bss"):
+            out[f[1]] = (int(f[3], 16), int(f[2], 16))
+    return out
+
+
+def symbols(prefix, elf):
+    """[(address, size, section, name)] of the RAM globals, from nm -S"""
+    out = []
+    for line in run([prefix + "nm", "-C", "-S", "--size-sort", elf]).splitlines():
+        f = line.split(None, 3)
+        if len(f) == 4 and f[2] in "dDbB":
+            sec = ".data" if f[2] in "dD" else ".bss"
+            out.append((int(f[0], 16), int(f[1], 16), sec, f[3]))
+    return out
+
+
+def data_bytes(prefix, elf):
+    fd, path = tempfile.mkstemp(suffix=".bin")
+    os.close(fd)
+    try:
+        run([prefix + "objcopy", "-O", "binary", "-j", ".data", elf, path])
+        with open(path, "rb") as f:
+            return f.read()
+    finally:
+        os.remove(path)
+
+
+def texts(data, base):
+    """(address, text) for runs of printable bytes ended by a NUL"""
+    found, start = [], None
+    for i, b in enumerate(data):
+        if 32 <= b < 127:
+            if start is None:
+                start = i
+        else:
+            if start is not None and b == 0 and i - start >= MIN_TEXT:
+                found.append((base + start, data[start:i].decode("ascii")))
+            start = None
+    return found
+
+
+def main():
+    ap = argparse.ArgumentParser(description="static RAM by symbol, strings in .data")
+    ap.add_argument("elf")
+    ap.add_argument("--prefix", default="avr-", help="binutils prefix (default avr-)")
+    ap.add_argument("--top", type=int, default=20, help="symbols to list (default 20)")
+    ap.add_argument("--strict", action="store_true", help="exit 1 if .data holds text")
+    a = ap.parse_args()
+
+    try:
+        secs = sections(a.prefix, a.elf)
+        syms = symbols(a.prefix, a.elf)
+        data = data_bytes(a.prefix, a.elf) if ".data" in secs else b""
+    except OSError as e:
+        print("cannot run %s: %s (AVR binutils on the PATH? see --prefix)" % (e.filename, e.strerror))
+        return 2
+    except subprocess.CalledProcessError as e:
+        print("%s failed on %s" % (e.cmd[0], a.elf))
+        return 2
+
+    data_size = secs.get(".data", (0, 0))[1]
+    bss_size = secs.get(".bss", (0, 0))[1]
+    print("%s: .data %d + .bss %d = %d bytes, %d of %d left for heap and stack"
+          % (a.elf, data_size, bss_size, data_size + bss_size,
+             SRAM - data_size - bss_size, SRAM))
+
+    print("\nlargest RAM globals:")
+    print("  bytes  section  symbol")
+    for addr, size, sec, name in sorted(syms, key=lambda s: -s[1])[:a.top]:
+        print("  %5d  %-7s  %s" % (size, sec, name))
+
+    found = texts(data, secs.get(".data", (0, 0))[0])
+    print("\ntext in .data (%d strings, %d bytes of RAM):"
+          % (len(found), sum(len(t) + 1 for _, t in found)))
+    for addr, text in found:
+        owner = next((s[3] for s in syms if s[0] <= addr < s[0] + s[1]), "string literal")
+        print("  0x%06x  %-20s  \"%s\"" % (addr, owner, text))
+    if found:
+        print("  -> F(\"...\") in print()/println(), PROGMEM for tables")
+    return 1 if a.strict and found else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())